@@ -1,8 +1,19 @@
 #pragma once
 #include "Backend/Gfx_VulkanCore.h"
 
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <functional>
+
 VK_DEFINE_HANDLE(VmaAllocation)
 VK_DEFINE_HANDLE(VmaAllocator)
+VK_DEFINE_HANDLE(VmaPool)
+VK_DEFINE_HANDLE(VmaVirtualBlock)
+VK_DEFINE_NON_DISPATCHABLE_HANDLE(VmaVirtualAllocation)
 
 struct VmaAllocationInfo;
 enum VmaMemoryUsage;
@@ -12,6 +23,87 @@ namespace SmolEngine
 	class Gfx_VulkanDevice;
 	class Gfx_VulkanInstance;
 
+	enum class MemoryCategory : uint32_t
+	{
+		Buffer,
+		Image,
+		AccelStructure,
+		Staging, // host visible buffers used only for transfers, uploads and readbacks
+
+		Count
+	};
+
+	enum class MemoryPool : uint32_t
+	{
+		Default, // VMA's own heaps
+		Transient, // single block linear pool for short lived staging and scratch buffers, overflow goes to the default pool
+		Geometry, // long lived vertex and index buffers, kept apart so transient allocations don't fragment their blocks; uses VMA's default TLSF algorithm, VMA 3 has no buddy allocator
+		Dedicated, // own device memory, for large render targets
+
+		Count
+	};
+
+	struct MemoryCategoryStats
+	{
+		uint64_t myCount = 0;
+		uint64_t myBytes = 0;
+	};
+
+	struct MemoryHeapStats
+	{
+		VkDeviceSize myUsage = 0; // by the whole process when VK_EXT_memory_budget is enabled, otherwise estimated from our blocks
+		VkDeviceSize myBudget = 0;
+		VkDeviceSize myBlockBytes = 0; // device memory allocated by VMA
+		VkDeviceSize myAllocationBytes = 0; // part of the blocks used by live allocations
+		uint32_t myBlockCount = 0;
+		uint32_t myAllocationCount = 0;
+		bool myIsDeviceLocal = false;
+	};
+
+	struct DefragmentStats
+	{
+		uint64_t myBytesMoved = 0;
+		uint64_t myBytesFreed = 0;
+		uint32_t myAllocationsMoved = 0;
+		uint32_t myBlocksFreed = 0;
+		uint32_t myPasses = 0;
+		float myTime = 0.0f; // ms
+		bool myIsComplete = false; // false if the budget ran out before VMA had nothing left to move
+	};
+
+	// Old to new VkBuffer and VkImageView handles of the resources moved by one defragmentation pass
+	struct MemoryRelocations
+	{
+		template<typename T>
+		void Add(T oldHandle, T newHandle) { myHandles[(uint64_t)oldHandle] = (uint64_t)newHandle; }
+
+		// Returns the handle unchanged if it was not moved
+		template<typename T>
+		T Find(T handle) const
+		{
+			const auto& it = myHandles.find((uint64_t)handle);
+			return it != myHandles.end() ? (T)it->second : handle;
+		}
+
+		bool IsEmpty() const { return myHandles.empty(); }
+
+		std::unordered_map<uint64_t, uint64_t> myHandles;
+	};
+
+	// Owner of an allocation that Defragment may move
+	class Gfx_Relocatable
+	{
+	public:
+		virtual ~Gfx_Relocatable() = default;
+
+		// Creates a resource like the current one bound to dstAllocation and records the copy, false leaves the allocation in place
+		virtual bool CmdRelocate(VkCommandBuffer cmd, VmaAllocation dstAllocation) = 0;
+		// The copy has finished, destroys the old resource and adds its replaced handles
+		virtual void OnRelocated(MemoryRelocations& relocations) = 0;
+	};
+
+	using RelocationListener = std::function<void(const MemoryRelocations&)>;
+
 	class Gfx_VulkanAllocator
 	{
 	public:
@@ -20,8 +112,8 @@ namespace SmolEngine
 
 		void Init(Gfx_VulkanDevice* device, Gfx_VulkanInstance* instance);
 
-		static VmaAllocation AllocBuffer(VkBufferCreateInfo ci, VmaMemoryUsage usage, VkBuffer& outBuffer);
-		static VmaAllocation AllocImage(VkImageCreateInfo ci, VmaMemoryUsage usage, VkImage& outImage);
+		static VmaAllocation AllocBuffer(VkBufferCreateInfo ci, VmaMemoryUsage usage, VkBuffer& outBuffer, MemoryPool pool = MemoryPool::Default);
+		static VmaAllocation AllocImage(VkImageCreateInfo ci, VmaMemoryUsage usage, VkImage& outImage, MemoryPool pool = MemoryPool::Default);
 
 		static void AllocFree(VmaAllocation allocation);
 		static void FreeImage(VkImage image, VmaAllocation allocation);
@@ -29,12 +121,52 @@ namespace SmolEngine
 
 		static void UnmapMemory(VmaAllocation allocation);
 		static uint8_t* MapMemory(VmaAllocation allocation);
+		// Makes GPU writes visible to the host on memory that is not host coherent
+		static void InvalidateMemory(VmaAllocation allocation);
+		// Makes host writes visible to the GPU on memory that is not host coherent, VMA skips coherent memory
+		static void FlushMemory(VmaAllocation allocation, VkDeviceSize offset = 0, VkDeviceSize size = VK_WHOLE_SIZE);
 
 		static void GetAllocInfo(VmaAllocation allocation, VmaAllocationInfo*& outInfo);
+		// Summed over device local heaps
+		static void GetDeviceLocalBudget(VkDeviceSize& outUsage, VkDeviceSize& outBudget);
+		// Buffers and images allocated since startup
+		static uint64_t GetAllocationCount();
+
+		// Live allocations, kept in every configuration
+		static MemoryCategoryStats GetCategoryStats(MemoryCategory category);
+		static uint64_t GetTotalAllocatedBytes();
+		// One entry per memory heap, cheap enough to call every frame
+		static void GetHeapStats(std::vector<MemoryHeapStats>& outHeaps);
+		// VMA's JSON description of every heap, type and block, detailed also lists each allocation
+		static std::string BuildStatsString(bool detailed = false);
+		static bool DumpStats(const std::string& filePath, bool detailed = false);
+
+		// Compacts the default and geometry pools for at most budgetMs. Call at a frame boundary, between SwapBuffers and BeginFrame:
+		// it waits for the device to go idle, copies on its own submission and patches every handle before returning
+		static DefragmentStats Defragment(float budgetMs);
+		// Only registered allocations are moved, the others stay where they are
+		static void RegisterRelocatable(VmaAllocation allocation, Gfx_Relocatable* owner);
+		static void UnregisterRelocatable(VmaAllocation allocation);
+		// Binds a resource created by Gfx_Relocatable::CmdRelocate to the destination of the move
+		static VkResult BindBuffer(VmaAllocation allocation, VkBuffer buffer);
+		static VkResult BindImage(VmaAllocation allocation, VkImage image);
+		// Called after each pass to rewrite anything that copied the moved handles
+		static uint32_t AddRelocationListener(const RelocationListener& listener);
+		static void RemoveRelocationListener(uint32_t id);
 
 		static Gfx_VulkanAllocator* s_Instance;
 
 		VmaAllocator m_Allocator;
-		uint64_t m_TotalAllocatedBytes;
+		std::atomic<uint64_t> m_AllocationCount;
+		std::atomic<uint64_t> m_CategoryCount[static_cast<uint32_t>(MemoryCategory::Count)];
+		std::atomic<uint64_t> m_CategoryBytes[static_cast<uint32_t>(MemoryCategory::Count)];
+		// Custom pools are created on first use, one per pool class and memory type
+		std::unordered_map<uint64_t, uint32_t> m_MemoryTypes;
+		std::unordered_map<uint64_t, VmaPool> m_Pools;
+		std::mutex m_PoolMutex;
+		std::unordered_map<VmaAllocation, Gfx_Relocatable*> m_Relocatables;
+		std::map<uint32_t, RelocationListener> m_RelocationListeners;
+		uint32_t m_NextListener;
+		std::mutex m_RelocationMutex;
 	};
 }
\ No newline at end of file
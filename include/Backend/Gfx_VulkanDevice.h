@@ -29,7 +29,8 @@ namespace SmolEngine
 
 		Gfx_VulkanDevice();
 
-		void Create(const Gfx_VulkanInstance* instance);			
+		// Headless devices don't require VK_KHR_swapchain
+		void Create(const Gfx_VulkanInstance* instance, bool headless = false);			
 
 		uint32_t GetMemoryTypeIndex(uint32_t typeBits, VkMemoryPropertyFlags memFlags) const;
 		const VkPhysicalDeviceMemoryProperties* GetMemoryProperties() const;
@@ -38,8 +39,15 @@ namespace SmolEngine
 		const VkPhysicalDevice GetPhysicalDevice() const;
 		const VkDevice GetLogicalDevice() const;
 		const QueueFamilyIndices& GetQueueFamilyIndices() const;
+		const std::vector<VkQueueFamilyProperties>& GetQueueFamilyProperties() const;
 		const VkQueue GetQueue(QueueFamilyFlags flag) const;
 		bool GetRaytracingSupport() const;
+		bool GetShaderModuleIdentifierSupport() const;
+		bool GetBindlessSupport() const;
+		bool GetPushDescriptorSupport() const;
+		bool GetDescriptorBufferSupport() const;
+		bool GetMemoryBudgetSupport() const;
+		bool IsExtensionEnabled(const char* name) const;
 
 		PFN_vkGetBufferDeviceAddressKHR vkGetBufferDeviceAddressKHR;
 		PFN_vkCreateAccelerationStructureKHR vkCreateAccelerationStructureKHR;
@@ -51,16 +59,28 @@ namespace SmolEngine
 		PFN_vkGetRayTracingShaderGroupHandlesKHR vkGetRayTracingShaderGroupHandlesKHR;
 		PFN_vkCreateRayTracingPipelinesKHR vkCreateRayTracingPipelinesKHR;
 		PFN_vkCmdTraceRaysKHR vkCmdTraceRaysKHR;
+		PFN_vkGetShaderModuleCreateInfoIdentifierEXT vkGetShaderModuleCreateInfoIdentifierEXT = nullptr;
+		PFN_vkCmdPushDescriptorSetKHR vkCmdPushDescriptorSetKHR = nullptr;
+		PFN_vkGetDescriptorSetLayoutSizeEXT vkGetDescriptorSetLayoutSizeEXT = nullptr;
+		PFN_vkGetDescriptorSetLayoutBindingOffsetEXT vkGetDescriptorSetLayoutBindingOffsetEXT = nullptr;
+		PFN_vkGetDescriptorEXT vkGetDescriptorEXT = nullptr;
+		PFN_vkCmdBindDescriptorBuffersEXT vkCmdBindDescriptorBuffersEXT = nullptr;
+		PFN_vkCmdSetDescriptorBufferOffsetsEXT vkCmdSetDescriptorBufferOffsetsEXT = nullptr;
 
 		VkPhysicalDeviceRayTracingPipelinePropertiesKHR  rayTracingPipelineProperties{};
 		VkPhysicalDeviceAccelerationStructureFeaturesKHR accelerationStructureFeatures{};
+		VkPhysicalDeviceDescriptorIndexingProperties descriptorIndexingProperties{};
+		VkPhysicalDeviceDescriptorIndexingFeatures supportedDescriptorIndexingFeatures{};
+		VkPhysicalDeviceDescriptorBufferPropertiesEXT descriptorBufferProperties{};
+		VkPhysicalDevicePushDescriptorPropertiesKHR pushDescriptorProperties{};
 
 	private:											 
 		bool HasRequiredExtensions(const VkPhysicalDevice& device, const std::vector<const char*>& extensionsList);
 		QueueFamilyIndices GetQueueFamilyIndices(int flags);
 
 		void SetupLogicalDevice();
-		void SetupPhysicalDevice(const Gfx_VulkanInstance* instance);
+		void SetupPhysicalDevice(const Gfx_VulkanInstance* instance, bool headless);
+		void SetupOptionalExtensions();
 		void SelectDevice(VkPhysicalDevice device);
 		void GetFuncPtrs();
 
@@ -77,5 +97,10 @@ namespace SmolEngine
 		std::vector<VkQueueFamilyProperties>  m_QueueFamilyProperties;
 		std::vector<const char*> m_ExtensionsList;
 		bool m_RayTracingEnabled;
+		bool m_ShaderModuleIdentifierEnabled;
+		bool m_BindlessEnabled;
+		bool m_PushDescriptorEnabled;
+		bool m_DescriptorBufferEnabled;
+		bool m_MemoryBudgetEnabled;
 	};
 }
\ No newline at end of file
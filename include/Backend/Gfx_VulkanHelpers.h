@@ -2,6 +2,8 @@
 #include "Common/Gfx_Helpers.h"
 #include "Backend/Gfx_VulkanCore.h"
 
+#include <vector>
+
 namespace SmolEngine
 {
 	class Gfx_CmdBuffer;
@@ -45,6 +47,11 @@ namespace SmolEngine
 			VkCommandBuffer cmdbuffer,  VkImageSubresourceRange* pRange = nullptr);
 
 		static void CopyDataToImage(class Gfx_PixelStorage* storage, void* data, VkImageLayout layout);
+		// Records the copy of mip 0 from a staging buffer, mip generation and the transition to layout
+		static void CmdCopyBufferToImage(VkCommandBuffer cmd, class Gfx_PixelStorage* storage, VkBuffer buffer, VkDeviceSize offset, VkImageLayout layout);
+		// Uploads precomputed mips and layers as they are, used for compressed images
+		static void CopyRegionsToImage(class Gfx_PixelStorage* storage, const void* data, size_t size, const std::vector<VkBufferImageCopy>& regions, VkImageLayout layout);
+		static void CmdCopyRegionsToImage(VkCommandBuffer cmd, class Gfx_PixelStorage* storage, VkBuffer buffer, const std::vector<VkBufferImageCopy>& regions, VkImageLayout layout);
 		static void InitializeImageResource(class Gfx_PixelStorage* storage, VkImageLayout layout);
 		static void CopyPixelStorageToSwapchain(uint32_t width, uint32_t height, Gfx_CmdBuffer* cmd, Gfx_PixelStorage* storage);
 		static bool IsFormatIsFilterable(VkFormat format, VkImageTiling tiling);
@@ -53,11 +60,14 @@ namespace SmolEngine
 			VkImageLayout newImageLayout, VkPipelineStageFlags srcStageMask, VkPipelineStageFlags dstStageMask, 
 			VkImageSubresourceRange subresourceRange);
 
-		static void GenerateMipMaps(VkCommandBuffer cmd, class Gfx_PixelStorage* storage, VkImageSubresourceRange& range);
+		// Blit chain from mip 0, every level must be in TRANSFER_DST_OPTIMAL and ends in TRANSFER_SRC_OPTIMAL
+		static void GenerateMipMaps(VkCommandBuffer cmd, class Gfx_PixelStorage* storage);
 
 		static void CreateVkRenderPass(FramebufferCreateDesc* fbDesc, VkRenderPass& outVkPass);
 
 		static void SetImageLayout(const ImageLayoutTransitionDesc& desc);
 		static void ExecuteCmdBuffer(Gfx_CmdBuffer* cmd);
+		// Does not wait, the caller owns the fence and keeps the command buffer alive until it is signaled
+		static void SubmitCmdBuffer(Gfx_CmdBuffer* cmd, VkFence fence);
 	};
 }
\ No newline at end of file
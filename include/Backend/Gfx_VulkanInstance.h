@@ -9,7 +9,8 @@ namespace SmolEngine
 		Gfx_VulkanInstance();
 		~Gfx_VulkanInstance();
 
-		void Create();
+		// Headless instances enable no surface extensions
+		void Create(bool headless = false);
 		const VkInstance GetInstance() const;
 
 	private:
@@ -14,7 +14,8 @@ namespace SmolEngine
 	public:
 		Gfx_VulkanSemaphore();
 
-		void Create(const Gfx_VulkanDevice* device);
+		// One fence per frame in flight
+		void Create(const Gfx_VulkanDevice* device, uint32_t framesInFlight);
 		static void CreateVkSemaphore(VkSemaphore& outSemapthore);
 
 		// Getters
@@ -53,6 +53,7 @@ namespace SmolEngine
 		const VkFormat& GetDepthFormat() const;
 		const Buffer& GetCurrentBuffer() const;
 		uint32_t GetCurrentBufferIndex() const;
+		uint32_t GetImageCount() const;
 		uint32_t& GetCurrentBufferIndexRef();
 		uint32_t GetHeight() const;
 		uint32_t GetWidth() const;
@@ -0,0 +1,83 @@
+#pragma once
+#include "Backend/Gfx_VulkanCore.h"
+#include "Backend/Gfx_VulkanAllocator.h"
+#include "Common/Gfx_DescriptorBuffer.h"
+
+#include <vector>
+#include <mutex>
+
+namespace SmolEngine
+{
+	class Gfx_PixelStorage;
+	class Gfx_Sampler;
+	class Gfx_Buffer;
+
+	static constexpr uint32_t s_InvalidBindlessIndex = UINT32_MAX;
+
+	enum class BindlessType : uint32_t
+	{
+		Texture,       // binding 0, sampler2D[]
+		StorageImage,  // binding 1, image2D[]
+		StorageBuffer, // binding 2, buffer[]
+
+		Count
+	};
+
+	// Global update-after-bind descriptor set, resources are addressed by an index passed through push constants
+	class Gfx_BindlessHeap
+	{
+	public:
+		Gfx_BindlessHeap();
+
+		void Create();
+		void Free();
+		void BeginFrame();
+		bool IsGood() const;
+
+		uint32_t RegisterTexture(Gfx_PixelStorage* storage, Gfx_Sampler* sampler);
+		uint32_t RegisterStorageImage(Gfx_PixelStorage* storage);
+		uint32_t RegisterBuffer(Gfx_Buffer* buffer);
+
+		void UpdateTexture(uint32_t index, Gfx_PixelStorage* storage, Gfx_Sampler* sampler);
+		void UpdateStorageImage(uint32_t index, Gfx_PixelStorage* storage);
+		void UpdateBuffer(uint32_t index, Gfx_Buffer* buffer);
+		void Release(BindlessType type, uint32_t index);
+		// Rewrites the slots whose buffer or image view was moved by Gfx_VulkanAllocator::Defragment
+		void OnRelocated(const MemoryRelocations& relocations);
+
+		uint32_t GetCapacity(BindlessType type) const;
+		VkDescriptorSetLayout GetLayout() const { return m_Layout; }
+		VkDescriptorSet GetSet() const { return m_Set; }
+		VkDeviceSize GetBufferOffset() const { return m_BufferRegion.myOffset; }
+
+	private:
+		struct RetiredIndex
+		{
+			uint32_t myIndex;
+			uint64_t myFrame;
+		};
+
+		struct HandleList
+		{
+			std::vector<uint32_t> myFree;
+			std::vector<RetiredIndex> myRetired;
+			// Last write per slot, kept to patch handles after defragmentation
+			std::vector<VkDescriptorImageInfo> myImages;
+			std::vector<VkDescriptorBufferInfo> myBuffers;
+			uint32_t myNext = 0;
+			uint32_t myCapacity = 0;
+		};
+
+		uint32_t AllocateIndex(BindlessType type);
+		void Write(BindlessType type, uint32_t index, const VkDescriptorImageInfo* imageInfo, const VkDescriptorBufferInfo* bufferInfo);
+
+		std::mutex m_Mutex;
+		HandleList m_Handles[static_cast<uint32_t>(BindlessType::Count)];
+		VkDeviceSize m_BindingOffsets[static_cast<uint32_t>(BindlessType::Count)];
+		DescriptorBufferRegion m_BufferRegion;
+		VkDescriptorPool m_Pool;
+		VkDescriptorSetLayout m_Layout;
+		VkDescriptorSet m_Set;
+		uint64_t m_FrameCount;
+	};
+}
@@ -4,6 +4,8 @@
 
 namespace SmolEngine
 {
+	class Gfx_BufferArena;
+
 	struct BufferCreateDesc
 	{
 		enum class CreateFlags
@@ -21,11 +23,15 @@ namespace SmolEngine
 		VkBufferUsageFlags myBufferUsage;
 		VkSharingMode mySharingMode;
 		VmaMemoryUsage myMemUsage;
+		MemoryPool myPool;
+		// Default and Static buffers that fit become views into the arena's buffer, see GetOffset
+		Gfx_BufferArena* myArena;
 		CreateFlags myFlags;
 	};
 
-	class Gfx_Buffer
+	class Gfx_Buffer : public Gfx_Relocatable
 	{
+		friend class Gfx_BufferArena;
 	public:
 		Gfx_Buffer();
 		~Gfx_Buffer();
@@ -40,20 +46,39 @@ namespace SmolEngine
 		bool IsGood() const;
 		size_t GetSize() const;
 		VkBuffer GetRawBuffer() const;
+		// Start of this buffer in GetRawBuffer, non zero for arena views
 		size_t GetOffset() const;
 		VkBufferView GetVkBufferView() const;
 		VmaAllocation GetVmaAllocation() const;
+		// Includes the offset
 		uint64_t GetDeviceAddress() const;
 		VkBufferUsageFlags GetBufferFlags() const;
+		uint32_t GetBindlessIndex() const;
+
+		bool CmdRelocate(VkCommandBuffer cmd, VmaAllocation dstAllocation) override;
+		void OnRelocated(MemoryRelocations& relocations) override;
 
 	private:
+		void CreateView(const BufferCreateDesc& desc, VkBufferUsageFlags usage, VkDeviceSize offset);
+		void CreateAllocation(const BufferCreateDesc& desc, VkBufferUsageFlags usage);
+		// The arena was freed first, the view no longer points to any memory
+		void DetachArena();
+
 		void* m_Mapped;
 		VkBuffer m_Buffer;
+		VkBuffer m_RelocatedBuffer;
 		VkBufferView m_BufferView;
+		// Relocation recreates the view over the whole buffer with this format
+		VkFormat m_BufferViewFormat;
 		VmaAllocation m_Alloc;
 		size_t m_Size;
 		size_t m_Offset;
 		uint64_t m_DeviceAddress;
 		VkBufferUsageFlags m_Usage;
+		VkSharingMode m_SharingMode;
+		uint32_t m_BindlessIndex;
+		bool m_IsRelocatable;
+		Gfx_BufferArena* m_Arena;
+		VmaVirtualAllocation m_ArenaAlloc;
 	};
 }
\ No newline at end of file
@@ -0,0 +1,64 @@
+#pragma once
+#include "Backend/Gfx_VulkanCore.h"
+#include "Backend/Gfx_VulkanAllocator.h"
+
+#include <mutex>
+#include <unordered_set>
+
+namespace SmolEngine
+{
+	class Gfx_Buffer;
+
+	struct BufferArenaCreateDesc
+	{
+		BufferArenaCreateDesc();
+
+		size_t mySize;
+		// Larger requests are refused and get a buffer of their own
+		size_t myMaxAllocationSize;
+		VkBufferUsageFlags myBufferUsage;
+		VmaMemoryUsage myMemUsage;
+		MemoryPool myPool;
+	};
+
+	// One large VkBuffer whose ranges back Gfx_Buffer views, see BufferCreateDesc::myArena.
+	// Ranges are suballocated by a VMA virtual block and are never moved by Defragment. Views still alive when the arena
+	// is freed are detached and stop being good, so buffers owned by user code may outlive the render context
+	class Gfx_BufferArena
+	{
+	public:
+		Gfx_BufferArena();
+		~Gfx_BufferArena();
+
+		void Create(const BufferArenaCreateDesc& desc);
+		void Free();
+		bool IsGood() const;
+
+		// False if the arena can't hold the range, usage must be a subset of the arena's
+		bool Allocate(Gfx_Buffer* view, size_t size, VkBufferUsageFlags usage, VmaVirtualAllocation& outAllocation, VkDeviceSize& outOffset);
+		void Release(Gfx_Buffer* view, VmaVirtualAllocation allocation);
+		// Makes host writes to a range visible to the GPU, the arena's memory does not have to be host coherent
+		void Flush(VkDeviceSize offset, VkDeviceSize size);
+
+		VkBuffer GetRawBuffer() const { return m_Buffer; }
+		VkBufferUsageFlags GetBufferFlags() const { return m_Desc.myBufferUsage; }
+		// Zero if the arena has no VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT
+		uint64_t GetDeviceAddress() const { return m_DeviceAddress; }
+		// Persistently mapped, nullptr if the memory is not host visible
+		uint8_t* GetMappedData() const { return m_Mapped; }
+		size_t GetSize() const { return m_Desc.mySize; }
+		size_t GetUsedBytes();
+		uint32_t GetAllocationCount();
+
+	private:
+		VkBuffer m_Buffer;
+		VmaAllocation m_Alloc;
+		VmaVirtualBlock m_Block;
+		uint8_t* m_Mapped;
+		uint64_t m_DeviceAddress;
+		VkDeviceSize m_Alignment;
+		BufferArenaCreateDesc m_Desc;
+		std::unordered_set<Gfx_Buffer*> m_Views;
+		std::mutex m_Mutex;
+	};
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include <string>
+#include <cstdint>
+
+namespace SmolEngine
+{
+	// Scoped CPU timing available in every configuration. While recording, each thread appends to its own
+	// buffer without locks; Export writes the capture as Chrome trace JSON, which chrome://tracing and Perfetto open
+	class Gfx_CpuProfiler
+	{
+	public:
+		// Starts a new capture, events of the previous one are dropped
+		static void Start();
+		static void Stop();
+		static bool IsRecording();
+		// Call after Stop, threads still recording may be cut short
+		static bool Export(const std::string& filePath);
+		// Shown as the thread name in the trace
+		static void SetThreadName(const std::string& name);
+
+		// name must outlive the capture, usually a literal
+		static void Record(const char* name, uint64_t start, uint64_t end);
+		// Nanoseconds since startup
+		static uint64_t GetTime();
+	};
+
+	class Gfx_CpuScope
+	{
+	public:
+		Gfx_CpuScope(const char* name);
+		~Gfx_CpuScope();
+
+	private:
+		const char* m_Name;
+		uint64_t m_Start;
+	};
+
+#define GFX_PROFILE_CONCAT_IMPL(a, b) a##b
+#define GFX_PROFILE_CONCAT(a, b) GFX_PROFILE_CONCAT_IMPL(a, b)
+#define GFX_PROFILE_SCOPE(name) Gfx_CpuScope GFX_PROFILE_CONCAT(locCpuScope, __LINE__)(name);
+#define GFX_PROFILE_FUNCTION() GFX_PROFILE_SCOPE(__FUNCTION__)
+}
@@ -2,6 +2,8 @@
 #include "Common/Gfx_Memory.h"
 #include "Common/Gfx_Buffer.h"
 #include "Common/Gfx_AccelStructure.h"
+#include "Common/Gfx_DescriptorAllocator.h"
+#include "Common/Gfx_DescriptorBuffer.h"
 #include "Backend/Gfx_VulkanHelpers.h"
 
 #include "Tools/Gfx_ShaderCompiler.h"
@@ -31,6 +33,19 @@ namespace SmolEngine
 		DescriptorType myType;
 	};
 
+	// Inline write used by push descriptors
+	struct DescriptorWrite
+	{
+		Gfx_AccelStructure* myAccelStructure = nullptr;
+		Gfx_PixelStorage* myPixelStorage = nullptr;
+		Gfx_Sampler* mySampler = nullptr;
+		Gfx_Buffer* myBuffer = nullptr;
+
+		uint32_t myBinding = 0;
+		uint32_t myArrayElement = 0;
+		DescriptorType myType = DescriptorType::UNIFORM_BUFFER;
+	};
+
 	struct PushConstantsDesc
 	{
 		uint32_t mySize = 0;
@@ -50,7 +65,12 @@ namespace SmolEngine
 		DescriptorDesc* GetByName(const char* name);
 
 		PushConstantsDesc myPushConstant;
-		uint32_t myNumSets = 1;
+		// Set index in the pipeline layout, Reflect only picks up bindings of this set. Sets that change
+		// less often should take lower indices, they stay bound across partial rebinds
+		uint32_t mySet = 0;
+		DescriptorLifetime myLifetime = DescriptorLifetime::Static;
+		// Resources are written per draw with CmdPushDescriptor, no set is allocated
+		bool myIsPushDescriptor = false;
 
 		std::vector<Ref<DescriptorDesc>> myBindings;
 		std::map<std::string, Ref<DescriptorDesc>> myBindingNames;
@@ -59,11 +79,13 @@ namespace SmolEngine
 
 	class Gfx_Descriptor
 	{
+		friend class Gfx_Pipeline;
 		friend class Gfx_GraphicsPipeline;
 		friend class Gfx_RaytracingPipeline;
 		friend class Gfx_ComputePipeline;
 	public:
 		Gfx_Descriptor();
+		~Gfx_Descriptor();
 
 		void Free();
 		void Create(DescriptorCreateDesc* desc);
@@ -72,27 +94,65 @@ namespace SmolEngine
 		void CmdUpdateBuffer(uint32_t binding, Gfx_Buffer* buffer, DescriptorType type);
 		void CmdUpdatePixelStorage(uint32_t binding, Gfx_PixelStorage* storage, DescriptorType type);
 		void CmdUpdatePixelStorages(uint32_t binding, const std::vector<Gfx_PixelStorage*>& storages, DescriptorType type);
+		void CmdUpdateAccelStructure(uint32_t binding, Gfx_AccelStructure* accelStructure);
+		// Applies pending CmdUpdate* calls, must not be called while the set is used by a recorded command buffer
+		void Flush();
+		bool IsDirty() const;
+		bool IsPushDescriptor() const { return m_IsPushDescriptor; }
+
+		// Writes inline with vkCmdPushDescriptorSetKHR, falls back to a frame lifetime set when the extension is missing or the set exceeds maxPushDescriptors
+		void CmdPush(VkCommandBuffer cmd, VkPipelineBindPoint bindPoint, VkPipelineLayout pipelineLayout, uint32_t setIndex,
+			const std::vector<DescriptorWrite>& writes);
 
+		uint32_t GetSetIndex() const { return m_SetIndex; }
 		VkDescriptorSetLayout GetLayout() const { return m_Layout; }
 		VkDescriptorSet GetSet() const { return m_DescriptorSet; }
-		VkDescriptorPool GetPool() const { return m_Pool; }
+		// Offset of the set in Gfx_DescriptorBuffer, only used in descriptor buffer mode
+		VkDeviceSize GetBufferOffset() const { return m_BufferRegion.myOffset; }
+		VkDescriptorPool GetPool() const { return m_Allocation.myPool; }
 		std::optional<VkPushConstantRange> GetPushConstantRange() const { return m_PushConstantRange; }
 
-	private:
-		VkWriteDescriptorSet CreateImageWriteSet(const DescriptorDesc* desc, const std::vector<VkDescriptorImageInfo>& infos);
-		VkWriteDescriptorSet CreateBufferWriteSet(const DescriptorDesc* desc, const VkDescriptorBufferInfo& info);
+		// Rewrites the buffers and image views of every live descriptor that Gfx_VulkanAllocator::Defragment moved
+		static void OnRelocated(const MemoryRelocations& relocations);
 
-		struct BufferObject
+	private:
+		// Per binding slice of m_TemplateData, laid out for the update template
+		struct BindingData
 		{
-			VkDescriptorBufferInfo DesriptorInfo;
-			Ref<Gfx_Buffer> Buffer;
+			DescriptorType myType;
+			VkDescriptorType myVkType;
+			VkSampler mySampler = nullptr;
+			uint32_t myBinding = 0;
+			uint32_t myCount = 0;
+			size_t myOffset = 0;
+			size_t myStride = 0;
+			VkDeviceSize myBufferOffset = 0;
+			bool myIsWritten = false;
+			bool myIsDirty = false;
 		};
 
-		VkDescriptorPool m_Pool;
+		static std::vector<VkDescriptorSetLayoutBinding> GetLayoutBindings(const DescriptorCreateDesc* desc);
+		// Cached layout of the given bindings, used by pipelines for sets without a descriptor
+		static VkDescriptorSetLayout FindLayout(const DescriptorCreateDesc* desc);
+
+		BindingData* GetBindingData(uint32_t binding, DescriptorType type);
+		void MarkDirty(BindingData* data);
+		VkWriteDescriptorSet CreateWriteSet(const BindingData& data);
+		void WriteDescriptorBuffer(const BindingData& data);
+
+		DescriptorAllocation m_Allocation;
+		DescriptorBufferRegion m_BufferRegion;
 		VkDescriptorSetLayout m_Layout;
 		VkDescriptorSet m_DescriptorSet;
+		VkDescriptorUpdateTemplate m_UpdateTemplate;
+		uint32_t m_DirtyDescriptors;
+		uint32_t m_TotalDescriptors;
+		uint32_t m_SetIndex;
+		bool m_IsPushDescriptor;
+		bool m_IsPushSupported;
 		std::optional<VkPushConstantRange> m_PushConstantRange;
-		std::unordered_map<uint32_t, Ref<BufferObject>> m_Buffers;
-		std::unordered_map<uint32_t, VkWriteDescriptorSet> m_WriteSets;
+		std::vector<BindingData> m_BindingData;
+		std::vector<uint8_t> m_TemplateData;
+		std::unordered_map<uint32_t, Ref<Gfx_Buffer>> m_Buffers;
 	};
 }
\ No newline at end of file
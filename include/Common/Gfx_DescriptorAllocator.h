@@ -0,0 +1,79 @@
+#pragma once
+#include "Backend/Gfx_VulkanCore.h"
+
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+
+namespace SmolEngine
+{
+	enum class DescriptorLifetime
+	{
+		Static, // freed one by one (materials, long-lived passes)
+		Frame   // valid until the same frame in flight begins again
+	};
+
+	struct DescriptorAllocation
+	{
+		VkDescriptorSet mySet = nullptr;
+		VkDescriptorPool myPool = nullptr;
+		DescriptorLifetime myLifetime = DescriptorLifetime::Static;
+		uint32_t myGeneration = 0;
+	};
+
+	class Gfx_DescriptorAllocator
+	{
+	public:
+		Gfx_DescriptorAllocator();
+
+		void Create(uint32_t framesInFlight);
+		void Free();
+
+		// Layouts are cached by their bindings, never destroy the returned handle.
+		// With descriptor buffers the layouts get VK_DESCRIPTOR_SET_LAYOUT_CREATE_DESCRIPTOR_BUFFER_BIT_EXT
+		VkDescriptorSetLayout GetLayout(const std::vector<VkDescriptorSetLayoutBinding>& bindings, VkDescriptorSetLayoutCreateFlags flags = 0);
+
+		// Cached per layout, entries must be derived from the layout bindings in the same order
+		VkDescriptorUpdateTemplate GetUpdateTemplate(VkDescriptorSetLayout layout, const std::vector<VkDescriptorUpdateTemplateEntry>& entries);
+
+		DescriptorAllocation Allocate(VkDescriptorSetLayout layout, DescriptorLifetime lifetime = DescriptorLifetime::Static);
+		void Release(DescriptorAllocation& allocation);
+
+		// Resets frame pools of the given frame, must be called once its fence is signaled
+		void BeginFrame(uint32_t frameIndex);
+		// Resets every pool, all sets allocated so far become invalid
+		void ResetAll();
+
+	private:
+		struct PoolList
+		{
+			std::vector<VkDescriptorPool> myPools;
+			uint32_t myCurrent = 0;
+			uint32_t mySetsPerPool = 0;
+			VkDescriptorPoolCreateFlags myFlags = 0;
+		};
+
+		struct LayoutEntry
+		{
+			std::vector<uint32_t> myKey;
+			VkDescriptorSetLayout myLayout = nullptr;
+			std::vector<VkDescriptorPoolSize> mySizes;
+		};
+
+		VkDescriptorPool CreatePool(uint32_t maxSets, VkDescriptorPoolCreateFlags flags, const std::vector<VkDescriptorPoolSize>& extraSizes);
+		bool TryAllocate(VkDescriptorPool pool, VkDescriptorSetLayout layout, VkDescriptorSet& outSet);
+		DescriptorAllocation AllocateFromList(PoolList& list, VkDescriptorSetLayout layout);
+		void ResetList(PoolList& list);
+		void DestroyList(PoolList& list);
+
+		std::mutex m_Mutex;
+		PoolList m_StaticPools;
+		std::vector<PoolList> m_FramePools;
+		uint32_t m_FrameIndex;
+		uint32_t m_Generation;
+
+		std::unordered_map<size_t, std::vector<LayoutEntry>> m_Layouts;
+		std::unordered_map<VkDescriptorSetLayout, std::vector<VkDescriptorPoolSize>> m_LayoutSizes;
+		std::unordered_map<VkDescriptorSetLayout, VkDescriptorUpdateTemplate> m_UpdateTemplates;
+	};
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include "Backend/Gfx_VulkanCore.h"
+#include "Common/Gfx_Buffer.h"
+#include "Common/Gfx_DescriptorAllocator.h"
+
+#include <vector>
+#include <mutex>
+
+namespace SmolEngine
+{
+	struct DescriptorBufferRegion
+	{
+		VkDeviceSize myOffset = 0;
+		VkDeviceSize mySize = 0;
+		DescriptorLifetime myLifetime = DescriptorLifetime::Static;
+	};
+
+	// Single mapped buffer with resource and sampler descriptors (VK_EXT_descriptor_buffer),
+	// a set is an offset into it instead of a pool allocation
+	class Gfx_DescriptorBuffer
+	{
+	public:
+		Gfx_DescriptorBuffer();
+
+		void Create(uint32_t framesInFlight);
+		void Free();
+		bool IsGood() const;
+		// Recycles the frame region of the given frame and static regions no frame in flight can reference
+		void BeginFrame(uint32_t frameIndex);
+
+		DescriptorBufferRegion Allocate(VkDeviceSize size, DescriptorLifetime lifetime = DescriptorLifetime::Static);
+		void Release(DescriptorBufferRegion& region);
+
+		// Writes a single descriptor at the given byte offset of the buffer
+		void Write(VkDeviceSize offset, VkDescriptorType type, const VkDescriptorImageInfo* imageInfo,
+			const VkDescriptorBufferInfo* bufferInfo, VkAccelerationStructureKHR accelStructure = nullptr);
+		void CmdBind(VkCommandBuffer cmd) const;
+
+		static size_t GetDescriptorSize(VkDescriptorType type);
+		static VkDeviceSize GetLayoutSize(VkDescriptorSetLayout layout);
+		static VkDeviceSize GetBindingOffset(VkDescriptorSetLayout layout, uint32_t binding);
+
+	private:
+		struct RetiredRegion
+		{
+			DescriptorBufferRegion myRegion;
+			uint64_t myFrame;
+		};
+
+		void AddFreeRange(VkDeviceSize offset, VkDeviceSize size);
+
+		std::mutex m_Mutex;
+		Gfx_Buffer m_Buffer;
+		uint8_t* m_Mapped;
+		VkDeviceSize m_Alignment;
+		VkDeviceSize m_StaticSize;
+		VkDeviceSize m_FrameSize;
+		VkDeviceSize m_FrameUsed;
+		uint32_t m_FrameIndex;
+		uint64_t m_FrameCount;
+		std::vector<DescriptorBufferRegion> m_FreeRanges; // sorted by offset
+		std::vector<RetiredRegion> m_Retired;
+	};
+}
@@ -24,6 +24,8 @@ namespace SmolEngine
 		Gfx_EditorCamera(EditorCameraCreateDesc* desc);
 
 		void Focus(const glm::vec3& focusPoint);
+		// Places the camera directly, drops any pending movement
+		void SetPose(const glm::vec3& position, float pitch, float yaw);
 		void OnUpdate(float ts);
 		void OnEvent(Gfx_Event& e);
 		void OnResize(uint32_t width, uint32_t height) override;
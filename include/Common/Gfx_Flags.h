@@ -50,6 +50,32 @@ namespace SmolEngine
 		R32_SINT,
 		R32G32_SINT,
 		R32G32B32A32_SINT,
+
+		// Block-compressed, sizes are per block
+		BC1_RGBA_UNORM,
+		BC1_RGBA_SRGB,
+		BC2_UNORM,
+		BC2_SRGB,
+		BC3_UNORM,
+		BC3_SRGB,
+		BC4_UNORM,
+		BC4_SNORM,
+		BC5_UNORM,
+		BC5_SNORM,
+		BC6H_UFLOAT,
+		BC6H_SFLOAT,
+		BC7_UNORM,
+		BC7_SRGB,
+
+		ASTC_4x4_UNORM,
+		ASTC_4x4_SRGB,
+		ASTC_6x6_UNORM,
+		ASTC_6x6_SRGB,
+		ASTC_8x8_UNORM,
+		ASTC_8x8_SRGB,
+
+		R8G8B8A8_SRGB,
+		B8G8R8A8_SRGB,
 	};
 
 	enum class TextureUsage : int
@@ -0,0 +1,121 @@
+#pragma once
+#include "Common/Gfx_Memory.h"
+#include "Backend/Gfx_VulkanCore.h"
+
+#include <vector>
+#include <string>
+#include <unordered_map>
+
+namespace SmolEngine
+{
+	class Gfx_CmdBuffer;
+
+	struct GpuScopeResult
+	{
+		std::string myName;
+		uint32_t myDepth = 0;
+		float myTime = 0.0f; // ms
+	};
+
+	struct GpuFrameResult
+	{
+		std::vector<GpuScopeResult> myScopes;
+		uint64_t myFrame = 0; // GetFrameCount() of the frame that recorded the scopes
+		float myTime = 0.0f; // ms from the first scope begin to the last scope end
+	};
+
+	// Over the rolling history, in ms
+	struct GpuScopeStats
+	{
+		float myLast = 0.0f;
+		float myAverage = 0.0f;
+		float myMin = 0.0f;
+		float myMax = 0.0f;
+	};
+
+	// Times named scopes of the frame command buffer with timestamp queries, one pool per frame in flight.
+	// A pool is read without waiting once its frame index comes around again, scopes in other command buffers are ignored
+	class Gfx_GpuProfiler
+	{
+	public:
+		Gfx_GpuProfiler();
+
+		void Create(uint32_t framesInFlight);
+		void Free();
+		// Resolves the scopes recorded the last time this frame index was used
+		void BeginFrame(uint32_t frameIndex);
+		// Resets the pool of the current frame, outside of any render pass
+		void CmdReset(Gfx_CmdBuffer* cmd);
+
+		// Scopes nest, EndScope closes the most recent open one
+		void CmdBeginScope(Gfx_CmdBuffer* cmd, const std::string& name);
+		void CmdEndScope(Gfx_CmdBuffer* cmd);
+
+		// Rolling timeline of every scope, call between ImGui NewFrame and render
+		void DrawTimeline();
+
+		bool IsGood() const;
+		bool GetStats(const std::string& name, GpuScopeStats& outStats) const;
+		GpuScopeStats GetFrameStats() const;
+		const GpuFrameResult& GetLastFrame() const;
+		uint64_t GetFrameCount() const;
+
+	private:
+		struct OpenScope
+		{
+			uint32_t myResult;
+			uint32_t myQuery;
+		};
+
+		struct ScopeRecord
+		{
+			std::string myName;
+			uint32_t myDepth;
+			uint32_t myBeginQuery;
+			uint32_t myEndQuery;
+		};
+
+		struct FrameSlot
+		{
+			VkQueryPool myPool = nullptr;
+			std::vector<ScopeRecord> myScopes;
+			uint32_t myQueryCount = 0;
+			uint64_t myFrame = 0;
+			bool myIsRecorded = false;
+		};
+
+		struct History
+		{
+			std::vector<float> myTimes; // ring of s_GpuProfilerHistory
+			uint32_t myCount = 0;
+			uint64_t myLastFrame = 0;
+		};
+
+		void Resolve(FrameSlot& slot);
+		void Push(History& history, float time, uint64_t frame);
+		static GpuScopeStats GetStats(const History& history);
+
+		std::vector<FrameSlot> m_Slots;
+		std::vector<OpenScope> m_OpenScopes;
+		std::unordered_map<std::string, History> m_Histories;
+		History m_FrameHistory;
+		GpuFrameResult m_LastFrame;
+		VkCommandBuffer m_FrameCmd;
+		float m_TimestampPeriod;
+		uint64_t m_TimestampMask;
+		uint32_t m_FrameIndex;
+		uint64_t m_FrameCount;
+	};
+
+	// Times everything recorded into cmd until the end of the enclosing block
+	class Gfx_GpuScope
+	{
+	public:
+		Gfx_GpuScope(Gfx_CmdBuffer* cmd, const std::string& name);
+		~Gfx_GpuScope();
+
+	private:
+		Gfx_CmdBuffer* m_Cmd;
+		bool m_IsOpen;
+	};
+}
@@ -10,13 +10,18 @@ namespace SmolEngine
 	enum class CachedPathType
 	{
 		Shader,
+		Reflection,
 		Pipeline
 	};
 
 	class Gfx_Helpers
 	{
 	public:
+		// Bytes per texel, or bytes per block for compressed formats
 		static uint32_t GetFormatSize(Format format);
+		static uint32_t GetFormatBlockExtent(Format format);
+		static bool IsCompressedFormat(Format format);
+		static size_t GetImageSize(Format format, const glm::uvec2& size);
 
 		static glm::mat4 ComposeTransform(const glm::vec3& translation, const glm::vec3& rotation, const glm::vec3& scale);
 		static glm::mat3x4 ComposeTransform3x4(const glm::vec3& translation, const glm::vec3& rotation, const glm::vec3& scale);
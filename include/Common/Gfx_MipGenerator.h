@@ -0,0 +1,35 @@
+#pragma once
+#include "Backend/Gfx_VulkanCore.h"
+#include "Common/Gfx_Memory.h"
+#include "Common/Gfx_Flags.h"
+
+namespace SmolEngine
+{
+	class Gfx_Shader;
+	class Gfx_PixelStorage;
+
+	// Builds mip chains with a compute downsampler that writes four levels per dispatch,
+	// falls back to a chain of blits where storage writes or push descriptors are unavailable
+	class Gfx_MipGenerator
+	{
+	public:
+		Gfx_MipGenerator();
+
+		void Free();
+		// Mip 0 must be written and every level in TRANSFER_DST_OPTIMAL, all levels end up in the storage's tracked layout
+		void CmdGenerate(VkCommandBuffer cmd, Gfx_PixelStorage* storage);
+		bool IsComputeSupported(Format format, uint32_t arrayLayers) const;
+
+	private:
+		// The shader compiler needs the includer, which is created after the render context
+		bool CreatePipeline();
+		void CmdGenerateCompute(VkCommandBuffer cmd, Gfx_PixelStorage* storage);
+
+		Ref<Gfx_Shader> m_Shader;
+		VkSampler m_Sampler;
+		VkDescriptorSetLayout m_SetLayout;
+		VkPipelineLayout m_PipelineLayout;
+		VkPipeline m_Pipeline;
+		bool m_IsInitialized;
+	};
+}
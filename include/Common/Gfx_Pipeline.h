@@ -3,6 +3,9 @@
 #include "Common/Gfx_Flags.h"
 #include "Common/Gfx_BufferLayout.h"
 
+#include <optional>
+#include <vector>
+
 namespace SmolEngine
 {
 	class Gfx_Shader;
@@ -33,8 +36,13 @@ namespace SmolEngine
 		bool IsType(Type type) const;
 		VkPipelineLayout GetLayout() const;
 		VkPipeline GetPipeline() const;
+		std::optional<uint32_t> GetBindlessSet() const;
 
 	protected:
+		// Every descriptor is placed at its own set index, sets declared by the shader without a descriptor are reflected
+		void CreateLayout(Gfx_Shader* shader, const std::vector<Gfx_Descriptor*>& descriptors, std::optional<uint32_t> bindlessSet);
+
+		std::optional<uint32_t> m_BindlessSet;
 		VkPipelineLayout m_Layout;
 		VkPipeline m_Pipeline;
 		Type m_Type;
@@ -45,6 +53,8 @@ namespace SmolEngine
 		Ref<Gfx_Shader> myShader = nullptr;
 		Ref<Gfx_Framebuffer> myFramebuffer = nullptr;
 		Ref<Gfx_Descriptor> myDescriptor = nullptr;
+		std::vector<Ref<Gfx_Descriptor>> myDescriptorSets; // additional sets, see DescriptorCreateDesc::mySet
+		std::optional<uint32_t> myBindlessSet; // set index of the bindless heap
 
 		float myMinDepth = 0.0f;
 		float myMaxDepth = 1.0f;
@@ -87,6 +97,8 @@ namespace SmolEngine
 	{
 		Gfx_Shader* myShader = nullptr;
 		Gfx_Descriptor* myDescriptor = nullptr;
+		std::vector<Gfx_Descriptor*> myDescriptorSets; // additional sets, see DescriptorCreateDesc::mySet
+		std::optional<uint32_t> myBindlessSet; // set index of the bindless heap
 	};
 
 	class Gfx_ComputePipeline final : public Gfx_Pipeline
@@ -108,6 +120,8 @@ namespace SmolEngine
 	{
 		Gfx_Shader* myShader = nullptr;
 		Gfx_Descriptor* myDescriptor = nullptr;
+		std::vector<Gfx_Descriptor*> myDescriptorSets; // additional sets, see DescriptorCreateDesc::mySet
+		std::optional<uint32_t> myBindlessSet; // set index of the bindless heap
 		uint32_t myMaxRayRecursionDepth = 1;
 	};
 
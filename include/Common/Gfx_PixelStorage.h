@@ -2,6 +2,7 @@
 #include "Backend/Gfx_VulkanAllocator.h"
 #include "Common/Gfx_Flags.h"
 
+#include <vector>
 
 namespace SmolEngine
 {
@@ -15,9 +16,10 @@ namespace SmolEngine
 		VkImageUsageFlags myUsageFlags;
 		VkImageCreateFlags myCreateFlags;
 		VkImageLayout myLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		MemoryPool myPool = MemoryPool::Default;
 	};
 
-	class Gfx_PixelStorage
+	class Gfx_PixelStorage : public Gfx_Relocatable
 	{
 		friend class Gfx_VulkanHelpers;
 	public:
@@ -34,11 +36,22 @@ namespace SmolEngine
 		VkImageView GetImageView() const { return m_ImageView; }
 		VmaAllocation GetVmaAlloc() { return m_Alloc; }
 		VkImageLayout GetImageLayout() { return m_Desc.myLayout; }
+		// View of a single mip of the first layer, created on first use
+		VkImageView GetMipView(uint32_t mip);
+
+		bool CmdRelocate(VkCommandBuffer cmd, VmaAllocation dstAllocation) override;
+		void OnRelocated(MemoryRelocations& relocations) override;
 
 	private:
+		VkImageCreateInfo GetImageCreateInfo() const;
+		VkImageView CreateImageView() const;
+
 		VkImage m_Image;
+		VkImage m_RelocatedImage;
 		VmaAllocation m_Alloc;
 		VkImageView m_ImageView;
+		std::vector<VkImageView> m_MipViews;
 		PixelStorageCreateDesc m_Desc;
+		bool m_IsRelocatable;
 	};
 }
\ No newline at end of file
@@ -0,0 +1,96 @@
+#pragma once
+#include "Common/Gfx_Memory.h"
+#include "Backend/Gfx_VulkanCore.h"
+
+#include <vector>
+#include <string>
+#include <unordered_map>
+
+namespace SmolEngine
+{
+	class Gfx_CmdBuffer;
+
+	struct PipelineStatistics
+	{
+		uint64_t myInputVertices = 0;
+		uint64_t myInputPrimitives = 0;
+		uint64_t myVertexInvocations = 0;
+		uint64_t myClippingInvocations = 0;
+		uint64_t myClippingPrimitives = 0; // output by the clipper
+		uint64_t myFragmentInvocations = 0;
+		uint64_t myComputeInvocations = 0;
+		uint64_t myFrame = 0; // number of the frame that recorded them, counted by BeginFrame
+	};
+
+	struct OcclusionResult
+	{
+		uint64_t mySamples = 0; // only zero or non zero unless the device supports precise occlusion queries
+		uint64_t myFrame = 0;
+	};
+
+	// Pipeline statistics per named render pass and occlusion queries per user id, recorded into the frame command buffer.
+	// Each frame in flight owns its pools, which are read without waiting once its frame index comes around again
+	class Gfx_QueryManager
+	{
+	public:
+		Gfx_QueryManager();
+
+		void Create(uint32_t framesInFlight);
+		void Free();
+		// Resolves the queries recorded the last time this frame index was used
+		void BeginFrame(uint32_t frameIndex);
+		// Resets the pools of the current frame, outside of any render pass
+		void CmdReset(Gfx_CmdBuffer* cmd);
+
+		// Off by default, statistics queries are not free on every driver
+		void SetStatisticsEnabled(bool enabled);
+		// Only one query of each type is active at a time, a nested begin is ignored along with its end
+		void CmdBeginStatistics(Gfx_CmdBuffer* cmd, const std::string& name);
+		void CmdEndStatistics(Gfx_CmdBuffer* cmd);
+		// Inside a render pass
+		void CmdBeginOcclusion(Gfx_CmdBuffer* cmd, uint64_t id);
+		void CmdEndOcclusion(Gfx_CmdBuffer* cmd);
+
+		bool IsStatisticsSupported() const;
+		bool IsStatisticsEnabled() const;
+		// Latest resolved results, false if none was resolved yet
+		bool GetStatistics(const std::string& name, PipelineStatistics& outStats) const;
+		bool GetOcclusion(uint64_t id, OcclusionResult& outResult) const;
+		const std::unordered_map<std::string, PipelineStatistics>& GetAllStatistics() const;
+
+	private:
+		template<typename T>
+		struct QueryRecord
+		{
+			T myKey;
+			uint32_t myQuery;
+		};
+
+		struct FrameSlot
+		{
+			VkQueryPool myStatisticsPool = nullptr;
+			VkQueryPool myOcclusionPool = nullptr;
+			std::vector<QueryRecord<std::string>> myStatistics;
+			std::vector<QueryRecord<uint64_t>> myOcclusions;
+			uint64_t myFrame = 0;
+			bool myIsRecorded = false;
+		};
+
+		void Resolve(FrameSlot& slot);
+		bool IsRecording(Gfx_CmdBuffer* cmd) const;
+
+		std::vector<FrameSlot> m_Slots;
+		std::unordered_map<std::string, PipelineStatistics> m_Statistics;
+		std::unordered_map<uint64_t, OcclusionResult> m_Occlusions;
+		VkCommandBuffer m_FrameCmd;
+		uint32_t m_FrameIndex;
+		bool m_IsStatisticsSupported;
+		bool m_IsStatisticsEnabled;
+		bool m_IsStatisticsActive;
+		bool m_IsOcclusionActive;
+		bool m_IsPreciseOcclusion;
+		uint32_t m_StatisticsDepth;
+		uint32_t m_OcclusionDepth;
+		uint64_t m_FrameCount;
+	};
+}
@@ -0,0 +1,90 @@
+#pragma once
+#include "Common/Gfx_Memory.h"
+#include "Common/Gfx_Buffer.h"
+#include "Common/Gfx_PixelStorage.h"
+
+#include <vector>
+#include <atomic>
+
+namespace SmolEngine
+{
+	struct ReadbackRegion
+	{
+		// In texels of myMip, a zero size reads up to the edge of the mip
+		glm::uvec2 myOffset = { 0, 0 };
+		glm::uvec2 mySize = { 0, 0 };
+		uint32_t myMip = 0;
+		uint32_t myLayer = 0;
+	};
+
+	class Gfx_ReadbackTicket
+	{
+		friend class Gfx_ReadbackQueue;
+	public:
+		Gfx_ReadbackTicket();
+
+		bool IsReady() const;
+		// Tightly packed rows, depth images return only the depth aspect
+		const std::vector<uint8_t>& GetData() const;
+		// Zero for buffers
+		const glm::uvec2& GetSize() const;
+		Format GetFormat() const;
+
+	private:
+		std::vector<uint8_t> m_Data;
+		glm::uvec2 m_Size;
+		Format m_Format;
+		std::atomic<bool> m_IsReady;
+	};
+
+	// Copies images and buffers back to the CPU through a ring of host cached staging buffers, one slot per frame in flight.
+	// Async copies are recorded into the frame command buffer and complete once their frame index comes around again
+	class Gfx_ReadbackQueue
+	{
+	public:
+		Gfx_ReadbackQueue();
+
+		void Create(uint32_t framesInFlight);
+		void Free();
+		// Publishes the copies recorded the last time this frame index was used
+		void BeginFrame(uint32_t frameIndex);
+
+		// Must be called between Gfx_App::BeginFrame and Gfx_App::SwapBuffers
+		Ref<Gfx_ReadbackTicket> ReadbackAsync(Gfx_PixelStorage* storage, const ReadbackRegion& region = {});
+		// A zero size reads up to the end of the buffer
+		Ref<Gfx_ReadbackTicket> ReadbackAsync(Gfx_Buffer* buffer, size_t offset = 0, size_t size = 0);
+
+		// Blocking variants, submit their own command buffer and wait for it
+		static Ref<Gfx_ReadbackTicket> Readback(Gfx_PixelStorage* storage, const ReadbackRegion& region = {});
+		static Ref<Gfx_ReadbackTicket> Readback(Gfx_Buffer* buffer, size_t offset = 0, size_t size = 0);
+
+	private:
+		struct PendingCopy
+		{
+			Ref<Gfx_ReadbackTicket> myTicket;
+			uint32_t myPage;
+			VkDeviceSize myOffset;
+		};
+
+		struct FrameSlot
+		{
+			std::vector<Ref<Gfx_Buffer>> myPages;
+			std::vector<PendingCopy> myPending;
+			// Within the last page, and over all pages including alignment
+			VkDeviceSize myPageUsed = 0;
+			VkDeviceSize myUsed = 0;
+		};
+
+		// Returns the page and offset of size bytes aligned to alignment in the current slot
+		Gfx_Buffer* Allocate(VkDeviceSize size, VkDeviceSize alignment, uint32_t& outPage, VkDeviceSize& outOffset);
+
+		static Ref<Gfx_Buffer> CreateStaging(VkDeviceSize size);
+		static VkDeviceSize PrepareImage(Gfx_PixelStorage* storage, const ReadbackRegion& region, VkBufferImageCopy& outCopy, Gfx_ReadbackTicket* ticket);
+		static void CmdCopyImage(VkCommandBuffer cmd, Gfx_PixelStorage* storage, const VkBufferImageCopy& copy, VkBuffer staging);
+		static void CmdCopyBuffer(VkCommandBuffer cmd, Gfx_Buffer* buffer, size_t offset, VkBuffer staging, VkDeviceSize stagingOffset, size_t size);
+		static void Resolve(Gfx_Buffer* staging, VkDeviceSize offset, Gfx_ReadbackTicket* ticket);
+
+		std::vector<FrameSlot> m_Slots;
+		uint32_t m_FrameIndex;
+	};
+}
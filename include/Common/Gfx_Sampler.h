@@ -46,8 +46,10 @@ namespace SmolEngine
 
 		bool IsGood() const { return m_Sampler != nullptr; }
 		VkSampler GetSampler() const { return m_Sampler; }
+		const SamplerCreateDesc& GetDesc() const { return m_Desc; }
 
 	private:
 		VkSampler m_Sampler;
+		SamplerCreateDesc m_Desc;
 	};
 }
\ No newline at end of file
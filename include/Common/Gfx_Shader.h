@@ -7,14 +7,67 @@
 #include <string>
 #include <glm/glm.hpp>
 #include <map>
+#include <optional>
 
 namespace SmolEngine
 {
+	struct ShaderBindingReflection
+	{
+		std::string myName;
+		uint32_t mySet = 0;
+		uint32_t myBinding = 0;
+		uint32_t myCount = 1; // 0 - runtime array
+		uint32_t mySize = 0;
+		DescriptorType myType = DescriptorType::UNIFORM_BUFFER;
+		ShaderStage myStages = ShaderStage::Vertex;
+	};
+
+	struct ShaderPushConstantReflection
+	{
+		uint32_t myOffset = 0;
+		uint32_t mySize = 0;
+		ShaderStage myStages = ShaderStage::Vertex;
+	};
+
+	struct ShaderSpecConstantReflection
+	{
+		std::string myName;
+		uint32_t myConstantID = 0;
+		uint32_t mySize = 0;
+	};
+
+	struct ShaderReflection
+	{
+		void Merge(const ShaderReflection& other);
+
+		std::vector<ShaderBindingReflection> myBindings;
+		std::optional<ShaderPushConstantReflection> myPushConstant;
+		std::vector<ShaderSpecConstantReflection> mySpecConstants;
+		glm::uvec3 myWorkgroupSize = glm::uvec3(0);
+	};
+
+	enum class ShaderOptimization
+	{
+		None,
+		Performance,
+		Size
+	};
+
+	struct ShaderCompileStats
+	{
+		uint32_t myWordsBefore = 0;
+		uint32_t myWordsAfter = 0;
+		uint32_t myInstructionsBefore = 0;
+		uint32_t myInstructionsAfter = 0;
+	};
+
 	struct ShaderCreateDesc
 	{
 		const char* myEntryPoint = "main";
 		std::map<ShaderStage, std::string> myStages;
 		std::map<std::string, bool> myDefines;
+		ShaderOptimization myOptimization = ShaderOptimization::None;
+		bool myStripDebugInfo = false;
 	};
 
 	class Gfx_Shader
@@ -35,6 +88,9 @@ namespace SmolEngine
 		bool IsGood() const;
 
 		ShaderCreateDesc& GetDesc();
+		const ShaderReflection& GetReflection() const;
+		const ShaderReflection* GetReflection(ShaderStage stage) const;
+		const ShaderCompileStats* GetCompileStats(ShaderStage stage) const;
 		std::vector<VkPipelineShaderStageCreateInfo>& GetShaderStages();
 		void CreateBindingTable(VkPipeline pipeline);
 		void DestroyModules();
@@ -46,6 +102,9 @@ namespace SmolEngine
 		std::unordered_map<ShaderStage, VkShaderModule> m_ShaderModules;
 		std::unordered_map<ShaderStage, Gfx_Buffer> m_BindingTables;
 		std::map<ShaderStage, std::vector<uint32_t>> m_Binary;
+		std::map<ShaderStage, ShaderReflection> m_StageReflection;
+		std::map<ShaderStage, ShaderCompileStats> m_CompileStats;
+		ShaderReflection m_Reflection;
 		std::map<ShaderStage, uint32_t> m_ShaderIDs;
 	};
 }
\ No newline at end of file
@@ -5,6 +5,7 @@
 #include "Common/Gfx_Flags.h"
 
 #include <string>
+#include <vector>
 #include <unordered_map>
 
 namespace SmolEngine
@@ -21,35 +22,68 @@ namespace SmolEngine
 		std::string myFilePath;
 		bool myImGUIHandleEnable = false;
 		bool myIsShaderWritable = false;
+		// Full mip chain generated on the GPU from mip 0, overrides myMipLevels
+		bool myAutoMips = false;
 	};
 
 	class Gfx_Texture
 	{
 		friend class Gfx_VulkanHelpers;
+		friend class Gfx_TextureLoader;
+		friend class Gfx_TextureStreamer;
+		friend class Gfx_RenderContext;
 	public:
 		Gfx_Texture();
 		~Gfx_Texture();
+		// The relocation listener captures this
+		Gfx_Texture(const Gfx_Texture&) = delete;
+		Gfx_Texture& operator=(const Gfx_Texture&) = delete;
 
 		void Create(TextureCreateDesc* info);
 		void Free();
 
 		const VkDescriptorImageInfo& GetDescriptorImageInfo() const;
+		// Mips count over the full chain, a level that is not resident maps to the finest resident one
 		std::pair<uint32_t, uint32_t> GetMipSize(uint32_t mip) const;
 		VkDescriptorImageInfo GetMipImageView(uint32_t mip);
 		Ref<Gfx_PixelStorage> GetPixelStorage();
 		TextureUsage GetUsageFlags() const;
 		void* GetImGuiTexture() const;
 		uint32_t GetMips() const;
+		uint32_t GetBindlessIndex() const;
+		uint32_t GetBindlessStorageIndex() const;
 		bool IsGood() const;
+		// False while an async texture is still being uploaded and the placeholder is bound instead
+		bool IsReady() const;
 
 	private:
 		void LoadEX(TextureCreateDesc* info, void* data);
+		void CreateStorage(TextureCreateDesc* info);
+		VkImageLayout GetFinalLayout() const;
+		// Streamed textures hold only the levels from this one on
+		uint32_t GetFirstResidentMip() const;
+		void OnResident();
+		void InitPlaceholder(const Ref<Gfx_Texture>& placeholder);
+		// Replaces the image while keeping the bindless index, the caller keeps the old storage and its mip views alive for the frames in flight
+		void SwapStorage(const Ref<Gfx_PixelStorage>& storage);
+		// The pixel storage was moved by Gfx_VulkanAllocator::Defragment
+		void OnRelocated(const MemoryRelocations& relocations);
+
+		// stb_image files, R8G8B8A8_SRGB in myFormat is kept, HDR files load as R32G32B32A32_SFLOAT
+		static void* DecodeImage(TextureCreateDesc* info);
+		static bool IsContainerFile(const std::string& filePath);
+		// KTX and DDS through gli, every mip level and layer is uploaded as stored in the file
+		static bool LoadContainer(TextureCreateDesc* info, std::vector<uint8_t>& data, std::vector<VkBufferImageCopy>& regions);
 
 		void* m_ImguiHandle;
+		uint32_t m_BindlessIndex;
+		uint32_t m_BindlessStorageIndex;
+		uint32_t m_RelocationListener;
+		bool m_IsReady;
 		Ref<Gfx_PixelStorage> m_PixelStorage;
+		Ref<Gfx_Texture> m_Placeholder;
 
 		TextureCreateDesc m_Desc;
 		VkDescriptorImageInfo m_DescriptorImageInfo;
-		std::unordered_map<uint32_t, VkImageView> m_ImageViewMap;
 	};
 }
@@ -0,0 +1,43 @@
+#pragma once
+#include "Common/Gfx_Memory.h"
+#include "Common/Gfx_Texture.h"
+
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace SmolEngine
+{
+	// Shares file textures between everyone asking for the same path and create parameters,
+	// entries nobody else references are released least recently used first once the cache is over capacity
+	class Gfx_TextureCache
+	{
+	public:
+		Gfx_TextureCache();
+
+		Ref<Gfx_Texture> Find(const TextureCreateDesc& desc);
+		// Returns the texture already cached under the same key if another thread inserted first
+		Ref<Gfx_Texture> Insert(const TextureCreateDesc& desc, const Ref<Gfx_Texture>& texture);
+		void SetCapacity(VkDeviceSize bytes);
+		void Trim();
+		void Clear();
+
+		VkDeviceSize GetCachedBytes();
+		static std::string GetKey(const TextureCreateDesc& desc);
+
+	private:
+		struct Entry
+		{
+			std::string myKey;
+			Ref<Gfx_Texture> myTexture;
+		};
+
+		void TrimLocked();
+
+		std::mutex m_Mutex;
+		std::list<Entry> m_Entries; // most recently used first
+		std::unordered_map<std::string, std::list<Entry>::iterator> m_Lookup;
+		VkDeviceSize m_Capacity;
+	};
+}
@@ -0,0 +1,73 @@
+#pragma once
+#include "Common/Gfx_Memory.h"
+#include "Common/Gfx_Texture.h"
+#include "Common/Gfx_Buffer.h"
+#include "Common/Gfx_CmdBuffer.h"
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+namespace SmolEngine
+{
+	// Decodes image files on worker threads and uploads them in batches without blocking the render thread.
+	// Only the bindless slot follows the texture once it is resident, descriptor sets written while IsReady()
+	// was false keep the placeholder view and have to be written again
+	class Gfx_TextureLoader
+	{
+	public:
+		Gfx_TextureLoader();
+		~Gfx_TextureLoader();
+
+		void Create();
+		void Free();
+
+		void Enqueue(const Ref<Gfx_Texture>& texture, const TextureCreateDesc& desc);
+		// Submits decoded textures and publishes finished batches, called once per frame
+		void Update();
+		// Blocks until every queued texture is resident
+		void Flush();
+		uint32_t GetPendingCount() const;
+
+	private:
+		struct DecodeJob
+		{
+			Ref<Gfx_Texture> myTexture;
+			TextureCreateDesc myDesc;
+			void* myData = nullptr;
+			// Set instead of myData for KTX and DDS files
+			std::vector<uint8_t> myBlocks;
+			std::vector<VkBufferImageCopy> myRegions;
+		};
+
+		// Retired batches keep their staging buffer, command buffer and fence for the next submit
+		struct UploadBatch
+		{
+			std::vector<Ref<Gfx_Texture>> myTextures;
+			Ref<Gfx_Buffer> myStaging;
+			Ref<Gfx_CmdBuffer> myCmd;
+			VkFence myFence = nullptr;
+		};
+
+		void WorkerLoop();
+		void StopWorkers();
+		void SubmitDecoded();
+		void RetireBatches(bool wait);
+		UploadBatch AcquireBatch(size_t stagingSize);
+		static size_t GetDataSize(const DecodeJob& job);
+
+		mutable std::mutex m_Mutex;
+		std::condition_variable m_Condition;
+		// Signaled by workers when a job was decoded or failed
+		std::condition_variable m_DecodedCondition;
+		std::vector<std::thread> m_Workers;
+		std::deque<DecodeJob> m_DecodeQueue;
+		std::vector<DecodeJob> m_Decoded;
+		std::vector<UploadBatch> m_Batches;
+		std::vector<UploadBatch> m_FreeBatches;
+		uint32_t m_InFlight;
+		bool m_Exit;
+	};
+}
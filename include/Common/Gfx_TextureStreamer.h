@@ -0,0 +1,97 @@
+#pragma once
+#include "Common/Gfx_Memory.h"
+#include "Common/Gfx_Texture.h"
+#include "Common/Gfx_Buffer.h"
+#include "Common/Gfx_CmdBuffer.h"
+
+#include <vector>
+#include <string>
+
+namespace SmolEngine
+{
+	// Added to the unclamped LOD so that requests for finer levels than the resident ones stay positive
+	static constexpr uint32_t s_StreamerLodBias = 16;
+
+	// Keeps only the mip levels shaders actually sample resident. Shaders report the level they need with
+	// atomicMin(feedback[bindlessTextureIndex], uint(max(textureQueryLod(...).x + s_StreamerLodBias, 0.0))), where feedback
+	// is the storage buffer at GetFeedbackIndex() in the bindless heap; without the bindless heap every texture asks for its full chain
+	class Gfx_TextureStreamer
+	{
+	public:
+		Gfx_TextureStreamer();
+
+		void Create(uint32_t framesInFlight);
+		void Free();
+		// Reads the feedback of the frame that used this index last, then uploads or evicts levels within the budget.
+		// Uploads are batched into one submit per frame and swapped in once their fence has signaled
+		void BeginFrame(uint32_t frameIndex);
+
+		// KTX or DDS with a full mip chain, starts with only the coarsest levels resident, which are uploaded before it returns
+		Ref<Gfx_Texture> Load(const std::string& filePath, const Ref<Gfx_Sampler>& sampler = nullptr);
+		// 0 uses the budget reported by VMA for device local heaps
+		void SetBudget(VkDeviceSize bytes);
+
+		uint32_t GetFeedbackIndex() const;
+		VkDeviceSize GetResidentBytes() const;
+		// Level of the full chain a biased feedback value asks for, the LOD is relative to residentMip and may be negative
+		static uint32_t GetRequestedMip(uint32_t residentMip, uint32_t feedback, uint32_t tailMip);
+
+	private:
+		struct StreamedTexture
+		{
+			std::weak_ptr<Gfx_Texture> myTexture;
+			TextureCreateDesc myDesc;
+			std::vector<uint8_t> myData;
+			std::vector<VkBufferImageCopy> myRegions;
+			uint32_t myResidentMip = 0;
+			uint32_t myRequestedMip = 0;
+			uint32_t myTailMip = 0;
+			uint64_t myLastRequestFrame = 0;
+			bool myIsUploading = false;
+		};
+
+		struct RetiredStorage
+		{
+			Ref<Gfx_PixelStorage> myStorage;
+			uint64_t myFrame;
+		};
+
+		struct PendingUpload
+		{
+			std::weak_ptr<Gfx_Texture> myTexture;
+			Ref<Gfx_PixelStorage> myStorage;
+			std::vector<VkBufferImageCopy> myRegions;
+			uint32_t myMip = 0;
+		};
+
+		struct UploadBatch
+		{
+			std::vector<PendingUpload> myUploads;
+			Ref<Gfx_Buffer> myStaging;
+			Ref<Gfx_CmdBuffer> myCmd;
+			VkFence myFence = nullptr;
+		};
+
+		void ReadFeedback();
+		void UpdateResidency();
+		// Creates the storage for the levels from mip on and queues its upload, the texture keeps its current levels until then
+		void SetResidentMip(StreamedTexture& entry, uint32_t mip);
+		void SubmitUploads();
+		// Swaps in the storage of finished batches and patches descriptors still holding the old image view
+		void RetireUploads(bool wait);
+		VkDeviceSize GetLevelsSize(const StreamedTexture& entry, uint32_t firstMip) const;
+		int64_t GetHeadroom() const;
+
+		std::vector<StreamedTexture> m_Textures;
+		std::vector<RetiredStorage> m_Retired;
+		std::vector<UploadBatch> m_Batches;
+		// Recorded by SetResidentMip, submitted at the end of the frame
+		std::vector<PendingUpload> m_Uploads;
+		std::vector<uint8_t> m_StagingData;
+		std::vector<Ref<Gfx_Buffer>> m_FeedbackBuffers;
+		VkDeviceSize m_Budget;
+		VkDeviceSize m_ResidentBytes;
+		uint32_t m_FrameIndex;
+		uint64_t m_FrameCount;
+	};
+}
@@ -16,6 +16,7 @@
 #include "Backend/Gfx_VulkanImGui.h"
 
 #include <functional>
+#include <chrono>
 
 namespace SmolEngine
 {
@@ -28,6 +29,10 @@ namespace SmolEngine
 		WindowCreateDesc* myWindowDesc = nullptr;
 		FeaturesFlags myFeaturesFlags = FeaturesFlags::ImguiEnable | FeaturesFlags::RendererEnable;
 		std::string myAssetPath = "";
+		// No window, swapchain or ImGui, frames render into offscreen framebuffers and SwapBuffers only submits and waits
+		bool myIsHeadless = false;
+		// Size of the default framebuffer, myWindowDesc may be null when headless
+		glm::uvec2 myHeadlessSize = { 1280, 720 };
 	};
 
 	class Gfx_App
@@ -52,6 +57,9 @@ namespace SmolEngine
 		static Gfx_VulkanDevice& GetDevice();
 		static Gfx_App* GetSingleton();
 		static Gfx_CmdBuffer* GetCommandBuffer();
+		static uint32_t GetFrameIndex();
+		static uint32_t GetFramesInFlight();
+		static bool IsHeadless();
 
 		Ref<Gfx_Framebuffer> GetFramebuffer();
 		Gfx_Window* GetWindow() const;
@@ -65,7 +73,9 @@ namespace SmolEngine
 									      
 	private:
 		void CreateAPIContext();
+		void SubmitHeadless();
 		void OnEvent(Gfx_Event& event);
+		float GetTime() const;
 
 	private:
 		static Gfx_App* s_Instance;
@@ -90,6 +100,8 @@ namespace SmolEngine
 		GpuCrashTracker m_CrachTracker{};
 #endif
 		std::string m_Root;
+		std::chrono::steady_clock::time_point m_StartTime;
+		uint32_t m_FrameIndex = 0;
 		float m_LastFrameTime = 1.0f;
 		float m_DeltaTime = 0.0f;
 		bool m_bWindowMinimized = false;
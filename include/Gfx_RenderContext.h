@@ -2,13 +2,26 @@
 #include "Common/Gfx_Framebuffer.h"
 #include "Common/Gfx_Pipeline.h"
 #include "Common/Gfx_Texture.h"
+#include "Common/Gfx_TextureLoader.h"
+#include "Common/Gfx_MipGenerator.h"
+#include "Common/Gfx_TextureStreamer.h"
+#include "Common/Gfx_TextureCache.h"
+#include "Common/Gfx_Readback.h"
+#include "Common/Gfx_GpuProfiler.h"
+#include "Common/Gfx_QueryManager.h"
 #include "Common/Gfx_Descriptor.h"
+#include "Common/Gfx_DescriptorAllocator.h"
+#include "Common/Gfx_DescriptorBuffer.h"
+#include "Common/Gfx_BindlessHeap.h"
+#include "Common/Gfx_BufferArena.h"
 #include "Common/Gfx_Shader.h"
 #include "Common/Gfx_Sampler.h"
 #include "Common/Gfx_VertexBuffer.h"
 #include "Common/Gfx_IndexBuffer.h"
 #include "Common/Gfx_Mesh.h"
 
+#include <mutex>
+
 namespace SmolEngine
 {
 	struct Gfx_RenderPass
@@ -19,6 +32,8 @@ namespace SmolEngine
 		Ref<Gfx_Descriptor> myDescriptor;
 
 		Ref<Gfx_CmdBuffer> myCmd;
+		// Times the pass in the GPU profiler and collects its pipeline statistics unless empty
+		std::string myName;
 	};
 
 	struct RayDispatchDesc
@@ -35,13 +50,17 @@ namespace SmolEngine
 		Gfx_RenderContext();
 
 	public:
+		~Gfx_RenderContext();
 
 		void CmdBeginRenderPass(const Ref<Gfx_RenderPass>& renderPass);
 		void CmdEndRenderPass(const Ref<Gfx_RenderPass>& renderPass);
 
 		void CmdPushConstants(const Ref<Gfx_RenderPass>& renderPass, ShaderStage stage, uint32_t size, const void* data);
+		// Binds only the set index of the descriptor, sets below and above stay bound
 		void CmdBindDescriptor(const Ref<Gfx_RenderPass>& renderPass, const Ref<Gfx_Descriptor>& another = nullptr);
+		void CmdBindDescriptors(const Ref<Gfx_RenderPass>& renderPass, const std::vector<Ref<Gfx_Descriptor>>& descriptors);
 		void CmdBindPipeline(const Ref<Gfx_RenderPass>& renderPass);
+		void CmdPushDescriptor(const Ref<Gfx_RenderPass>& renderPass, const std::vector<DescriptorWrite>& writes, const Ref<Gfx_Descriptor>& another = nullptr);
 
 		void CmdRayDispatch(const Ref<Gfx_RenderPass>& renderPass, RayDispatchDesc* desc);
 		void CmdDispatch(const Ref<Gfx_RenderPass>& renderPass, uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ = 1);
@@ -50,16 +69,23 @@ namespace SmolEngine
 		void CmdDrawMeshIndexed(const Ref<Gfx_RenderPass>& renderPass, const Ref<Gfx_Mesh>& mesh, uint32_t instances = 1);
 
 		void CmdDraw(const Ref<Gfx_RenderPass>& renderPass, uint32_t vertexCount);
-		void CmdDraw(const Ref<Gfx_RenderPass>& renderPass, const Ref<Gfx_VertexBuffer> & = nullptr);
+		void CmdDraw(const Ref<Gfx_RenderPass>& renderPass, const Ref<Gfx_VertexBuffer>& vb);
 		void CmdDrawMesh(const Ref<Gfx_RenderPass>& renderPass, const Ref<Gfx_Mesh>& mesh, uint32_t instances = 1);
 
+		// Samples that pass the depth test between the two calls, read back through GetQueryManager().GetOcclusion(id)
+		void CmdBeginOcclusionQuery(const Ref<Gfx_RenderPass>& renderPass, uint64_t id);
+		void CmdEndOcclusionQuery(const Ref<Gfx_RenderPass>& renderPass);
+
 		static Ref<Gfx_Buffer> CreateBuffer(BufferCreateDesc& desc, const std::string& debugName = "");
 		static Ref<Gfx_Shader> CreateShader(ShaderCreateDesc& desc, const std::string& debugName = "");
 
 		static Ref<Gfx_Framebuffer> CreateFramebuffer(FramebufferCreateDesc& desc, const std::string& debugName = "");
 		static Ref<Gfx_Descriptor> CreateDescriptor(DescriptorCreateDesc& desc, const std::string& debugName = "");
 
+		// Textures with myFilePath are shared through the texture cache
 		static Ref<Gfx_Texture> CreateTexture(TextureCreateDesc& desc, const std::string& debugName = "");
+		// Returns immediately with the placeholder bound, the file is decoded and uploaded in the background
+		static Ref<Gfx_Texture> CreateTextureAsync(const TextureCreateDesc& desc);
 		static Ref<Gfx_Sampler> CreateSampler(SamplerCreateDesc& desc, const std::string& debugname = "");
 
 		static Ref<Gfx_Mesh> CreateMesh(const std::string& filePath, const TransformDesc& transform, const std::string& debugNane = "");
@@ -70,13 +96,56 @@ namespace SmolEngine
 		static Ref<Gfx_Pipeline> CreateRaytarcingPipeline(RaytracingPipelineCreateDesc& desc, const std::string& debugName = "");
 
 		static Ref<Gfx_Sampler> GetDefaultSampler();
-
+		static Ref<Gfx_Texture> GetPlaceholderTexture();
+		static Gfx_TextureLoader& GetTextureLoader();
+		static Gfx_MipGenerator& GetMipGenerator();
+		static Gfx_TextureStreamer& GetTextureStreamer();
+		static Gfx_TextureCache& GetTextureCache();
+		static Gfx_ReadbackQueue& GetReadbackQueue();
+		static Gfx_GpuProfiler& GetGpuProfiler();
+		static Gfx_QueryManager& GetQueryManager();
+		static Gfx_DescriptorAllocator& GetDescriptorAllocator();
+		static Gfx_BindlessHeap& GetBindlessHeap();
+		// Not good unless the device supports VK_EXT_descriptor_buffer
+		static Gfx_DescriptorBuffer& GetDescriptorBuffer();
+		// Static vertex and index buffers are views into the geometry arena, small uniform buffers from CreateBuffer into the uniform one
+		static Gfx_BufferArena& GetGeometryArena();
+		static Gfx_BufferArena& GetUniformArena();
+
+		// Shader modules are shared between shaders with identical SPIR-V
+		static VkShaderModule AcquireShaderModule(const std::vector<uint32_t>& binary);
+		static void ReleaseShaderModule(VkShaderModule shaderModule);
 
 		static Gfx_RenderContext* s_Instance;
 
 	private:
-
+		struct ShaderModuleEntry
+		{
+			VkShaderModule myModule = nullptr;
+			uint32_t myRefCount = 0;
+			std::vector<uint32_t> myBinary;
+		};
+
+		// First so that they outlive every view held by the members below
+		Gfx_BufferArena m_GeometryArena;
+		Gfx_BufferArena m_UniformArena;
 		Ref<Gfx_Sampler> m_DefaultSampler;
+		Ref<Gfx_Texture> m_PlaceholderTexture;
+		Gfx_TextureLoader m_TextureLoader;
+		Gfx_MipGenerator m_MipGenerator;
+		Gfx_TextureStreamer m_TextureStreamer;
+		Gfx_TextureCache m_TextureCache;
+		Gfx_ReadbackQueue m_ReadbackQueue;
+		Gfx_GpuProfiler m_GpuProfiler;
+		Gfx_QueryManager m_QueryManager;
+		Gfx_DescriptorAllocator m_DescriptorAllocator;
+		Gfx_DescriptorBuffer m_DescriptorBuffer;
+		Gfx_BindlessHeap m_BindlessHeap;
+		uint32_t m_RelocationListener;
+
+		std::mutex m_ShaderModuleMutex;
+		std::unordered_map<std::string, ShaderModuleEntry> m_ShaderModules;
+		std::unordered_map<VkShaderModule, std::string> m_ShaderModuleKeys;
 
 		std::map<std::string, Ref<Gfx_Shader>> m_Shaders;
 		std::map<std::string, Ref<Gfx_Pipeline>> m_Pipelines;
@@ -11,18 +11,31 @@ namespace SmolEngine
 		std::map<std::string, bool> myDefines;
 		bool myOptimize = true;
 		bool myDebug = false;
+		ShaderOptimization myOptimization = ShaderOptimization::None;
+		bool myStripDebugInfo = false;
 	};
 
 	class Gfx_ShaderCompiler
 	{
 	public:
-		static void CompileSPIRV(const ShaderCompileDesc& desc, std::vector<uint32_t>& out_binaries);
+		// False if the source failed to compile, nothing is written to the cache then
+		static bool CompileSPIRV(const ShaderCompileDesc& desc, std::vector<uint32_t>& out_binaries, ShaderReflection& out_reflection,
+			ShaderCompileStats* out_stats = nullptr);
 		static void LoadSPIRV(const std::string& path, std::vector<uint32_t>& out_binaries);
+		static std::string GetCachedPath(const ShaderCompileDesc& desc, CachedPathType type);
+
+		static void OptimizeSPIRV(ShaderOptimization optimization, std::vector<uint32_t>& binaries);
+		static void StripSPIRV(std::vector<uint32_t>& binaries);
+		static uint32_t GetInstructionCount(const std::vector<uint32_t>& binaries);
+
+		static void ReflectSPIRV(const std::vector<uint32_t>& binaries, ShaderStage stage, ShaderReflection& out_reflection);
+		static bool LoadReflection(const std::string& path, ShaderReflection& out_reflection);
+		static void SaveReflection(const std::string& path, const ShaderReflection& reflection);
 
 		static void SpirvToGlsl(const ShaderCompileDesc& desc);
 		static void SpirvToHlsl(const ShaderCompileDesc& desc);
 
-		static void GlslToSpirv(const ShaderCompileDesc& desc, std::vector<uint32_t>& out_binaries);
-		static void HlslToSpirv(const ShaderCompileDesc& desc, std::vector<uint32_t>& out_binaries);
+		static bool GlslToSpirv(const ShaderCompileDesc& desc, std::vector<uint32_t>& out_binaries);
+		static bool HlslToSpirv(const ShaderCompileDesc& desc, std::vector<uint32_t>& out_binaries);
 	};
 }
\ No newline at end of file
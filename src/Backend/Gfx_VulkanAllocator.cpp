@@ -2,22 +2,205 @@
 #include "Backend/Gfx_VulkanAllocator.h"
 #include "Backend/Gfx_VulkanDevice.h"
 #include "Backend/Gfx_VulkanInstance.h"
+#include "Backend/Gfx_VulkanHelpers.h"
+#include "Common/Gfx_CmdBuffer.h"
 
 #include <vulkan_memory_allocator/vk_mem_alloc.h>
+#include <format>
+#include <chrono>
 
 namespace SmolEngine
 {
 	Gfx_VulkanAllocator* Gfx_VulkanAllocator::s_Instance = nullptr;
 
+	// Keeps each pass, and so each wait on the copy submission, short enough to stop close to the budget
+	static const VkDeviceSize s_DefragmentBytesPerPass = 64 * 1024 * 1024;
+	static const uint32_t s_DefragmentAllocationsPerPass = 256;
+	static const VkDeviceSize s_TransientBlockSize = 64 * 1024 * 1024;
+
+	static MemoryCategory locGetBufferCategory(const VkBufferCreateInfo& ci, VmaMemoryUsage usage)
+	{
+		if (ci.usage & VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_STORAGE_BIT_KHR)
+			return MemoryCategory::AccelStructure;
+
+		const VkBufferUsageFlags transferUsage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+		if (usage != VMA_MEMORY_USAGE_GPU_ONLY && (ci.usage & ~transferUsage) == 0)
+			return MemoryCategory::Staging;
+
+		return MemoryCategory::Buffer;
+	}
+
+	// The category travels in the allocation's user data so frees don't need to be told what they free
+	static void locOnAllocated(VmaAllocation allocation)
+	{
+		VmaAllocationInfo allocInfo{};
+		vmaGetAllocationInfo(Gfx_VulkanAllocator::s_Instance->m_Allocator, allocation, &allocInfo);
+
+		const uint32_t category = static_cast<uint32_t>(reinterpret_cast<uintptr_t>(allocInfo.pUserData));
+		Gfx_VulkanAllocator::s_Instance->m_AllocationCount.fetch_add(1, std::memory_order_relaxed);
+		Gfx_VulkanAllocator::s_Instance->m_CategoryCount[category].fetch_add(1, std::memory_order_relaxed);
+		Gfx_VulkanAllocator::s_Instance->m_CategoryBytes[category].fetch_add(allocInfo.size, std::memory_order_relaxed);
+	}
+
+	static void locOnFreed(VmaAllocation allocation)
+	{
+		if (allocation == nullptr)
+			return;
+
+		VmaAllocationInfo allocInfo{};
+		vmaGetAllocationInfo(Gfx_VulkanAllocator::s_Instance->m_Allocator, allocation, &allocInfo);
+
+		const uint32_t category = static_cast<uint32_t>(reinterpret_cast<uintptr_t>(allocInfo.pUserData));
+		Gfx_VulkanAllocator::s_Instance->m_CategoryCount[category].fetch_sub(1, std::memory_order_relaxed);
+		Gfx_VulkanAllocator::s_Instance->m_CategoryBytes[category].fetch_sub(allocInfo.size, std::memory_order_relaxed);
+	}
+
+	static void locOnFailed(const std::string& what, VkResult result)
+	{
+		VkDeviceSize usage = 0;
+		VkDeviceSize budget = 0;
+		Gfx_VulkanAllocator::GetDeviceLocalBudget(usage, budget);
+
+		std::string message = std::format("[VMA]: failed to allocate {}, result = {}, device local usage = {} / {} MB",
+			what, static_cast<int32_t>(result), usage >> 20, budget >> 20);
+		GFX_LOG(message, Gfx_Log::Level::Error)
+	}
+
+	static VmaPool locCreatePool(MemoryPool pool, uint32_t memoryTypeIndex)
+	{
+		// Other pools leave block sizes to VMA, which also makes allocations too large for a block dedicated.
+		// Geometry keeps the default TLSF algorithm in place of a buddy allocator, which VMA 3 removed
+		VmaPoolCreateInfo poolInfo{};
+		poolInfo.memoryTypeIndex = memoryTypeIndex;
+
+		// The linear algorithm only works as a ring buffer with a single block, requests that do not fit fall back to the default pool
+		if (pool == MemoryPool::Transient)
+		{
+			poolInfo.flags = VMA_POOL_CREATE_LINEAR_ALGORITHM_BIT;
+			poolInfo.blockSize = s_TransientBlockSize;
+			poolInfo.maxBlockCount = 1;
+		}
+
+		VmaPool vmaPool = nullptr;
+		VK_CHECK_RESULT(vmaCreatePool(Gfx_VulkanAllocator::s_Instance->m_Allocator, &poolInfo, &vmaPool));
+		return vmaPool;
+	}
+
+	// The memory type only depends on the pool class, the memory usage and the resource usage flags, so it is found once per combination
+	template<typename FindMemoryType>
+	static void locSetPool(VmaAllocationCreateInfo& allocCreateInfo, MemoryPool pool, uint64_t usageKey, FindMemoryType&& findMemoryType)
+	{
+		if (pool == MemoryPool::Default)
+			return;
+
+		if (pool == MemoryPool::Dedicated)
+		{
+			allocCreateInfo.flags |= VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT;
+			return;
+		}
+
+		Gfx_VulkanAllocator* instance = Gfx_VulkanAllocator::s_Instance;
+		std::lock_guard<std::mutex> lock(instance->m_PoolMutex);
+
+		const uint64_t typeKey = usageKey | (static_cast<uint64_t>(allocCreateInfo.usage) << 40);
+		auto typeIt = instance->m_MemoryTypes.find(typeKey);
+		if (typeIt == instance->m_MemoryTypes.end())
+		{
+			uint32_t memoryTypeIndex = 0;
+			if (findMemoryType(memoryTypeIndex) != VK_SUCCESS)
+				return;
+
+			typeIt = instance->m_MemoryTypes.emplace(typeKey, memoryTypeIndex).first;
+		}
+
+		const uint64_t poolKey = (static_cast<uint64_t>(pool) << 32) | typeIt->second;
+		auto poolIt = instance->m_Pools.find(poolKey);
+		if (poolIt == instance->m_Pools.end())
+			poolIt = instance->m_Pools.emplace(poolKey, locCreatePool(pool, typeIt->second)).first;
+
+		allocCreateInfo.pool = poolIt->second;
+	}
+
+	static void locMemoryBarrier(VkCommandBuffer cmd, VkPipelineStageFlags srcStage, VkAccessFlags srcAccess, VkPipelineStageFlags dstStage, VkAccessFlags dstAccess)
+	{
+		VkMemoryBarrier barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		barrier.srcAccessMask = srcAccess;
+		barrier.dstAccessMask = dstAccess;
+
+		vkCmdPipelineBarrier(cmd, srcStage, dstStage, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+	}
+
+	// Copies the registered allocations of one pass, moves without an owner or refused by it are skipped
+	static void locRelocatePass(VmaDefragmentationPassMoveInfo& passInfo)
+	{
+		Gfx_VulkanAllocator* instance = Gfx_VulkanAllocator::s_Instance;
+
+		Gfx_CmdBuffer cmdBuffer{};
+		CmdBufferCreateDesc cmdDesc{};
+		cmdBuffer.Create(&cmdDesc);
+		cmdBuffer.CmdBeginRecord();
+
+		VkCommandBuffer cmd = cmdBuffer.GetBuffer();
+		locMemoryBarrier(cmd, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_ACCESS_MEMORY_WRITE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT);
+
+		std::vector<Gfx_Relocatable*> owners;
+		{
+			std::lock_guard<std::mutex> lock(instance->m_RelocationMutex);
+			for (uint32_t i = 0; i < passInfo.moveCount; ++i)
+			{
+				VmaDefragmentationMove& move = passInfo.pMoves[i];
+
+				const auto& it = instance->m_Relocatables.find(move.srcAllocation);
+				if (it == instance->m_Relocatables.end() || !it->second->CmdRelocate(cmd, move.dstTmpAllocation))
+				{
+					move.operation = VMA_DEFRAGMENTATION_MOVE_OPERATION_IGNORE;
+					continue;
+				}
+
+				owners.push_back(it->second);
+			}
+		}
+
+		locMemoryBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT);
+		cmdBuffer.CmdEndRecord();
+		Gfx_VulkanHelpers::ExecuteCmdBuffer(&cmdBuffer);
+
+		if (owners.empty())
+			return;
+
+		// The old resources go away before VMA releases their memory, then whatever copied their handles is patched
+		MemoryRelocations relocations;
+		for (Gfx_Relocatable* owner : owners)
+			owner->OnRelocated(relocations);
+
+		std::vector<RelocationListener> listeners;
+		{
+			std::lock_guard<std::mutex> lock(instance->m_RelocationMutex);
+			for (const auto& [id, listener] : instance->m_RelocationListeners)
+				listeners.push_back(listener);
+		}
+
+		for (const RelocationListener& listener : listeners)
+			listener(relocations);
+	}
+
 	Gfx_VulkanAllocator::Gfx_VulkanAllocator() :
 		m_Allocator{ nullptr },
-		m_TotalAllocatedBytes{ 0 }
+		m_AllocationCount{ 0 },
+		m_CategoryCount{},
+		m_CategoryBytes{},
+		m_NextListener{ 0 }
 	{
 		s_Instance = this;
 	}
 
 	Gfx_VulkanAllocator::~Gfx_VulkanAllocator()
 	{
+		for (auto& [key, pool] : m_Pools)
+			vmaDestroyPool(m_Allocator, pool);
+
+		m_Pools.clear();
 		vmaDestroyAllocator(m_Allocator);
 		s_Instance = nullptr;
 	}
@@ -30,80 +213,92 @@ namespace SmolEngine
 		allocatorInfo.device = device->GetLogicalDevice();
 		allocatorInfo.instance = instance->GetInstance();
 
-		if(device->GetRaytracingSupport())
-			allocatorInfo.flags = VMA_ALLOCATOR_CREATE_BUFFER_DEVICE_ADDRESS_BIT;
+		if(device->GetRaytracingSupport() || device->GetDescriptorBufferSupport())
+			allocatorInfo.flags |= VMA_ALLOCATOR_CREATE_BUFFER_DEVICE_ADDRESS_BIT;
+
+		// Without it VMA estimates the budget as 80% of the heap size and the usage from its own blocks only
+		if (device->GetMemoryBudgetSupport())
+			allocatorInfo.flags |= VMA_ALLOCATOR_CREATE_EXT_MEMORY_BUDGET_BIT;
 
 		vmaCreateAllocator(&allocatorInfo, &m_Allocator);
 	}
 
-	VmaAllocation Gfx_VulkanAllocator::AllocBuffer(VkBufferCreateInfo ci, VmaMemoryUsage usage, VkBuffer& outBuffer)
+	VmaAllocation Gfx_VulkanAllocator::AllocBuffer(VkBufferCreateInfo ci, VmaMemoryUsage usage, VkBuffer& outBuffer, MemoryPool pool)
 	{
 		VmaAllocationCreateInfo allocCreateInfo = {};
 		allocCreateInfo.usage = usage;
+		allocCreateInfo.pUserData = reinterpret_cast<void*>(static_cast<uintptr_t>(locGetBufferCategory(ci, usage)));
 
-		VmaAllocation allocation;
-		vmaCreateBuffer(s_Instance->m_Allocator, &ci, &allocCreateInfo, &outBuffer, &allocation, nullptr);
+		locSetPool(allocCreateInfo, pool, ci.usage, [&](uint32_t& outIndex)
+		{
+			return vmaFindMemoryTypeIndexForBufferInfo(s_Instance->m_Allocator, &ci, &allocCreateInfo, &outIndex);
+		});
 
-		VmaAllocationInfo allocInfo{};
-		vmaGetAllocationInfo(s_Instance->m_Allocator, allocation, &allocInfo);
+		VmaAllocation allocation = nullptr;
+		VkResult result = vmaCreateBuffer(s_Instance->m_Allocator, &ci, &allocCreateInfo, &outBuffer, &allocation, nullptr);
+		if (result != VK_SUCCESS && allocCreateInfo.pool != nullptr)
+		{
+			// The pool is full or its memory type is exhausted, any compatible memory type will do
+			allocCreateInfo.pool = nullptr;
+			result = vmaCreateBuffer(s_Instance->m_Allocator, &ci, &allocCreateInfo, &outBuffer, &allocation, nullptr);
+		}
 
-#ifdef SMOLENGINE_DEBUG
-		s_Instance->m_TotalAllocatedBytes += allocInfo.size;
+		if (result != VK_SUCCESS)
+		{
+			locOnFailed(std::format("buffer; size = {}", ci.size), result);
+			return nullptr;
+		}
 
-		std::stringstream ss;
-		ss << "[VMA]: allocating buffer; size = " << std::to_string(allocInfo.size) << ", pool size = " << std::to_string(s_Instance->m_TotalAllocatedBytes);
-		GFX_LOG(ss.str(), Gfx_Log::Level::Info)
-#endif 
+		locOnAllocated(allocation);
 		return allocation;
 	}
 
-	VmaAllocation Gfx_VulkanAllocator::AllocImage(VkImageCreateInfo ci, VmaMemoryUsage usage, VkImage& outImage)
+	VmaAllocation Gfx_VulkanAllocator::AllocImage(VkImageCreateInfo ci, VmaMemoryUsage usage, VkImage& outImage, MemoryPool pool)
 	{
 		VmaAllocationCreateInfo allocCreateInfo = {};
 		allocCreateInfo.usage = usage;
+		allocCreateInfo.pUserData = reinterpret_cast<void*>(static_cast<uintptr_t>(MemoryCategory::Image));
 
-		VmaAllocation allocation;
-		vmaCreateImage(s_Instance->m_Allocator, &ci, &allocCreateInfo, &outImage, &allocation, nullptr);
-		VmaAllocationInfo allocInfo;
-		vmaGetAllocationInfo(s_Instance->m_Allocator, allocation, &allocInfo);
+		// Images are keyed apart from buffers with the same usage bits, tiling changes the memory types they accept
+		const uint64_t usageKey = (1ull << 63) | (static_cast<uint64_t>(ci.tiling) << 48) | ci.usage;
+		locSetPool(allocCreateInfo, pool, usageKey, [&](uint32_t& outIndex)
+		{
+			return vmaFindMemoryTypeIndexForImageInfo(s_Instance->m_Allocator, &ci, &allocCreateInfo, &outIndex);
+		});
 
-#ifdef SMOLENGINE_DEBUG
-		s_Instance->m_TotalAllocatedBytes += allocInfo.size;
+		VmaAllocation allocation = nullptr;
+		VkResult result = vmaCreateImage(s_Instance->m_Allocator, &ci, &allocCreateInfo, &outImage, &allocation, nullptr);
+		if (result != VK_SUCCESS && allocCreateInfo.pool != nullptr)
+		{
+			allocCreateInfo.pool = nullptr;
+			result = vmaCreateImage(s_Instance->m_Allocator, &ci, &allocCreateInfo, &outImage, &allocation, nullptr);
+		}
 
-		std::stringstream ss;
-		ss << "[VMA]: allocating image; size = " << std::to_string(allocInfo.size) << ", pool size = " << std::to_string(s_Instance->m_TotalAllocatedBytes);
-		GFX_LOG(ss.str(), Gfx_Log::Level::Info)
-#endif
+		if (result != VK_SUCCESS)
+		{
+			locOnFailed(std::format("image; extent = {}x{}x{}", ci.extent.width, ci.extent.height, ci.extent.depth), result);
+			return nullptr;
+		}
+
+		locOnAllocated(allocation);
 		return allocation;
 	}
 
 	void Gfx_VulkanAllocator::AllocFree(VmaAllocation allocation)
 	{
-#ifdef SMOLENGINE_DEBUG
-		VmaAllocationInfo allocInfo;
-		vmaGetAllocationInfo(s_Instance->m_Allocator, allocation, &allocInfo);
-		s_Instance->m_TotalAllocatedBytes -= allocInfo.size;
-#endif
+		locOnFreed(allocation);
 		vmaFreeMemory(s_Instance->m_Allocator, allocation);
 	}
 
 	void Gfx_VulkanAllocator::FreeImage(VkImage image, VmaAllocation allocation)
 	{
-#ifdef SMOLENGINE_DEBUG
-		VmaAllocationInfo allocInfo;
-		vmaGetAllocationInfo(s_Instance->m_Allocator, allocation, &allocInfo);
-		s_Instance->m_TotalAllocatedBytes -= allocInfo.size;
-#endif
+		locOnFreed(allocation);
 		vmaDestroyImage(s_Instance->m_Allocator, image, allocation);
 	}
 
 	void Gfx_VulkanAllocator::FreeBuffer(VkBuffer buffer, VmaAllocation allocation)
 	{
-#ifdef SMOLENGINE_DEBUG
-		VmaAllocationInfo allocInfo;
-		vmaGetAllocationInfo(s_Instance->m_Allocator, allocation, &allocInfo);
-		s_Instance->m_TotalAllocatedBytes -= allocInfo.size;
-#endif
+		locOnFreed(allocation);
 		vmaDestroyBuffer(s_Instance->m_Allocator, buffer, allocation);
 	}
 
@@ -119,8 +314,220 @@ namespace SmolEngine
 		return mappedMemory;
 	}
 
+	void Gfx_VulkanAllocator::InvalidateMemory(VmaAllocation allocation)
+	{
+		VK_CHECK_RESULT(vmaInvalidateAllocation(s_Instance->m_Allocator, allocation, 0, VK_WHOLE_SIZE));
+	}
+
+	void Gfx_VulkanAllocator::FlushMemory(VmaAllocation allocation, VkDeviceSize offset, VkDeviceSize size)
+	{
+		VK_CHECK_RESULT(vmaFlushAllocation(s_Instance->m_Allocator, allocation, offset, size));
+	}
+
 	void Gfx_VulkanAllocator::GetAllocInfo(VmaAllocation allocation, VmaAllocationInfo*& outInfo)
 	{
 		vmaGetAllocationInfo(s_Instance->m_Allocator, allocation, outInfo);
 	}
-}
\ No newline at end of file
+
+	uint64_t Gfx_VulkanAllocator::GetAllocationCount()
+	{
+		return s_Instance->m_AllocationCount.load();
+	}
+
+	MemoryCategoryStats Gfx_VulkanAllocator::GetCategoryStats(MemoryCategory category)
+	{
+		const uint32_t index = static_cast<uint32_t>(category);
+
+		MemoryCategoryStats stats{};
+		stats.myCount = s_Instance->m_CategoryCount[index].load(std::memory_order_relaxed);
+		stats.myBytes = s_Instance->m_CategoryBytes[index].load(std::memory_order_relaxed);
+		return stats;
+	}
+
+	uint64_t Gfx_VulkanAllocator::GetTotalAllocatedBytes()
+	{
+		uint64_t bytes = 0;
+		for (const std::atomic<uint64_t>& categoryBytes : s_Instance->m_CategoryBytes)
+			bytes += categoryBytes.load(std::memory_order_relaxed);
+
+		return bytes;
+	}
+
+	void Gfx_VulkanAllocator::GetHeapStats(std::vector<MemoryHeapStats>& outHeaps)
+	{
+		const VkPhysicalDeviceMemoryProperties* memoryProperties = Gfx_App::GetDevice().GetMemoryProperties();
+
+		// Budgets are cached by VMA and refreshed from the driver every few allocations, this doesn't walk any block
+		VmaBudget budgets[VK_MAX_MEMORY_HEAPS] = {};
+		vmaGetHeapBudgets(s_Instance->m_Allocator, budgets);
+
+		outHeaps.resize(memoryProperties->memoryHeapCount);
+		for (uint32_t i = 0; i < memoryProperties->memoryHeapCount; ++i)
+		{
+			MemoryHeapStats& heap = outHeaps[i];
+			heap.myUsage = budgets[i].usage;
+			heap.myBudget = budgets[i].budget;
+			heap.myBlockBytes = budgets[i].statistics.blockBytes;
+			heap.myAllocationBytes = budgets[i].statistics.allocationBytes;
+			heap.myBlockCount = budgets[i].statistics.blockCount;
+			heap.myAllocationCount = budgets[i].statistics.allocationCount;
+			heap.myIsDeviceLocal = (memoryProperties->memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) != 0;
+		}
+	}
+
+	std::string Gfx_VulkanAllocator::BuildStatsString(bool detailed)
+	{
+		char* statsString = nullptr;
+		vmaBuildStatsString(s_Instance->m_Allocator, &statsString, detailed ? VK_TRUE : VK_FALSE);
+
+		std::string result = statsString != nullptr ? statsString : "";
+		vmaFreeStatsString(s_Instance->m_Allocator, statsString);
+		return result;
+	}
+
+	bool Gfx_VulkanAllocator::DumpStats(const std::string& filePath, bool detailed)
+	{
+		std::ofstream file(filePath);
+		if (!file.is_open())
+		{
+			std::string message = "[VMA]: failed to write " + filePath;
+			GFX_LOG(message, Gfx_Log::Level::Error)
+			return false;
+		}
+
+		file << BuildStatsString(detailed);
+		return true;
+	}
+
+	void Gfx_VulkanAllocator::GetDeviceLocalBudget(VkDeviceSize& outUsage, VkDeviceSize& outBudget)
+	{
+		const VkPhysicalDeviceMemoryProperties* memoryProperties = Gfx_App::GetDevice().GetMemoryProperties();
+
+		VmaBudget budgets[VK_MAX_MEMORY_HEAPS] = {};
+		vmaGetHeapBudgets(s_Instance->m_Allocator, budgets);
+
+		outUsage = 0;
+		outBudget = 0;
+		for (uint32_t i = 0; i < memoryProperties->memoryHeapCount; ++i)
+		{
+			if ((memoryProperties->memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) == 0)
+				continue;
+
+			outUsage += budgets[i].usage;
+			outBudget += budgets[i].budget;
+		}
+	}
+
+	DefragmentStats Gfx_VulkanAllocator::Defragment(float budgetMs)
+	{
+		GFX_PROFILE_FUNCTION()
+
+		using Clock = std::chrono::steady_clock;
+		const Clock::time_point start = Clock::now();
+		auto getElapsed = [&start]() { return std::chrono::duration<float, std::milli>(Clock::now() - start).count(); };
+
+		// Frames in flight may still use the resources about to move
+		VK_CHECK_RESULT(vkDeviceWaitIdle(Gfx_App::GetDevice().GetLogicalDevice()));
+
+		// The default pools and the geometry pools, linear pools can't be defragmented and dedicated memory never moves
+		std::vector<VmaPool> pools = { nullptr };
+		{
+			std::lock_guard<std::mutex> lock(s_Instance->m_PoolMutex);
+			for (const auto& [key, pool] : s_Instance->m_Pools)
+			{
+				if ((key >> 32) == static_cast<uint64_t>(MemoryPool::Geometry))
+					pools.push_back(pool);
+			}
+		}
+
+		DefragmentStats result{};
+		result.myIsComplete = true;
+
+		for (VmaPool pool : pools)
+		{
+			VmaDefragmentationInfo defragmentInfo{};
+			defragmentInfo.pool = pool;
+			defragmentInfo.maxBytesPerPass = s_DefragmentBytesPerPass;
+			defragmentInfo.maxAllocationsPerPass = s_DefragmentAllocationsPerPass;
+
+			VmaDefragmentationContext context = nullptr;
+			if (vmaBeginDefragmentation(s_Instance->m_Allocator, &defragmentInfo, &context) != VK_SUCCESS)
+				continue;
+
+			bool isDone = false;
+			while (!isDone && getElapsed() < budgetMs)
+			{
+				VmaDefragmentationPassMoveInfo passInfo{};
+				if (vmaBeginDefragmentationPass(s_Instance->m_Allocator, context, &passInfo) == VK_SUCCESS)
+				{
+					isDone = true;
+					break;
+				}
+
+				locRelocatePass(passInfo);
+				isDone = vmaEndDefragmentationPass(s_Instance->m_Allocator, context, &passInfo) == VK_SUCCESS;
+				result.myPasses++;
+			}
+
+			VmaDefragmentationStats stats{};
+			vmaEndDefragmentation(s_Instance->m_Allocator, context, &stats);
+
+			result.myBytesMoved += stats.bytesMoved;
+			result.myBytesFreed += stats.bytesFreed;
+			result.myAllocationsMoved += stats.allocationsMoved;
+			result.myBlocksFreed += stats.deviceMemoryBlocksFreed;
+			result.myIsComplete &= isDone;
+		}
+
+		result.myTime = getElapsed();
+
+		std::string message = std::format("[VMA]: defragmented in {:.2f} ms; moved = {} bytes ({} allocations), freed = {} bytes ({} blocks)",
+			result.myTime, result.myBytesMoved, result.myAllocationsMoved, result.myBytesFreed, result.myBlocksFreed);
+		GFX_LOG(message, Gfx_Log::Level::Info)
+
+		return result;
+	}
+
+	void Gfx_VulkanAllocator::RegisterRelocatable(VmaAllocation allocation, Gfx_Relocatable* owner)
+	{
+		std::lock_guard<std::mutex> lock(s_Instance->m_RelocationMutex);
+		s_Instance->m_Relocatables[allocation] = owner;
+	}
+
+	void Gfx_VulkanAllocator::UnregisterRelocatable(VmaAllocation allocation)
+	{
+		std::lock_guard<std::mutex> lock(s_Instance->m_RelocationMutex);
+		s_Instance->m_Relocatables.erase(allocation);
+	}
+
+	uint32_t Gfx_VulkanAllocator::AddRelocationListener(const RelocationListener& listener)
+	{
+		if (s_Instance == nullptr)
+			return UINT32_MAX;
+
+		std::lock_guard<std::mutex> lock(s_Instance->m_RelocationMutex);
+
+		const uint32_t id = s_Instance->m_NextListener++;
+		s_Instance->m_RelocationListeners[id] = listener;
+		return id;
+	}
+
+	void Gfx_VulkanAllocator::RemoveRelocationListener(uint32_t id)
+	{
+		if (s_Instance == nullptr)
+			return;
+
+		std::lock_guard<std::mutex> lock(s_Instance->m_RelocationMutex);
+		s_Instance->m_RelocationListeners.erase(id);
+	}
+
+	VkResult Gfx_VulkanAllocator::BindBuffer(VmaAllocation allocation, VkBuffer buffer)
+	{
+		return vmaBindBufferMemory(s_Instance->m_Allocator, allocation, buffer);
+	}
+
+	VkResult Gfx_VulkanAllocator::BindImage(VmaAllocation allocation, VkImage image)
+	{
+		return vmaBindImageMemory(s_Instance->m_Allocator, allocation, image);
+	}
+}
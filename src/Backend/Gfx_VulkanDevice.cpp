@@ -2,7 +2,9 @@
 #include "Backend/Gfx_VulkanDevice.h"
 #include "Backend/Gfx_VulkanInstance.h"
 
+#ifdef _WIN32
 #include <vulkan/vulkan_win32.h>
+#endif
 
 namespace SmolEngine
 {
@@ -13,22 +15,29 @@ namespace SmolEngine
 		m_ComputeCommandPool{nullptr},
 		m_PhysicalDevice{nullptr},
 		m_LogicalDevice{nullptr},
-		m_RayTracingEnabled{false}
+		m_RayTracingEnabled{false},
+		m_ShaderModuleIdentifierEnabled{false},
+		m_BindlessEnabled{false},
+		m_PushDescriptorEnabled{false},
+		m_DescriptorBufferEnabled{false},
+		m_MemoryBudgetEnabled{false}
 	{
 
 	}
 
-	void Gfx_VulkanDevice::Create(const Gfx_VulkanInstance* instance)
+	void Gfx_VulkanDevice::Create(const Gfx_VulkanInstance* instance, bool headless)
 	{
-		SetupPhysicalDevice(instance);
+		SetupPhysicalDevice(instance, headless);
 		SetupLogicalDevice();
 	}
 
-	void Gfx_VulkanDevice::SetupPhysicalDevice(const Gfx_VulkanInstance* _instance)
+	void Gfx_VulkanDevice::SetupPhysicalDevice(const Gfx_VulkanInstance* _instance, bool headless)
 	{
 		const VkInstance& instance = _instance->GetInstance();
 	 
-		m_ExtensionsList.push_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
+		if (!headless)
+			m_ExtensionsList.push_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
+
 		m_ExtensionsList.push_back(VK_KHR_16BIT_STORAGE_EXTENSION_NAME);
 		m_ExtensionsList.push_back(VK_KHR_SHADER_FLOAT16_INT8_EXTENSION_NAME);
 
@@ -49,8 +58,6 @@ namespace SmolEngine
 		// Required by VK_KHR_spirv_1_4
 		rayTracingEX.push_back(VK_KHR_SHADER_FLOAT_CONTROLS_EXTENSION_NAME);
 
-		rayTracingEX.push_back(VK_KHR_PUSH_DESCRIPTOR_EXTENSION_NAME);
-
 		rayTracingEX.push_back("VK_NVX_binary_import");
 		rayTracingEX.push_back("VK_NVX_image_view_handle");
 
@@ -77,6 +84,94 @@ namespace SmolEngine
 		}
 
 		GFX_ASSERT(m_PhysicalDevice != VK_NULL_HANDLE)
+
+		SetupOptionalExtensions();
+	}
+
+	void Gfx_VulkanDevice::SetupOptionalExtensions()
+	{
+		const auto addIfSupported = [this](const char* name)
+		{
+			if (!HasRequiredExtensions(m_PhysicalDevice, { name }))
+				return false;
+
+			if (!IsExtensionEnabled(name))
+				m_ExtensionsList.push_back(name);
+
+			return true;
+		};
+
+		// Shader module identifiers, requires pipeline creation cache control (core in 1.3)
+		{
+			const bool cacheControl = m_DeviceProperties.apiVersion >= VK_API_VERSION_1_3 ||
+				HasRequiredExtensions(m_PhysicalDevice, { VK_EXT_PIPELINE_CREATION_CACHE_CONTROL_EXTENSION_NAME });
+
+			if (cacheControl && HasRequiredExtensions(m_PhysicalDevice, { VK_EXT_SHADER_MODULE_IDENTIFIER_EXTENSION_NAME }))
+			{
+				VkPhysicalDeviceShaderModuleIdentifierFeaturesEXT identifierFeatures{};
+				identifierFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SHADER_MODULE_IDENTIFIER_FEATURES_EXT;
+
+				VkPhysicalDeviceFeatures2 deviceFeatures2 = {};
+				deviceFeatures2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+				deviceFeatures2.pNext = &identifierFeatures;
+				vkGetPhysicalDeviceFeatures2(m_PhysicalDevice, &deviceFeatures2);
+
+				if (identifierFeatures.shaderModuleIdentifier == VK_TRUE)
+				{
+					if (m_DeviceProperties.apiVersion < VK_API_VERSION_1_3)
+						addIfSupported(VK_EXT_PIPELINE_CREATION_CACHE_CONTROL_EXTENSION_NAME);
+
+					m_ShaderModuleIdentifierEnabled = addIfSupported(VK_EXT_SHADER_MODULE_IDENTIFIER_EXTENSION_NAME);
+				}
+			}
+		}
+
+		// Descriptors written straight into a mapped buffer, requires buffer device address (core in 1.2)
+		if (m_DeviceProperties.apiVersion >= VK_API_VERSION_1_2 && HasRequiredExtensions(m_PhysicalDevice, { VK_EXT_DESCRIPTOR_BUFFER_EXTENSION_NAME }))
+		{
+			VkPhysicalDeviceDescriptorBufferFeaturesEXT descriptorBufferFeatures{};
+			descriptorBufferFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_BUFFER_FEATURES_EXT;
+
+			VkPhysicalDeviceBufferDeviceAddressFeatures addressFeatures{};
+			addressFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_BUFFER_DEVICE_ADDRESS_FEATURES;
+			addressFeatures.pNext = &descriptorBufferFeatures;
+
+			VkPhysicalDeviceFeatures2 deviceFeatures2 = {};
+			deviceFeatures2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+			deviceFeatures2.pNext = &addressFeatures;
+			vkGetPhysicalDeviceFeatures2(m_PhysicalDevice, &deviceFeatures2);
+
+			if (descriptorBufferFeatures.descriptorBuffer == VK_TRUE && addressFeatures.bufferDeviceAddress == VK_TRUE)
+			{
+				descriptorBufferProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_BUFFER_PROPERTIES_EXT;
+				descriptorBufferProperties.pNext = nullptr;
+
+				VkPhysicalDeviceProperties2 deviceProperties2{};
+				deviceProperties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+				deviceProperties2.pNext = &descriptorBufferProperties;
+				vkGetPhysicalDeviceProperties2(m_PhysicalDevice, &deviceProperties2);
+
+				m_DescriptorBufferEnabled = addIfSupported(VK_EXT_DESCRIPTOR_BUFFER_EXTENSION_NAME);
+			}
+		}
+
+		// Per-draw descriptors without set allocations, descriptor buffers use transient regions instead
+		if (!m_DescriptorBufferEnabled)
+			m_PushDescriptorEnabled = addIfSupported(VK_KHR_PUSH_DESCRIPTOR_EXTENSION_NAME);
+
+		if (m_PushDescriptorEnabled)
+		{
+			pushDescriptorProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PUSH_DESCRIPTOR_PROPERTIES_KHR;
+			pushDescriptorProperties.pNext = nullptr;
+
+			VkPhysicalDeviceProperties2 deviceProperties2{};
+			deviceProperties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+			deviceProperties2.pNext = &pushDescriptorProperties;
+			vkGetPhysicalDeviceProperties2(m_PhysicalDevice, &deviceProperties2);
+		}
+
+		// Real heap budgets from the driver instead of estimates from our own allocations (properties2 is core in 1.1)
+		m_MemoryBudgetEnabled = addIfSupported(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
 	}
 
 	void Gfx_VulkanDevice::SetupLogicalDevice()
@@ -117,25 +212,86 @@ namespace SmolEngine
 			queueCreateInfos.push_back(queueCreateInfo);
 		}
 
+		// Optional features are chained in front of the required ones
+		void* optionalFeatures = nullptr;
+
+		VkPhysicalDeviceShaderModuleIdentifierFeaturesEXT enabledShaderModuleIdentifierFeatures{};
+		if (m_ShaderModuleIdentifierEnabled)
+		{
+			enabledShaderModuleIdentifierFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SHADER_MODULE_IDENTIFIER_FEATURES_EXT;
+			enabledShaderModuleIdentifierFeatures.shaderModuleIdentifier = VK_TRUE;
+			enabledShaderModuleIdentifierFeatures.pNext = optionalFeatures;
+			optionalFeatures = &enabledShaderModuleIdentifierFeatures;
+		}
+
+		VkPhysicalDeviceDescriptorBufferFeaturesEXT enabledDescriptorBufferFeatures{};
+		if (m_DescriptorBufferEnabled)
+		{
+			enabledDescriptorBufferFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_BUFFER_FEATURES_EXT;
+			enabledDescriptorBufferFeatures.descriptorBuffer = VK_TRUE;
+			enabledDescriptorBufferFeatures.pNext = optionalFeatures;
+			optionalFeatures = &enabledDescriptorBufferFeatures;
+		}
+
+		// Ray tracing already chains buffer device address below
+		VkPhysicalDeviceBufferDeviceAddressFeatures optionalBufferDeviceAddressFeatures{};
+		if (m_DescriptorBufferEnabled && !m_RayTracingEnabled)
+		{
+			optionalBufferDeviceAddressFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_BUFFER_DEVICE_ADDRESS_FEATURES;
+			optionalBufferDeviceAddressFeatures.bufferDeviceAddress = VK_TRUE;
+			optionalBufferDeviceAddressFeatures.pNext = optionalFeatures;
+			optionalFeatures = &optionalBufferDeviceAddressFeatures;
+		}
+
+		// Only bits reported by the device are enabled, vkCreateDevice fails on anything else
+		VkPhysicalDevice16BitStorageFeatures supported16BitStorageFeatures = {};
+		supported16BitStorageFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_16BIT_STORAGE_FEATURES;
+
+		VkPhysicalDeviceFloat16Int8FeaturesKHR supportedFloat16Int8Features = {};
+		supportedFloat16Int8Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FLOAT16_INT8_FEATURES_KHR;
+		supportedFloat16Int8Features.pNext = &supported16BitStorageFeatures;
+
+		VkPhysicalDeviceTimelineSemaphoreFeatures supportedTimelineSemaphoreFeatures = {};
+		supportedTimelineSemaphoreFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES;
+		supportedTimelineSemaphoreFeatures.pNext = &supportedFloat16Int8Features;
+
+		VkPhysicalDeviceFeatures2 supportedFeatures2 = {};
+		supportedFeatures2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+		supportedFeatures2.pNext = &supportedTimelineSemaphoreFeatures;
+		vkGetPhysicalDeviceFeatures2(m_PhysicalDevice, &supportedFeatures2);
+
 		VkPhysicalDeviceDescriptorIndexingFeatures descriptorIndexingFeatures = {};
 		descriptorIndexingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES;
-		descriptorIndexingFeatures.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
-		descriptorIndexingFeatures.runtimeDescriptorArray = VK_TRUE;
+		descriptorIndexingFeatures.shaderSampledImageArrayNonUniformIndexing = supportedDescriptorIndexingFeatures.shaderSampledImageArrayNonUniformIndexing;
+		descriptorIndexingFeatures.runtimeDescriptorArray = supportedDescriptorIndexingFeatures.runtimeDescriptorArray;
+		descriptorIndexingFeatures.pNext = optionalFeatures;
+
+		// Bindless heap, m_BindlessEnabled is only set when the update after bind bits are supported
+		if (m_BindlessEnabled)
+		{
+			descriptorIndexingFeatures.descriptorBindingPartiallyBound = supportedDescriptorIndexingFeatures.descriptorBindingPartiallyBound;
+			descriptorIndexingFeatures.descriptorBindingSampledImageUpdateAfterBind = supportedDescriptorIndexingFeatures.descriptorBindingSampledImageUpdateAfterBind;
+			descriptorIndexingFeatures.descriptorBindingStorageImageUpdateAfterBind = supportedDescriptorIndexingFeatures.descriptorBindingStorageImageUpdateAfterBind;
+			descriptorIndexingFeatures.descriptorBindingStorageBufferUpdateAfterBind = supportedDescriptorIndexingFeatures.descriptorBindingStorageBufferUpdateAfterBind;
+			descriptorIndexingFeatures.descriptorBindingUpdateUnusedWhilePending = supportedDescriptorIndexingFeatures.descriptorBindingUpdateUnusedWhilePending;
+			descriptorIndexingFeatures.shaderStorageImageArrayNonUniformIndexing = supportedDescriptorIndexingFeatures.shaderStorageImageArrayNonUniformIndexing;
+			descriptorIndexingFeatures.shaderStorageBufferArrayNonUniformIndexing = supportedDescriptorIndexingFeatures.shaderStorageBufferArrayNonUniformIndexing;
+		}
 
 
 		VkPhysicalDevice16BitStorageFeatures enabled16BitStorageFeatures = {};
 		enabled16BitStorageFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_16BIT_STORAGE_FEATURES;
-		enabled16BitStorageFeatures.storageBuffer16BitAccess = VK_TRUE;
+		enabled16BitStorageFeatures.storageBuffer16BitAccess = supported16BitStorageFeatures.storageBuffer16BitAccess;
 		enabled16BitStorageFeatures.pNext = &descriptorIndexingFeatures;
 
 		VkPhysicalDeviceFloat16Int8FeaturesKHR enabledFloat16Int8FeaturesKHR = {};
 		enabledFloat16Int8FeaturesKHR.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FLOAT16_INT8_FEATURES_KHR;
-		enabledFloat16Int8FeaturesKHR.shaderFloat16 = VK_TRUE;
+		enabledFloat16Int8FeaturesKHR.shaderFloat16 = supportedFloat16Int8Features.shaderFloat16;
 		enabledFloat16Int8FeaturesKHR.pNext = &enabled16BitStorageFeatures;
 
 		VkPhysicalDeviceTimelineSemaphoreFeatures enabledTimelineSemaphoreFeatures = {};
 		enabledTimelineSemaphoreFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES;
-		enabledTimelineSemaphoreFeatures.timelineSemaphore = VK_TRUE;
+		enabledTimelineSemaphoreFeatures.timelineSemaphore = supportedTimelineSemaphoreFeatures.timelineSemaphore;
 		enabledTimelineSemaphoreFeatures.pNext = &enabledFloat16Int8FeaturesKHR;
 
 		// Enable features required for ray tracing using feature chaining via pNext	
@@ -154,11 +310,14 @@ namespace SmolEngine
 		enabledAccelerationStructureFeatures.accelerationStructure = VK_TRUE;
 		enabledAccelerationStructureFeatures.pNext = &enabledRayTracingPipelineFeatures;
 
+		// Required features are always chained, ray tracing ones only when supported
+		void* enabledFeatures = m_RayTracingEnabled ? (void*)&enabledAccelerationStructureFeatures : (void*)&enabledTimelineSemaphoreFeatures;
+
 		VkDeviceDiagnosticsConfigCreateInfoNV diagnosticsConfigCreateInfoNV{};
 		diagnosticsConfigCreateInfoNV.sType = VK_STRUCTURE_TYPE_DEVICE_DIAGNOSTICS_CONFIG_CREATE_INFO_NV;
 		diagnosticsConfigCreateInfoNV.flags = VK_DEVICE_DIAGNOSTICS_CONFIG_ENABLE_SHADER_DEBUG_INFO_BIT_NV | VK_DEVICE_DIAGNOSTICS_CONFIG_ENABLE_RESOURCE_TRACKING_BIT_NV
 			| VK_DEVICE_DIAGNOSTICS_CONFIG_ENABLE_AUTOMATIC_CHECKPOINTS_BIT_NV;
-		diagnosticsConfigCreateInfoNV.pNext = m_RayTracingEnabled ? &enabledAccelerationStructureFeatures : nullptr;
+		diagnosticsConfigCreateInfoNV.pNext = enabledFeatures;
 
 
 		VkDeviceCreateInfo deviceInfo = {};
@@ -173,10 +332,7 @@ namespace SmolEngine
 #ifdef AFTERMATH
 			deviceInfo.pNext = &diagnosticsConfigCreateInfoNV;
 #else
-			if (m_RayTracingEnabled)
-			{
-				deviceInfo.pNext = &enabledAccelerationStructureFeatures;
-			}
+			deviceInfo.pNext = enabledFeatures;
 #endif
 		}
 
@@ -231,26 +387,38 @@ namespace SmolEngine
 		m_QueueFamilyProperties.resize(queueFamilyCount);
 		vkGetPhysicalDeviceQueueFamilyProperties(device, &queueFamilyCount, m_QueueFamilyProperties.data());
 
+		descriptorIndexingProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES;
+		descriptorIndexingProperties.pNext = nullptr;
+
 		VkPhysicalDeviceProperties2 deviceProperties2{};
 		deviceProperties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+		deviceProperties2.pNext = &descriptorIndexingProperties;
 		// Get ray tracing pipeline properties
 		if (m_RayTracingEnabled)
 		{
 			rayTracingPipelineProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_RAY_TRACING_PIPELINE_PROPERTIES_KHR;
-			deviceProperties2.pNext = &rayTracingPipelineProperties;
+			descriptorIndexingProperties.pNext = &rayTracingPipelineProperties;
 		}
 		vkGetPhysicalDeviceProperties2(device, &deviceProperties2);
 
+		supportedDescriptorIndexingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES;
+		supportedDescriptorIndexingFeatures.pNext = nullptr;
+
 		VkPhysicalDeviceFeatures2 deviceFeatures2 = {};
 		deviceFeatures2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+		deviceFeatures2.pNext = &supportedDescriptorIndexingFeatures;
 		// Get acceleration structure properties
 		if (m_RayTracingEnabled)
 		{
 			accelerationStructureFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ACCELERATION_STRUCTURE_FEATURES_KHR;
-			deviceFeatures2.pNext = &accelerationStructureFeatures;
+			supportedDescriptorIndexingFeatures.pNext = &accelerationStructureFeatures;
 		}
 		vkGetPhysicalDeviceFeatures2(device, &deviceFeatures2);
 
+		m_BindlessEnabled = supportedDescriptorIndexingFeatures.runtimeDescriptorArray && supportedDescriptorIndexingFeatures.descriptorBindingPartiallyBound &&
+			supportedDescriptorIndexingFeatures.descriptorBindingSampledImageUpdateAfterBind && supportedDescriptorIndexingFeatures.descriptorBindingStorageImageUpdateAfterBind &&
+			supportedDescriptorIndexingFeatures.descriptorBindingStorageBufferUpdateAfterBind && supportedDescriptorIndexingFeatures.shaderSampledImageArrayNonUniformIndexing;
+
 		VkPhysicalDeviceMemoryProperties memoryProperties = {};
 		vkGetPhysicalDeviceMemoryProperties(device, &memoryProperties);
 
@@ -280,6 +448,29 @@ namespace SmolEngine
 			vkGetRayTracingShaderGroupHandlesKHR = reinterpret_cast<PFN_vkGetRayTracingShaderGroupHandlesKHR>(vkGetDeviceProcAddr(m_LogicalDevice, "vkGetRayTracingShaderGroupHandlesKHR"));
 			vkCreateRayTracingPipelinesKHR = reinterpret_cast<PFN_vkCreateRayTracingPipelinesKHR>(vkGetDeviceProcAddr(m_LogicalDevice, "vkCreateRayTracingPipelinesKHR"));
 		}
+
+		if (m_DescriptorBufferEnabled)
+		{
+			// Core since 1.2, the KHR entry point is only there with ray tracing
+			if (!m_RayTracingEnabled)
+				vkGetBufferDeviceAddressKHR = reinterpret_cast<PFN_vkGetBufferDeviceAddressKHR>(vkGetDeviceProcAddr(m_LogicalDevice, "vkGetBufferDeviceAddress"));
+
+			vkGetDescriptorSetLayoutSizeEXT = reinterpret_cast<PFN_vkGetDescriptorSetLayoutSizeEXT>(vkGetDeviceProcAddr(m_LogicalDevice, "vkGetDescriptorSetLayoutSizeEXT"));
+			vkGetDescriptorSetLayoutBindingOffsetEXT = reinterpret_cast<PFN_vkGetDescriptorSetLayoutBindingOffsetEXT>(vkGetDeviceProcAddr(m_LogicalDevice, "vkGetDescriptorSetLayoutBindingOffsetEXT"));
+			vkGetDescriptorEXT = reinterpret_cast<PFN_vkGetDescriptorEXT>(vkGetDeviceProcAddr(m_LogicalDevice, "vkGetDescriptorEXT"));
+			vkCmdBindDescriptorBuffersEXT = reinterpret_cast<PFN_vkCmdBindDescriptorBuffersEXT>(vkGetDeviceProcAddr(m_LogicalDevice, "vkCmdBindDescriptorBuffersEXT"));
+			vkCmdSetDescriptorBufferOffsetsEXT = reinterpret_cast<PFN_vkCmdSetDescriptorBufferOffsetsEXT>(vkGetDeviceProcAddr(m_LogicalDevice, "vkCmdSetDescriptorBufferOffsetsEXT"));
+		}
+
+		if (m_PushDescriptorEnabled)
+		{
+			vkCmdPushDescriptorSetKHR = reinterpret_cast<PFN_vkCmdPushDescriptorSetKHR>(vkGetDeviceProcAddr(m_LogicalDevice, "vkCmdPushDescriptorSetKHR"));
+		}
+
+		if (m_ShaderModuleIdentifierEnabled)
+		{
+			vkGetShaderModuleCreateInfoIdentifierEXT = reinterpret_cast<PFN_vkGetShaderModuleCreateInfoIdentifierEXT>(vkGetDeviceProcAddr(m_LogicalDevice, "vkGetShaderModuleCreateInfoIdentifierEXT"));
+		}
 	}
 
 	Gfx_VulkanDevice::QueueFamilyIndices Gfx_VulkanDevice::GetQueueFamilyIndices(int flags)
@@ -351,6 +542,11 @@ namespace SmolEngine
 		return &m_DeviceProperties;
 	}
 
+	const std::vector<VkQueueFamilyProperties>& Gfx_VulkanDevice::GetQueueFamilyProperties() const
+	{
+		return m_QueueFamilyProperties;
+	}
+
 	const VkPhysicalDeviceFeatures* Gfx_VulkanDevice::GetDeviceFeatures() const
 	{
 		return &m_DeviceFeatures;
@@ -399,4 +595,40 @@ namespace SmolEngine
 	{
 		return m_RayTracingEnabled;
 	}
+
+	bool Gfx_VulkanDevice::GetShaderModuleIdentifierSupport() const
+	{
+		return m_ShaderModuleIdentifierEnabled;
+	}
+
+	bool Gfx_VulkanDevice::GetBindlessSupport() const
+	{
+		return m_BindlessEnabled;
+	}
+
+	bool Gfx_VulkanDevice::GetPushDescriptorSupport() const
+	{
+		return m_PushDescriptorEnabled;
+	}
+
+	bool Gfx_VulkanDevice::GetDescriptorBufferSupport() const
+	{
+		return m_DescriptorBufferEnabled;
+	}
+
+	bool Gfx_VulkanDevice::GetMemoryBudgetSupport() const
+	{
+		return m_MemoryBudgetEnabled;
+	}
+
+	bool Gfx_VulkanDevice::IsExtensionEnabled(const char* name) const
+	{
+		for (const char* extension : m_ExtensionsList)
+		{
+			if (strcmp(extension, name) == 0)
+				return true;
+		}
+
+		return false;
+	}
 }
\ No newline at end of file
@@ -5,6 +5,7 @@
 #include "Common/Gfx_CmdBuffer.h"
 #include "Common/Gfx_PixelStorage.h"
 #include "Common/Gfx_Framebuffer.h"
+#include "Gfx_RenderContext.h"
 
 #include <mutex>
 
@@ -129,6 +130,50 @@ namespace SmolEngine
 			return VK_FORMAT_R32G32_SINT;
 		case Format::R32G32B32A32_SINT:
 			return VK_FORMAT_R32G32B32A32_SINT;
+		case Format::BC1_RGBA_UNORM:
+			return VK_FORMAT_BC1_RGBA_UNORM_BLOCK;
+		case Format::BC1_RGBA_SRGB:
+			return VK_FORMAT_BC1_RGBA_SRGB_BLOCK;
+		case Format::BC2_UNORM:
+			return VK_FORMAT_BC2_UNORM_BLOCK;
+		case Format::BC2_SRGB:
+			return VK_FORMAT_BC2_SRGB_BLOCK;
+		case Format::BC3_UNORM:
+			return VK_FORMAT_BC3_UNORM_BLOCK;
+		case Format::BC3_SRGB:
+			return VK_FORMAT_BC3_SRGB_BLOCK;
+		case Format::BC4_UNORM:
+			return VK_FORMAT_BC4_UNORM_BLOCK;
+		case Format::BC4_SNORM:
+			return VK_FORMAT_BC4_SNORM_BLOCK;
+		case Format::BC5_UNORM:
+			return VK_FORMAT_BC5_UNORM_BLOCK;
+		case Format::BC5_SNORM:
+			return VK_FORMAT_BC5_SNORM_BLOCK;
+		case Format::BC6H_UFLOAT:
+			return VK_FORMAT_BC6H_UFLOAT_BLOCK;
+		case Format::BC6H_SFLOAT:
+			return VK_FORMAT_BC6H_SFLOAT_BLOCK;
+		case Format::BC7_UNORM:
+			return VK_FORMAT_BC7_UNORM_BLOCK;
+		case Format::BC7_SRGB:
+			return VK_FORMAT_BC7_SRGB_BLOCK;
+		case Format::ASTC_4x4_UNORM:
+			return VK_FORMAT_ASTC_4x4_UNORM_BLOCK;
+		case Format::ASTC_4x4_SRGB:
+			return VK_FORMAT_ASTC_4x4_SRGB_BLOCK;
+		case Format::ASTC_6x6_UNORM:
+			return VK_FORMAT_ASTC_6x6_UNORM_BLOCK;
+		case Format::ASTC_6x6_SRGB:
+			return VK_FORMAT_ASTC_6x6_SRGB_BLOCK;
+		case Format::ASTC_8x8_UNORM:
+			return VK_FORMAT_ASTC_8x8_UNORM_BLOCK;
+		case Format::ASTC_8x8_SRGB:
+			return VK_FORMAT_ASTC_8x8_SRGB_BLOCK;
+		case Format::R8G8B8A8_SRGB:
+			return VK_FORMAT_R8G8B8A8_SRGB;
+		case Format::B8G8R8A8_SRGB:
+			return VK_FORMAT_B8G8R8A8_SRGB;
 		default:
 			return VK_FORMAT_R8_UNORM;
 		}
@@ -498,25 +543,33 @@ namespace SmolEngine
 	{
 		BufferCreateDesc bufferDesc{};
 		bufferDesc.myData = data;
-		bufferDesc.mySize = storage->m_Desc.myWidth * storage->m_Desc.myHeight * Gfx_Helpers::GetFormatSize(storage->m_Desc.myFormat);
+		bufferDesc.mySize = storage->m_Desc.mySize.x * storage->m_Desc.mySize.y * Gfx_Helpers::GetFormatSize(storage->m_Desc.myFormat);
 		bufferDesc.myFlags = BufferCreateDesc::CreateFlags::Staging;
+		bufferDesc.myPool = MemoryPool::Transient;
 
 		Gfx_Buffer stagingBuffer{};
 		stagingBuffer.Create(bufferDesc);
 
-		VkImageSubresourceRange subresourceRange = {};
-		subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-		subresourceRange.levelCount = storage->m_Desc.myMipLevels;
-		subresourceRange.layerCount = storage->m_Desc.myArrayLayers;
-
 		Gfx_CmdBuffer cmdBuffer{};
 		CmdBufferCreateDesc cmdDesc{};
 		cmdBuffer.Create(&cmdDesc);
 
 		cmdBuffer.CmdBeginRecord();
+		CmdCopyBufferToImage(cmdBuffer.GetBuffer(), storage, stagingBuffer.GetRawBuffer(), 0, layout);
+		cmdBuffer.CmdEndRecord();
+
+		Gfx_VulkanHelpers::ExecuteCmdBuffer(&cmdBuffer);
+	}
+
+	void Gfx_VulkanHelpers::CmdCopyBufferToImage(VkCommandBuffer cmd, Gfx_PixelStorage* storage, VkBuffer buffer, VkDeviceSize offset, VkImageLayout layout)
+	{
+		VkImageSubresourceRange subresourceRange = {};
+		subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		subresourceRange.levelCount = storage->m_Desc.myMipLevels;
+		subresourceRange.layerCount = storage->m_Desc.myArrayLayers;
 
 		InsertImageMemoryBarrier(
-			cmdBuffer.GetBuffer(),
+			cmd,
 			storage,
 			0,
 			VK_ACCESS_TRANSFER_WRITE_BIT,
@@ -526,27 +579,68 @@ namespace SmolEngine
 			subresourceRange);
 
 		VkBufferImageCopy bufferCopyRegion = {};
+		bufferCopyRegion.bufferOffset = offset;
 		bufferCopyRegion.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
 		bufferCopyRegion.imageSubresource.mipLevel = 0;
 		bufferCopyRegion.imageSubresource.baseArrayLayer = 0;
 		bufferCopyRegion.imageSubresource.layerCount = 1;
-		bufferCopyRegion.imageExtent.width = storage->m_Desc.myWidth;
-		bufferCopyRegion.imageExtent.height = storage->m_Desc.myHeight;
-		bufferCopyRegion.imageExtent.depth = storage->m_Desc.myArrayLayers;
+		bufferCopyRegion.imageExtent.width = storage->m_Desc.mySize.x;
+		bufferCopyRegion.imageExtent.height = storage->m_Desc.mySize.y;
+		bufferCopyRegion.imageExtent.depth = 1;
 
-		vkCmdCopyBufferToImage(cmdBuffer.GetBuffer(), stagingBuffer.GetRawBuffer(), storage->m_Image,
-			VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &bufferCopyRegion);
+		vkCmdCopyBufferToImage(cmd, buffer, storage->m_Image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &bufferCopyRegion);
 
-		GenerateMipMaps(cmdBuffer.GetBuffer(), storage, subresourceRange);
+		Gfx_RenderContext::GetMipGenerator().CmdGenerate(cmd, storage);
 
-		InsertImageMemoryBarrier(cmdBuffer.GetBuffer(), storage, 0, 0, layout,
+		InsertImageMemoryBarrier(cmd, storage, VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT, layout,
 			VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, subresourceRange);
+	}
+
+	void Gfx_VulkanHelpers::CopyRegionsToImage(Gfx_PixelStorage* storage, const void* data, size_t size, const std::vector<VkBufferImageCopy>& regions, VkImageLayout layout)
+	{
+		BufferCreateDesc bufferDesc{};
+		bufferDesc.myData = const_cast<void*>(data);
+		bufferDesc.mySize = size;
+		bufferDesc.myFlags = BufferCreateDesc::CreateFlags::Staging;
+		bufferDesc.myPool = MemoryPool::Transient;
 
+		Gfx_Buffer stagingBuffer{};
+		stagingBuffer.Create(bufferDesc);
+
+		Gfx_CmdBuffer cmdBuffer{};
+		CmdBufferCreateDesc cmdDesc{};
+		cmdBuffer.Create(&cmdDesc);
+
+		cmdBuffer.CmdBeginRecord();
+		CmdCopyRegionsToImage(cmdBuffer.GetBuffer(), storage, stagingBuffer.GetRawBuffer(), regions, layout);
 		cmdBuffer.CmdEndRecord();
 
 		Gfx_VulkanHelpers::ExecuteCmdBuffer(&cmdBuffer);
 	}
 
+	void Gfx_VulkanHelpers::CmdCopyRegionsToImage(VkCommandBuffer cmd, Gfx_PixelStorage* storage, VkBuffer buffer, const std::vector<VkBufferImageCopy>& regions, VkImageLayout layout)
+	{
+		VkImageSubresourceRange subresourceRange = {};
+		subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		subresourceRange.levelCount = storage->m_Desc.myMipLevels;
+		subresourceRange.layerCount = storage->m_Desc.myArrayLayers;
+
+		InsertImageMemoryBarrier(
+			cmd,
+			storage,
+			0,
+			VK_ACCESS_TRANSFER_WRITE_BIT,
+			VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+			VK_PIPELINE_STAGE_TRANSFER_BIT,
+			VK_PIPELINE_STAGE_TRANSFER_BIT,
+			subresourceRange);
+
+		vkCmdCopyBufferToImage(cmd, buffer, storage->m_Image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+			static_cast<uint32_t>(regions.size()), regions.data());
+
+		InsertImageMemoryBarrier(cmd, storage, VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT, layout,
+			VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, subresourceRange);
+	}
 
 	void Gfx_VulkanHelpers::InitializeImageResource(class Gfx_PixelStorage* storage, VkImageLayout layout)
 	{
@@ -561,8 +655,6 @@ namespace SmolEngine
 		subresourceRange.levelCount = storage->m_Desc.myMipLevels;
 		subresourceRange.layerCount = storage->m_Desc.myArrayLayers;
 
-		GenerateMipMaps(cmdBuffer.GetBuffer(), storage, subresourceRange);
-
 		InsertImageMemoryBarrier(cmdBuffer.GetBuffer(), storage, 0, 0, layout,
 			VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, subresourceRange);
 
@@ -613,64 +705,71 @@ namespace SmolEngine
 	}
 
 
-	void Gfx_VulkanHelpers::GenerateMipMaps(VkCommandBuffer cmd, Gfx_PixelStorage* storage, VkImageSubresourceRange& range)
+	static void locMipBarrier(VkCommandBuffer cmd, VkImage image, uint32_t mip, uint32_t layers, VkImageLayout oldLayout, VkImageLayout newLayout,
+		VkAccessFlags srcAccessMask, VkAccessFlags dstAccessMask)
+	{
+		VkImageMemoryBarrier imageMemoryBarrier = {};
+		imageMemoryBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		imageMemoryBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		imageMemoryBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		imageMemoryBarrier.srcAccessMask = srcAccessMask;
+		imageMemoryBarrier.dstAccessMask = dstAccessMask;
+		imageMemoryBarrier.oldLayout = oldLayout;
+		imageMemoryBarrier.newLayout = newLayout;
+		imageMemoryBarrier.image = image;
+		imageMemoryBarrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		imageMemoryBarrier.subresourceRange.baseMipLevel = mip;
+		imageMemoryBarrier.subresourceRange.levelCount = 1;
+		imageMemoryBarrier.subresourceRange.layerCount = layers;
+
+		vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &imageMemoryBarrier);
+	}
+
+	void Gfx_VulkanHelpers::GenerateMipMaps(VkCommandBuffer cmd, Gfx_PixelStorage* storage)
 	{
 		const PixelStorageCreateDesc& desc = storage->GetDesc();
+		VkImage image = storage->GetImage();
 
-		for (int32_t i = 1; i < desc.myMipLevels; i++)
+		// Linear blits need the filter feature, integer and some depth formats only support nearest
+		const VkFilter filter = IsFormatIsFilterable(GetFormat(desc.myFormat), VK_IMAGE_TILING_OPTIMAL) ? VK_FILTER_LINEAR : VK_FILTER_NEAREST;
+
+		// Each level is written as TRANSFER_DST, then becomes the source of the next one
+		locMipBarrier(cmd, image, 0, desc.myArrayLayers, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+			VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_TRANSFER_READ_BIT);
+
+		for (uint32_t i = 1; i < desc.myMipLevels; i++)
 		{
 			VkImageBlit imageBlit{};
 
 			imageBlit.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-			imageBlit.srcSubresource.layerCount = 1;
+			imageBlit.srcSubresource.layerCount = desc.myArrayLayers;
 			imageBlit.srcSubresource.mipLevel = i - 1;
-			imageBlit.srcOffsets[1].x = int32_t(desc.myWidth >> (i - 1));
-			imageBlit.srcOffsets[1].y = int32_t(desc.myHeight >> (i - 1));
+			imageBlit.srcOffsets[1].x = int32_t(std::max(desc.mySize.x >> (i - 1), 1u));
+			imageBlit.srcOffsets[1].y = int32_t(std::max(desc.mySize.y >> (i - 1), 1u));
 			imageBlit.srcOffsets[1].z = 1;
 
 			imageBlit.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-			imageBlit.dstSubresource.layerCount = 1;
+			imageBlit.dstSubresource.layerCount = desc.myArrayLayers;
 			imageBlit.dstSubresource.mipLevel = i;
-			imageBlit.dstOffsets[1].x = int32_t(desc.myWidth >> i);
-			imageBlit.dstOffsets[1].y = int32_t(desc.myHeight >> i);
+			imageBlit.dstOffsets[1].x = int32_t(std::max(desc.mySize.x >> i, 1u));
+			imageBlit.dstOffsets[1].y = int32_t(std::max(desc.mySize.y >> i, 1u));
 			imageBlit.dstOffsets[1].z = 1;
 
-			VkImageSubresourceRange mipSubRange = {};
-			mipSubRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-			mipSubRange.baseMipLevel = i;
-			mipSubRange.levelCount = 1;
-			mipSubRange.layerCount = 1;
-
-			InsertImageMemoryBarrier(
-				cmd,
-				storage,
-				0,
-				VK_ACCESS_TRANSFER_WRITE_BIT,
-				VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-				VK_PIPELINE_STAGE_TRANSFER_BIT,
-				VK_PIPELINE_STAGE_TRANSFER_BIT,
-				mipSubRange);
-
 			vkCmdBlitImage(
 				cmd,
-				storage->GetImage(),
-				storage->GetImageLayout(),
-				storage->GetImage(),
+				image,
+				VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+				image,
 				VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
 				1,
 				&imageBlit,
-				VK_FILTER_LINEAR);
+				filter);
 
-			InsertImageMemoryBarrier(
-				cmd,
-				storage,
-				VK_ACCESS_TRANSFER_WRITE_BIT,
-				VK_ACCESS_TRANSFER_READ_BIT,
-				VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-				VK_PIPELINE_STAGE_TRANSFER_BIT,
-				VK_PIPELINE_STAGE_TRANSFER_BIT,
-				mipSubRange);
+			locMipBarrier(cmd, image, i, desc.myArrayLayers, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+				VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_TRANSFER_READ_BIT);
 		}
+
+		storage->SetImageLayout(VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
 	}
 
 
@@ -920,6 +1019,8 @@ namespace SmolEngine
 
 	void Gfx_VulkanHelpers::ExecuteCmdBuffer(Gfx_CmdBuffer* cmdBuffer)
 	{
+		GFX_PROFILE_SCOPE("Gfx_VulkanHelpers::ExecuteCmdBuffer")
+
 		if (!cmdBuffer->IsGood()) // assert
 		{
 
@@ -956,4 +1057,22 @@ namespace SmolEngine
 		cmdBuffer->m_State = Gfx_CmdBuffer::State::Wait;
 	}
 
+	void Gfx_VulkanHelpers::SubmitCmdBuffer(Gfx_CmdBuffer* cmdBuffer, VkFence fence)
+	{
+		VkSubmitInfo submitInfo{};
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.commandBufferCount = 1;
+
+		VkCommandBuffer buffer = cmdBuffer->GetBuffer();
+		submitInfo.pCommandBuffers = &buffer;
+
+		{
+			std::lock_guard<std::mutex> lock(*s_locVulkanHelpersMutex);
+			VkQueue queue = Gfx_App::GetDevice().GetQueue(Gfx_VulkanDevice::QueueFamilyFlags::Graphics);
+			VK_CHECK_RESULT(vkQueueSubmit(queue, 1, &submitInfo, fence));
+		}
+
+		cmdBuffer->m_State = Gfx_CmdBuffer::State::Wait;
+	}
+
 }
\ No newline at end of file
@@ -49,7 +49,7 @@ namespace SmolEngine
 		VulkanInstance_DestroyDebugUtilsMessengerEXT(m_Instance, m_Messenger, nullptr);
 	}
 
-	void Gfx_VulkanInstance::Create()
+	void Gfx_VulkanInstance::Create(bool headless)
 	{
 		VkApplicationInfo appInfo = {};
 		{
@@ -63,8 +63,12 @@ namespace SmolEngine
 		}
 
 		std::vector<const char*> instanceLayers = {};
-		m_Extensions = { VK_KHR_SURFACE_EXTENSION_NAME, VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME,
-			"VK_KHR_win32_surface" };
+		m_Extensions = { VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME };
+		if (!headless)
+		{
+			m_Extensions.push_back(VK_KHR_SURFACE_EXTENSION_NAME);
+			m_Extensions.push_back("VK_KHR_win32_surface");
+		}
 
 #ifdef SMOLENGINE_DEBUG
 		instanceLayers.push_back("VK_LAYER_KHRONOS_validation");
@@ -9,7 +9,7 @@ namespace SmolEngine
 
     }
 
-    void Gfx_VulkanSemaphore::Create(const Gfx_VulkanDevice* device)
+    void Gfx_VulkanSemaphore::Create(const Gfx_VulkanDevice* device, uint32_t framesInFlight)
     {
         VkSemaphoreCreateInfo semaphoreCI = {};
         {
@@ -34,7 +34,7 @@ namespace SmolEngine
             fenceCreateInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
             fenceCreateInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
 
-            m_WaitFences.resize(Gfx_App::GetSwapchain().m_Buffers.size());
+            m_WaitFences.resize(framesInFlight);
 
             for (auto& fence : m_WaitFences)
             {
@@ -428,7 +428,7 @@ namespace SmolEngine
 		imageCI.extent = { m_Width, m_Height, 1 };
 		imageCI.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
 
-		m_DepthStencil->Alloc = Gfx_VulkanAllocator::AllocImage(imageCI, VMA_MEMORY_USAGE_GPU_ONLY, m_DepthStencil->Image);
+		m_DepthStencil->Alloc = Gfx_VulkanAllocator::AllocImage(imageCI, VMA_MEMORY_USAGE_GPU_ONLY, m_DepthStencil->Image, MemoryPool::Dedicated);
 
 		VkImageViewCreateInfo depthStencilViewCI = {};
 		{
@@ -674,6 +674,11 @@ namespace SmolEngine
 		return m_CurrentBufferIndex;
 	}
 
+	uint32_t Gfx_VulkanSwapchain::GetImageCount() const
+	{
+		return static_cast<uint32_t>(m_Buffers.size());
+	}
+
 	uint32_t& Gfx_VulkanSwapchain::GetCurrentBufferIndexRef()
 	{
 		return m_CurrentBufferIndex;
@@ -44,14 +44,14 @@ namespace SmolEngine
 		const Gfx_VulkanDevice& device = Gfx_App::GetDevice();
 
 		VkDeviceOrHostAddressConstKHR vertexBufferDeviceAddress{};
-		vertexBufferDeviceAddress.deviceAddress = Gfx_VulkanHelpers::GetBufferDeviceAddress(vb->GetBuffer().GetRawBuffer());
+		vertexBufferDeviceAddress.deviceAddress = vb->GetBuffer().GetDeviceAddress();
 
 		VkDeviceOrHostAddressConstKHR indexBufferDeviceAddress{};
-		indexBufferDeviceAddress.deviceAddress = Gfx_VulkanHelpers::GetBufferDeviceAddress(ib->GetBuffer().GetRawBuffer());
+		indexBufferDeviceAddress.deviceAddress = ib->GetBuffer().GetDeviceAddress();
 
 		VkDeviceOrHostAddressConstKHR transformBufferDeviceAddress{};
 
-		transformBufferDeviceAddress.deviceAddress = Gfx_VulkanHelpers::GetBufferDeviceAddress(transform->GetRawBuffer());
+		transformBufferDeviceAddress.deviceAddress = transform->GetDeviceAddress();
 
 		// Build
 		VkAccelerationStructureGeometryKHR accelerationStructureGeometry{};
@@ -110,6 +110,7 @@ namespace SmolEngine
 		// Create a small scratch buffer used during build of the bottom level acceleration structure
 		bufferDesc = {};
 		bufferDesc.myFlags = BufferCreateDesc::CreateFlags::Scratch;
+		bufferDesc.myPool = MemoryPool::Transient;
 		bufferDesc.mySize = accelerationStructureBuildSizesInfo.buildScratchSize;
 		Gfx_Buffer scratchBuffer{};
 		scratchBuffer.Create(bufferDesc);
@@ -164,7 +165,7 @@ namespace SmolEngine
 
 		VkAccelerationStructureGeometryInstancesDataKHR instancesVk{ VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_GEOMETRY_INSTANCES_DATA_KHR };
 		{
-			instancesVk.data.deviceAddress = Gfx_VulkanHelpers::GetBufferDeviceAddress(instances->GetRawBuffer());
+			instancesVk.data.deviceAddress = instances->GetDeviceAddress();
 		}
 
 		// Put the above into a VkAccelerationStructureGeometryKHR. We need to put the instances struct in a union and label it as instance data.
@@ -224,6 +225,7 @@ namespace SmolEngine
 
 		BufferCreateDesc bufferDesc = {};
 		bufferDesc.myFlags = BufferCreateDesc::CreateFlags::Scratch;
+		bufferDesc.myPool = MemoryPool::Transient;
 		bufferDesc.mySize = sizeInfo.buildScratchSize;
 		Gfx_Buffer scratchBuffer{};
 		scratchBuffer.Create(bufferDesc);
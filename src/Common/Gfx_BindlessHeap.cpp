@@ -0,0 +1,352 @@
+#include "Gfx_Precompiled.h"
+#include "Common/Gfx_BindlessHeap.h"
+#include "Common/Gfx_PixelStorage.h"
+#include "Common/Gfx_Sampler.h"
+#include "Common/Gfx_Buffer.h"
+
+#include "Gfx_RenderContext.h"
+
+namespace SmolEngine
+{
+	static const VkDescriptorType s_BindlessTypes[] =
+	{
+		VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+		VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+		VK_DESCRIPTOR_TYPE_STORAGE_BUFFER
+	};
+
+	static const uint32_t s_BindlessDesiredCapacity[] = { 16384, 4096, 8192 };
+
+	Gfx_BindlessHeap::Gfx_BindlessHeap()
+		:
+		m_Pool{nullptr},
+		m_Layout{nullptr},
+		m_Set{nullptr},
+		m_BindingOffsets{},
+		m_FrameCount{0} {}
+
+	void Gfx_BindlessHeap::Create()
+	{
+		const Gfx_VulkanDevice& device = Gfx_App::GetDevice();
+		if (!device.GetBindlessSupport())
+		{
+			GFX_LOG("Gfx_BindlessHeap: update-after-bind descriptor indexing is not supported", Gfx_Log::Level::Warning)
+			return;
+		}
+
+		// Descriptor buffers can be written at any time, update-after-bind does not apply to them
+		Gfx_DescriptorBuffer& descriptorBuffer = Gfx_RenderContext::GetDescriptorBuffer();
+		const bool useDescriptorBuffer = descriptorBuffer.IsGood();
+
+		// Combined image samplers count against both sampler and sampled image limits
+		if (useDescriptorBuffer)
+		{
+			// Without update-after-bind the regular set limits apply, they are usually far lower
+			const VkPhysicalDeviceLimits& limits = device.GetDeviceProperties()->limits;
+
+			m_Handles[0].myCapacity = std::min({ s_BindlessDesiredCapacity[0],
+				limits.maxDescriptorSetSampledImages, limits.maxPerStageDescriptorSampledImages,
+				limits.maxDescriptorSetSamplers, limits.maxPerStageDescriptorSamplers });
+
+			m_Handles[1].myCapacity = std::min({ s_BindlessDesiredCapacity[1],
+				limits.maxDescriptorSetStorageImages, limits.maxPerStageDescriptorStorageImages });
+
+			m_Handles[2].myCapacity = std::min({ s_BindlessDesiredCapacity[2],
+				limits.maxDescriptorSetStorageBuffers, limits.maxPerStageDescriptorStorageBuffers });
+		}
+		else
+		{
+			const VkPhysicalDeviceDescriptorIndexingProperties& props = device.descriptorIndexingProperties;
+
+			m_Handles[0].myCapacity = std::min({ s_BindlessDesiredCapacity[0],
+				props.maxDescriptorSetUpdateAfterBindSampledImages, props.maxPerStageDescriptorUpdateAfterBindSampledImages,
+				props.maxDescriptorSetUpdateAfterBindSamplers, props.maxPerStageDescriptorUpdateAfterBindSamplers });
+
+			m_Handles[1].myCapacity = std::min({ s_BindlessDesiredCapacity[1],
+				props.maxDescriptorSetUpdateAfterBindStorageImages, props.maxPerStageDescriptorUpdateAfterBindStorageImages });
+
+			m_Handles[2].myCapacity = std::min({ s_BindlessDesiredCapacity[2],
+				props.maxDescriptorSetUpdateAfterBindStorageBuffers, props.maxPerStageDescriptorUpdateAfterBindStorageBuffers });
+		}
+
+		std::vector<VkDescriptorSetLayoutBinding> bindings;
+		std::vector<VkDescriptorBindingFlags> bindingFlags;
+		std::vector<VkDescriptorPoolSize> poolSizes;
+
+		for (uint32_t i = 0; i < static_cast<uint32_t>(BindlessType::Count); ++i)
+		{
+			VkDescriptorSetLayoutBinding binding{};
+			binding.binding = i;
+			binding.descriptorType = s_BindlessTypes[i];
+			binding.descriptorCount = m_Handles[i].myCapacity;
+			binding.stageFlags = VK_SHADER_STAGE_ALL;
+
+			bindings.push_back(binding);
+			bindingFlags.push_back(useDescriptorBuffer ? VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT :
+				VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT);
+			poolSizes.push_back({ s_BindlessTypes[i], m_Handles[i].myCapacity });
+		}
+
+		VkDevice vkDevice = device.GetLogicalDevice();
+
+		VkDescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsCI{};
+		bindingFlagsCI.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+		bindingFlagsCI.bindingCount = static_cast<uint32_t>(bindingFlags.size());
+		bindingFlagsCI.pBindingFlags = bindingFlags.data();
+
+		VkDescriptorSetLayoutCreateInfo layoutCI{};
+		{
+			layoutCI.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+			layoutCI.pNext = &bindingFlagsCI;
+			layoutCI.flags = useDescriptorBuffer ? VK_DESCRIPTOR_SET_LAYOUT_CREATE_DESCRIPTOR_BUFFER_BIT_EXT :
+				VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
+			layoutCI.bindingCount = static_cast<uint32_t>(bindings.size());
+			layoutCI.pBindings = bindings.data();
+
+			VK_CHECK_RESULT(vkCreateDescriptorSetLayout(vkDevice, &layoutCI, nullptr, &m_Layout));
+		}
+
+		if (useDescriptorBuffer)
+		{
+			m_BufferRegion = descriptorBuffer.Allocate(Gfx_DescriptorBuffer::GetLayoutSize(m_Layout));
+			for (uint32_t i = 0; i < static_cast<uint32_t>(BindlessType::Count); ++i)
+				m_BindingOffsets[i] = Gfx_DescriptorBuffer::GetBindingOffset(m_Layout, i);
+
+			return;
+		}
+
+		VkDescriptorPoolCreateInfo descriptorPoolCI{};
+		{
+			descriptorPoolCI.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+			descriptorPoolCI.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT;
+			descriptorPoolCI.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+			descriptorPoolCI.pPoolSizes = poolSizes.data();
+			descriptorPoolCI.maxSets = 1;
+
+			VK_CHECK_RESULT(vkCreateDescriptorPool(vkDevice, &descriptorPoolCI, nullptr, &m_Pool));
+		}
+
+		VkDescriptorSetAllocateInfo allocateCI{};
+		{
+			allocateCI.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+			allocateCI.descriptorPool = m_Pool;
+			allocateCI.descriptorSetCount = 1;
+			allocateCI.pSetLayouts = &m_Layout;
+
+			VK_CHECK_RESULT(vkAllocateDescriptorSets(vkDevice, &allocateCI, &m_Set));
+		}
+	}
+
+	void Gfx_BindlessHeap::Free()
+	{
+		VK_DESTROY_DEVICE_HANDLE(m_Pool, vkDestroyDescriptorPool);
+		VK_DESTROY_DEVICE_HANDLE(m_Layout, vkDestroyDescriptorSetLayout);
+
+		if (m_BufferRegion.mySize > 0)
+			Gfx_RenderContext::GetDescriptorBuffer().Release(m_BufferRegion);
+
+		m_Set = nullptr;
+		for (HandleList& list : m_Handles)
+			list = {};
+	}
+
+	void Gfx_BindlessHeap::BeginFrame()
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		m_FrameCount++;
+
+		// Indices are reused only once no frame in flight can still reference them
+		const uint64_t framesInFlight = Gfx_App::GetFramesInFlight();
+		for (HandleList& list : m_Handles)
+		{
+			std::erase_if(list.myRetired, [&](const RetiredIndex& retired)
+			{
+				if (m_FrameCount - retired.myFrame <= framesInFlight)
+					return false;
+
+				list.myFree.push_back(retired.myIndex);
+				return true;
+			});
+		}
+	}
+
+	bool Gfx_BindlessHeap::IsGood() const
+	{
+		return m_Set != nullptr || m_BufferRegion.mySize > 0;
+	}
+
+	uint32_t Gfx_BindlessHeap::RegisterTexture(Gfx_PixelStorage* storage, Gfx_Sampler* sampler)
+	{
+		if (!IsGood())
+			return s_InvalidBindlessIndex;
+
+		uint32_t index = AllocateIndex(BindlessType::Texture);
+		UpdateTexture(index, storage, sampler);
+		return index;
+	}
+
+	uint32_t Gfx_BindlessHeap::RegisterStorageImage(Gfx_PixelStorage* storage)
+	{
+		if (!IsGood())
+			return s_InvalidBindlessIndex;
+
+		uint32_t index = AllocateIndex(BindlessType::StorageImage);
+		UpdateStorageImage(index, storage);
+		return index;
+	}
+
+	uint32_t Gfx_BindlessHeap::RegisterBuffer(Gfx_Buffer* buffer)
+	{
+		if (!IsGood())
+			return s_InvalidBindlessIndex;
+
+		uint32_t index = AllocateIndex(BindlessType::StorageBuffer);
+		UpdateBuffer(index, buffer);
+		return index;
+	}
+
+	void Gfx_BindlessHeap::UpdateTexture(uint32_t index, Gfx_PixelStorage* storage, Gfx_Sampler* sampler)
+	{
+		VkDescriptorImageInfo imageInfo{};
+		imageInfo.sampler = sampler->GetSampler();
+		imageInfo.imageView = storage->GetImageView();
+		imageInfo.imageLayout = storage->GetImageLayout();
+
+		Write(BindlessType::Texture, index, &imageInfo, nullptr);
+	}
+
+	void Gfx_BindlessHeap::UpdateStorageImage(uint32_t index, Gfx_PixelStorage* storage)
+	{
+		VkDescriptorImageInfo imageInfo{};
+		imageInfo.imageView = storage->GetImageView();
+		imageInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+		Write(BindlessType::StorageImage, index, &imageInfo, nullptr);
+	}
+
+	void Gfx_BindlessHeap::UpdateBuffer(uint32_t index, Gfx_Buffer* buffer)
+	{
+		VkDescriptorBufferInfo bufferInfo{};
+		bufferInfo.buffer = buffer->GetRawBuffer();
+		bufferInfo.offset = buffer->GetOffset();
+		bufferInfo.range = buffer->GetSize();
+
+		Write(BindlessType::StorageBuffer, index, nullptr, &bufferInfo);
+	}
+
+	void Gfx_BindlessHeap::Release(BindlessType type, uint32_t index)
+	{
+		if (index == s_InvalidBindlessIndex || !IsGood())
+			return;
+
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Handles[static_cast<uint32_t>(type)].myRetired.push_back({ index, m_FrameCount });
+	}
+
+	void Gfx_BindlessHeap::OnRelocated(const MemoryRelocations& relocations)
+	{
+		if (!IsGood())
+			return;
+
+		for (uint32_t i = 0; i < static_cast<uint32_t>(BindlessType::Count); ++i)
+		{
+			const BindlessType type = static_cast<BindlessType>(i);
+			std::vector<VkDescriptorImageInfo> images;
+			std::vector<VkDescriptorBufferInfo> buffers;
+			{
+				std::lock_guard<std::mutex> lock(m_Mutex);
+				images = m_Handles[i].myImages;
+				buffers = m_Handles[i].myBuffers;
+			}
+
+			for (uint32_t index = 0; index < static_cast<uint32_t>(images.size()); ++index)
+			{
+				VkDescriptorImageInfo imageInfo = images[index];
+				imageInfo.imageView = relocations.Find(imageInfo.imageView);
+
+				if (imageInfo.imageView != images[index].imageView)
+					Write(type, index, &imageInfo, nullptr);
+			}
+
+			for (uint32_t index = 0; index < static_cast<uint32_t>(buffers.size()); ++index)
+			{
+				VkDescriptorBufferInfo bufferInfo = buffers[index];
+				bufferInfo.buffer = relocations.Find(bufferInfo.buffer);
+
+				if (bufferInfo.buffer != buffers[index].buffer)
+					Write(type, index, nullptr, &bufferInfo);
+			}
+		}
+	}
+
+	uint32_t Gfx_BindlessHeap::GetCapacity(BindlessType type) const
+	{
+		return m_Handles[static_cast<uint32_t>(type)].myCapacity;
+	}
+
+	uint32_t Gfx_BindlessHeap::AllocateIndex(BindlessType type)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		HandleList& list = m_Handles[static_cast<uint32_t>(type)];
+		if (!list.myFree.empty())
+		{
+			uint32_t index = list.myFree.back();
+			list.myFree.pop_back();
+			return index;
+		}
+
+		GFX_ASSERT_MSG((list.myNext < list.myCapacity), "Gfx_BindlessHeap: heap is full")
+		return list.myNext++;
+	}
+
+	void Gfx_BindlessHeap::Write(BindlessType type, uint32_t index, const VkDescriptorImageInfo* imageInfo, const VkDescriptorBufferInfo* bufferInfo)
+	{
+		if (index == s_InvalidBindlessIndex)
+			return;
+
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+
+			HandleList& list = m_Handles[static_cast<uint32_t>(type)];
+			if (imageInfo != nullptr)
+			{
+				if (list.myImages.size() <= index)
+					list.myImages.resize(index + 1);
+
+				list.myImages[index] = *imageInfo;
+			}
+
+			if (bufferInfo != nullptr)
+			{
+				if (list.myBuffers.size() <= index)
+					list.myBuffers.resize(index + 1);
+
+				list.myBuffers[index] = *bufferInfo;
+			}
+		}
+
+		const VkDescriptorType descriptorType = s_BindlessTypes[static_cast<uint32_t>(type)];
+		if (m_BufferRegion.mySize > 0)
+		{
+			const VkDeviceSize offset = m_BufferRegion.myOffset + m_BindingOffsets[static_cast<uint32_t>(type)] +
+				Gfx_DescriptorBuffer::GetDescriptorSize(descriptorType) * index;
+
+			Gfx_RenderContext::GetDescriptorBuffer().Write(offset, descriptorType, imageInfo, bufferInfo);
+			return;
+		}
+
+		VkWriteDescriptorSet writeSet = {};
+		writeSet.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		writeSet.dstSet = m_Set;
+		writeSet.dstBinding = static_cast<uint32_t>(type);
+		writeSet.dstArrayElement = index;
+		writeSet.descriptorCount = 1;
+		writeSet.descriptorType = descriptorType;
+		writeSet.pImageInfo = imageInfo;
+		writeSet.pBufferInfo = bufferInfo;
+
+		vkUpdateDescriptorSets(Gfx_App::GetDevice().GetLogicalDevice(), 1, &writeSet, 0, nullptr);
+	}
+}
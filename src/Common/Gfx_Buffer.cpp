@@ -1,21 +1,80 @@
 #include "Gfx_Precompiled.h"
 #include "Common/Gfx_Buffer.h"
 #include "Common/Gfx_CmdBuffer.h"
+#include "Common/Gfx_BufferArena.h"
 
 #include "Backend/Gfx_VulkanHelpers.h"
 
+#include "Gfx_RenderContext.h"
+
 #include <vulkan_memory_allocator/vk_mem_alloc.h>
 
 namespace SmolEngine
 {
+	// Copies through a transient staging buffer and waits for the copy
+	static void locUpload(const void* data, size_t size, VkBuffer dst, VkDeviceSize dstOffset)
+	{
+		BufferCreateDesc stagingDesc{};
+		stagingDesc.myData = const_cast<void*>(data);
+		stagingDesc.mySize = size;
+		stagingDesc.myFlags = BufferCreateDesc::CreateFlags::Staging;
+		stagingDesc.myPool = MemoryPool::Transient;
+
+		Gfx_Buffer stagingBuffer{};
+		stagingBuffer.Create(stagingDesc);
+
+		Gfx_CmdBuffer cmdBuffer{};
+		CmdBufferCreateDesc cmdDesc{};
+		cmdBuffer.Create(&cmdDesc);
+
+		cmdBuffer.CmdBeginRecord();
+		{
+			VkBufferCopy copyRegion = { };
+			copyRegion.dstOffset = dstOffset;
+			copyRegion.size = size;
+			vkCmdCopyBuffer(
+				cmdBuffer.GetBuffer(),
+				stagingBuffer.GetRawBuffer(),
+				dst,
+				1,
+				&copyRegion);
+		}
+		cmdBuffer.CmdEndRecord();
+	}
+
+	// Views only cover the flags that either map or copy into the arena memory
+	static bool locIsArenaCompatible(const BufferCreateDesc& desc)
+	{
+		if (desc.myArena == nullptr)
+			return false;
+
+		switch (desc.myFlags)
+		{
+		case BufferCreateDesc::CreateFlags::Static:
+			return true;
+		case BufferCreateDesc::CreateFlags::Default:
+			return (desc.myMemUsage == VMA_MEMORY_USAGE_GPU_ONLY) == (desc.myArena->GetMappedData() == nullptr);
+		default:
+			return false;
+		}
+	}
+
 	Gfx_Buffer::Gfx_Buffer() :
 		m_Mapped{nullptr},
 		m_Buffer{nullptr},
+		m_RelocatedBuffer{nullptr},
 		m_BufferView{nullptr},
+		m_BufferViewFormat{VK_FORMAT_UNDEFINED},
 		m_Alloc{nullptr},
 		m_Size{0},
 		m_Offset{0},
-		m_DeviceAddress{0} {}
+		m_DeviceAddress{0},
+		m_Usage{0},
+		m_SharingMode{VK_SHARING_MODE_EXCLUSIVE},
+		m_BindlessIndex{s_InvalidBindlessIndex},
+		m_IsRelocatable{false},
+		m_Arena{nullptr},
+		m_ArenaAlloc{VK_NULL_HANDLE} {}
 
 	Gfx_Buffer::~Gfx_Buffer()
 	{
@@ -24,8 +83,64 @@ namespace SmolEngine
 
 	void Gfx_Buffer::Create(const BufferCreateDesc& desc)
 	{
+		GFX_PROFILE_SCOPE("Gfx_Buffer::Create")
+
 		VkDevice device = Gfx_App::GetDevice().GetLogicalDevice();
 
+		// Descriptor buffers reference uniform and storage buffers by device address
+		VkBufferUsageFlags usage = desc.myBufferUsage;
+		if (Gfx_App::GetDevice().GetDescriptorBufferSupport() && (usage & (VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT)))
+			usage |= VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT;
+
+		m_SharingMode = desc.mySharingMode;
+
+		// Small buffers become views into the arena's buffer, anything it refuses gets an allocation of its own
+		VkDeviceSize arenaOffset = 0;
+		if (locIsArenaCompatible(desc) && desc.myArena->Allocate(this, desc.mySize, usage, m_ArenaAlloc, arenaOffset))
+			CreateView(desc, usage, arenaOffset);
+		else
+			CreateAllocation(desc, usage);
+
+		// Storage buffers are addressable from shaders through the bindless heap
+		if ((m_Usage & VK_BUFFER_USAGE_STORAGE_BUFFER_BIT) && desc.myFlags != BufferCreateDesc::CreateFlags::Scratch && Gfx_RenderContext::s_Instance)
+			m_BindlessIndex = Gfx_RenderContext::GetBindlessHeap().RegisterBuffer(this);
+	}
+
+	void Gfx_Buffer::CreateView(const BufferCreateDesc& desc, VkBufferUsageFlags usage, VkDeviceSize offset)
+	{
+		m_Arena = desc.myArena;
+		m_Buffer = m_Arena->GetRawBuffer();
+		m_Offset = offset;
+		m_Size = desc.mySize;
+		m_Usage = usage;
+
+		if (usage & VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT)
+			m_DeviceAddress = m_Arena->GetDeviceAddress() + offset;
+
+		if (desc.myData == nullptr)
+			return;
+
+		if (m_Arena->GetMappedData() != nullptr)
+		{
+			memcpy(m_Arena->GetMappedData() + offset, desc.myData, desc.mySize);
+			m_Arena->Flush(offset, desc.mySize);
+		}
+		else
+			locUpload(desc.myData, desc.mySize, m_Buffer, offset);
+	}
+
+	void Gfx_Buffer::CreateAllocation(const BufferCreateDesc& desc, VkBufferUsageFlags usage)
+	{
+		// Device local buffers that nothing references by address may be moved by Defragment, which copies them
+		const bool isDeviceLocal = desc.myFlags == BufferCreateDesc::CreateFlags::Static ||
+			(desc.myFlags == BufferCreateDesc::CreateFlags::Default && desc.myMemUsage == VMA_MEMORY_USAGE_GPU_ONLY);
+		const VkBufferUsageFlags addressUsage = VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT | VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_STORAGE_BIT_KHR |
+			VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR;
+
+		m_IsRelocatable = isDeviceLocal && (usage & addressUsage) == 0 && (desc.myPool == MemoryPool::Default || desc.myPool == MemoryPool::Geometry);
+		if (m_IsRelocatable)
+			usage |= VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+
 		switch (desc.myFlags)
 		{
 		case BufferCreateDesc::CreateFlags::Default:
@@ -33,12 +148,12 @@ namespace SmolEngine
 			VkBufferCreateInfo bufferCI = {};
 			bufferCI.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
 			bufferCI.size = desc.mySize;
-			bufferCI.usage = desc.myBufferUsage;
+			bufferCI.usage = usage;
 			bufferCI.sharingMode = desc.mySharingMode;
 
-			m_Alloc = Gfx_VulkanAllocator::AllocBuffer(bufferCI, desc.myMemUsage, m_Buffer);
+			m_Alloc = Gfx_VulkanAllocator::AllocBuffer(bufferCI, desc.myMemUsage, m_Buffer, desc.myPool);
 			m_Size = desc.mySize;
-			m_Usage = desc.myBufferUsage;
+			m_Usage = usage;
 
 			if (desc.myData != nullptr)
 				SetData(desc.myData, desc.mySize);
@@ -55,7 +170,7 @@ namespace SmolEngine
 			bufferCI.sharingMode = desc.mySharingMode;
 			bufferCI.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
 
-			m_Alloc = Gfx_VulkanAllocator::AllocBuffer(bufferCI, VMA_MEMORY_USAGE_CPU_TO_GPU, m_Buffer);
+			m_Alloc = Gfx_VulkanAllocator::AllocBuffer(bufferCI, VMA_MEMORY_USAGE_CPU_TO_GPU, m_Buffer, desc.myPool);
 			m_Size = desc.mySize;
 			m_Usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
 
@@ -66,41 +181,17 @@ namespace SmolEngine
 
 		case BufferCreateDesc::CreateFlags::Static:
 		{
-			BufferCreateDesc stagingDesc{};
-			stagingDesc.myData = desc.myData;
-			stagingDesc.mySize = desc.mySize;
-			stagingDesc.myFlags = BufferCreateDesc::CreateFlags::Staging;
-
-			Gfx_Buffer stagingBuffer{};
-			stagingBuffer.Create(stagingDesc);
-
 			VkBufferCreateInfo bufferCI = {};
 			bufferCI.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
 			bufferCI.size = desc.mySize;
-			bufferCI.usage = desc.myBufferUsage;
+			bufferCI.usage = usage;
 			bufferCI.sharingMode = desc.mySharingMode;
 
-			m_Alloc = Gfx_VulkanAllocator::AllocBuffer(bufferCI, VMA_MEMORY_USAGE_GPU_ONLY, m_Buffer);
+			m_Alloc = Gfx_VulkanAllocator::AllocBuffer(bufferCI, VMA_MEMORY_USAGE_GPU_ONLY, m_Buffer, desc.myPool);
 			m_Size = desc.mySize;
-			m_Usage = desc.myBufferUsage;
-
-			Gfx_CmdBuffer cmdBuffer{};
-			CmdBufferCreateDesc cmdDesc{};
-			cmdBuffer.Create(&cmdDesc);
-
-			cmdBuffer.CmdBeginRecord();
-			{
-				VkBufferCopy copyRegion = { };
-				copyRegion.size = m_Size;
-				vkCmdCopyBuffer(
-					cmdBuffer.GetBuffer(),
-					stagingBuffer.GetRawBuffer(),
-					m_Buffer,
-					1,
-					&copyRegion);
-			}
-			cmdBuffer.CmdEndRecord();
+			m_Usage = usage;
 
+			locUpload(desc.myData, desc.mySize, m_Buffer, 0);
 			break;
 		}
 		case BufferCreateDesc::CreateFlags::Scratch:
@@ -110,7 +201,7 @@ namespace SmolEngine
 			bufferInfo.size = desc.mySize;
 			bufferInfo.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT;
 
-			m_Alloc = Gfx_VulkanAllocator::AllocBuffer(bufferInfo, VMA_MEMORY_USAGE_GPU_ONLY, m_Buffer);
+			m_Alloc = Gfx_VulkanAllocator::AllocBuffer(bufferInfo, VMA_MEMORY_USAGE_GPU_ONLY, m_Buffer, desc.myPool);
 
 			VkBufferDeviceAddressInfoKHR bufferDeviceAddressInfo{};
 			bufferDeviceAddressInfo.sType = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO;
@@ -124,14 +215,34 @@ namespace SmolEngine
 		}
 		} 
 
-		if(desc.myBufferUsage & VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT)
+		if(usage & VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT)
 			m_DeviceAddress = Gfx_VulkanHelpers::GetBufferDeviceAddress(m_Buffer);
+
+		if (m_IsRelocatable && m_Alloc != nullptr)
+			Gfx_VulkanAllocator::RegisterRelocatable(m_Alloc, this);
 	}
 
 	void Gfx_Buffer::Free()
 	{
+		if (m_BindlessIndex != s_InvalidBindlessIndex && Gfx_RenderContext::s_Instance)
+		{
+			Gfx_RenderContext::GetBindlessHeap().Release(BindlessType::StorageBuffer, m_BindlessIndex);
+			m_BindlessIndex = s_InvalidBindlessIndex;
+		}
+
+		VK_DESTROY_DEVICE_HANDLE(m_BufferView, vkDestroyBufferView);
+
+		if (m_Arena != nullptr)
+		{
+			m_Arena->Release(this, m_ArenaAlloc);
+			DetachArena();
+		}
+
 		if (m_Alloc != nullptr)
 		{
+			if (m_IsRelocatable)
+				Gfx_VulkanAllocator::UnregisterRelocatable(m_Alloc);
+
 			Gfx_VulkanAllocator::FreeBuffer(m_Buffer, m_Alloc);
 
 			m_Size = 0;
@@ -141,27 +252,51 @@ namespace SmolEngine
 		}
 	}
 
+	void Gfx_Buffer::DetachArena()
+	{
+		VK_DESTROY_DEVICE_HANDLE(m_BufferView, vkDestroyBufferView);
+
+		m_Size = 0;
+		m_Offset = 0;
+		m_DeviceAddress = 0;
+		m_Arena = nullptr;
+		m_ArenaAlloc = VK_NULL_HANDLE;
+		m_Mapped = nullptr;
+		m_Buffer = nullptr;
+	}
+
 	bool Gfx_Buffer::IsGood() const
 	{
-		return m_Alloc != nullptr;
+		return m_Alloc != nullptr || m_Arena != nullptr;
 	}
 
 	void Gfx_Buffer::SetData(const void* data, size_t size, uint32_t offset)
 	{
-		void* dest = MapMemory();
+		GFX_ASSERT_MSG((offset + size <= m_Size), "Gfx_Buffer: SetData range is outside the buffer")
+
+		uint8_t* dest = static_cast<uint8_t*>(MapMemory());
 		{
-			memcpy(dest, data, size);
+			memcpy(dest + offset, data, size);
 		}
 		UnMapMemory();
 	}
 
 	void Gfx_Buffer::ResetBufferUint(VkCommandBuffer cmd, uint32_t value)
 	{
-		vkCmdFillBuffer(cmd, m_Buffer, 0, m_Size, value);
+		vkCmdFillBuffer(cmd, m_Buffer, m_Offset, m_Size, value);
 	}
 
 	void* Gfx_Buffer::MapMemory()
 	{
+		// The arena stays mapped, a view only points into it
+		if (m_Arena != nullptr)
+		{
+			GFX_ASSERT_MSG((m_Arena->GetMappedData() != nullptr), "Gfx_Buffer: the arena of this view is not host visible")
+
+			m_Mapped = m_Arena->GetMappedData() + m_Offset;
+			return m_Mapped;
+		}
+
 		uint8_t* destData = Gfx_VulkanAllocator::MapMemory(m_Alloc);
 		m_Mapped = destData;
 		return m_Mapped;
@@ -169,6 +304,16 @@ namespace SmolEngine
 
 	void Gfx_Buffer::UnMapMemory()
 	{
+		if (m_Arena != nullptr)
+		{
+			// Whatever was written through the mapping is flushed, the arena itself stays mapped
+			if (m_Mapped != nullptr)
+				m_Arena->Flush(m_Offset, m_Size);
+
+			m_Mapped = nullptr;
+			return;
+		}
+
 		if (m_Mapped != nullptr)
 		{
 			Gfx_VulkanAllocator::UnmapMemory(m_Alloc);
@@ -211,6 +356,62 @@ namespace SmolEngine
 		return m_Usage;
 	}
 
+	uint32_t Gfx_Buffer::GetBindlessIndex() const
+	{
+		return m_BindlessIndex;
+	}
+
+	bool Gfx_Buffer::CmdRelocate(VkCommandBuffer cmd, VmaAllocation dstAllocation)
+	{
+		// A mapping would keep pointing at the old memory
+		if (m_Mapped != nullptr)
+			return false;
+
+		VkBufferCreateInfo bufferCI = {};
+		bufferCI.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+		bufferCI.size = m_Size;
+		bufferCI.usage = m_Usage;
+		bufferCI.sharingMode = m_SharingMode;
+
+		VkDevice device = Gfx_App::GetDevice().GetLogicalDevice();
+		VK_CHECK_RESULT(vkCreateBuffer(device, &bufferCI, nullptr, &m_RelocatedBuffer));
+		VK_CHECK_RESULT(Gfx_VulkanAllocator::BindBuffer(dstAllocation, m_RelocatedBuffer));
+
+		VkBufferCopy copyRegion = {};
+		copyRegion.size = m_Size;
+		vkCmdCopyBuffer(cmd, m_Buffer, m_RelocatedBuffer, 1, &copyRegion);
+		return true;
+	}
+
+	void Gfx_Buffer::OnRelocated(MemoryRelocations& relocations)
+	{
+		VkDevice device = Gfx_App::GetDevice().GetLogicalDevice();
+
+		// Texel buffer views reference the old buffer and go first
+		const VkBufferView oldView = m_BufferView;
+		if (oldView != nullptr)
+			vkDestroyBufferView(device, oldView, nullptr);
+
+		vkDestroyBuffer(device, m_Buffer, nullptr);
+		relocations.Add(m_Buffer, m_RelocatedBuffer);
+
+		m_Buffer = m_RelocatedBuffer;
+		m_RelocatedBuffer = nullptr;
+
+		if (oldView != nullptr)
+		{
+			VkBufferViewCreateInfo viewCI = {};
+			viewCI.sType = VK_STRUCTURE_TYPE_BUFFER_VIEW_CREATE_INFO;
+			viewCI.buffer = m_Buffer;
+			viewCI.format = m_BufferViewFormat;
+			viewCI.offset = 0;
+			viewCI.range = VK_WHOLE_SIZE;
+
+			VK_CHECK_RESULT(vkCreateBufferView(device, &viewCI, nullptr, &m_BufferView));
+			relocations.Add(oldView, m_BufferView);
+		}
+	}
+
 	BufferCreateDesc::BufferCreateDesc()
 		:
 		myData{nullptr},
@@ -218,6 +419,8 @@ namespace SmolEngine
 		myBufferUsage{0},
 		mySharingMode{VkSharingMode::VK_SHARING_MODE_EXCLUSIVE},
 		myMemUsage{VMA_MEMORY_USAGE_CPU_TO_GPU},
+		myPool{MemoryPool::Default},
+		myArena{nullptr},
 		myFlags{CreateFlags::Default} {}
 
 }
\ No newline at end of file
@@ -0,0 +1,163 @@
+#include "Gfx_Precompiled.h"
+#include "Common/Gfx_BufferArena.h"
+#include "Common/Gfx_Buffer.h"
+
+#include "Backend/Gfx_VulkanHelpers.h"
+
+#include <vulkan_memory_allocator/vk_mem_alloc.h>
+
+namespace SmolEngine
+{
+	BufferArenaCreateDesc::BufferArenaCreateDesc()
+		:
+		mySize{32 * 1024 * 1024},
+		myMaxAllocationSize{1024 * 1024},
+		myBufferUsage{0},
+		myMemUsage{VMA_MEMORY_USAGE_GPU_ONLY},
+		myPool{MemoryPool::Default} {}
+
+	Gfx_BufferArena::Gfx_BufferArena()
+		:
+		m_Buffer{nullptr},
+		m_Alloc{nullptr},
+		m_Block{nullptr},
+		m_Mapped{nullptr},
+		m_DeviceAddress{0},
+		m_Alignment{16} {}
+
+	Gfx_BufferArena::~Gfx_BufferArena()
+	{
+		Free();
+	}
+
+	void Gfx_BufferArena::Create(const BufferArenaCreateDesc& desc)
+	{
+		m_Desc = desc;
+
+		VkBufferCreateInfo bufferCI = {};
+		bufferCI.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+		bufferCI.size = desc.mySize;
+		bufferCI.usage = desc.myBufferUsage;
+		bufferCI.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+		m_Alloc = Gfx_VulkanAllocator::AllocBuffer(bufferCI, desc.myMemUsage, m_Buffer, desc.myPool);
+		if (m_Alloc == nullptr)
+			return;
+
+		if (desc.myBufferUsage & VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT)
+			m_DeviceAddress = Gfx_VulkanHelpers::GetBufferDeviceAddress(m_Buffer);
+
+		if (desc.myMemUsage != VMA_MEMORY_USAGE_GPU_ONLY)
+			m_Mapped = Gfx_VulkanAllocator::MapMemory(m_Alloc);
+
+		// Every view may be bound as a uniform or storage range, mapped views also stay apart by a non coherent atom
+		const VkPhysicalDeviceLimits& limits = Gfx_App::GetDevice().GetDeviceProperties()->limits;
+		m_Alignment = std::max({ VkDeviceSize(16), limits.minUniformBufferOffsetAlignment, limits.minStorageBufferOffsetAlignment,
+			m_Mapped != nullptr ? limits.nonCoherentAtomSize : VkDeviceSize(1) });
+
+		VmaVirtualBlockCreateInfo blockCI = {};
+		blockCI.size = desc.mySize;
+
+		VK_CHECK_RESULT(vmaCreateVirtualBlock(&blockCI, &m_Block));
+	}
+
+	void Gfx_BufferArena::Free()
+	{
+		if (m_Block != nullptr)
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+
+			// Meshes and uniform buffers held by user code are commonly released after the render context
+			if (!m_Views.empty())
+			{
+				std::string message = std::format("Gfx_BufferArena: detaching {} views that outlive the arena", m_Views.size());
+				GFX_LOG(message, Gfx_Log::Level::Warning)
+
+				for (Gfx_Buffer* view : m_Views)
+					view->DetachArena();
+
+				m_Views.clear();
+			}
+
+			vmaClearVirtualBlock(m_Block);
+			vmaDestroyVirtualBlock(m_Block);
+			m_Block = nullptr;
+		}
+
+		if (m_Alloc != nullptr)
+		{
+			if (m_Mapped != nullptr)
+				Gfx_VulkanAllocator::UnmapMemory(m_Alloc);
+
+			Gfx_VulkanAllocator::FreeBuffer(m_Buffer, m_Alloc);
+
+			m_Buffer = nullptr;
+			m_Alloc = nullptr;
+			m_Mapped = nullptr;
+			m_DeviceAddress = 0;
+		}
+	}
+
+	bool Gfx_BufferArena::IsGood() const
+	{
+		return m_Block != nullptr;
+	}
+
+	bool Gfx_BufferArena::Allocate(Gfx_Buffer* view, size_t size, VkBufferUsageFlags usage, VmaVirtualAllocation& outAllocation, VkDeviceSize& outOffset)
+	{
+		if (!IsGood() || size == 0 || size > m_Desc.myMaxAllocationSize || (usage & ~m_Desc.myBufferUsage) != 0)
+			return false;
+
+		VmaVirtualAllocationCreateInfo allocCI = {};
+		allocCI.size = size;
+		allocCI.alignment = m_Alignment;
+
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		if (vmaVirtualAllocate(m_Block, &allocCI, &outAllocation, &outOffset) != VK_SUCCESS)
+			return false;
+
+		m_Views.insert(view);
+		return true;
+	}
+
+	void Gfx_BufferArena::Release(Gfx_Buffer* view, VmaVirtualAllocation allocation)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		vmaVirtualFree(m_Block, allocation);
+		m_Views.erase(view);
+	}
+
+	void Gfx_BufferArena::Flush(VkDeviceSize offset, VkDeviceSize size)
+	{
+		if (m_Mapped != nullptr)
+			Gfx_VulkanAllocator::FlushMemory(m_Alloc, offset, size);
+	}
+
+	size_t Gfx_BufferArena::GetUsedBytes()
+	{
+		if (!IsGood())
+			return 0;
+
+		VmaStatistics stats = {};
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			vmaGetVirtualBlockStatistics(m_Block, &stats);
+		}
+
+		return stats.allocationBytes;
+	}
+
+	uint32_t Gfx_BufferArena::GetAllocationCount()
+	{
+		if (!IsGood())
+			return 0;
+
+		VmaStatistics stats = {};
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			vmaGetVirtualBlockStatistics(m_Block, &stats);
+		}
+
+		return stats.allocationCount;
+	}
+}
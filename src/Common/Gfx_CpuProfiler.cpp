@@ -0,0 +1,202 @@
+#include "Gfx_Precompiled.h"
+#include "Common/Gfx_CpuProfiler.h"
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <format>
+
+namespace SmolEngine
+{
+	// Per thread, a chunk is allocated the first time it is reached and reused by later captures
+	static const uint32_t s_CpuProfilerChunkSize = 16 * 1024;
+	static const uint32_t s_CpuProfilerMaxChunks = 64;
+
+	struct CpuEvent
+	{
+		const char* myName;
+		uint64_t myStart;
+		uint64_t myEnd;
+	};
+
+	// Written only by its own thread, the count is published after the event so Export never sees a partial one
+	struct CpuThreadBuffer
+	{
+		~CpuThreadBuffer()
+		{
+			for (std::atomic<CpuEvent*>& chunk : myChunks)
+				delete[] chunk.load();
+		}
+
+		std::atomic<CpuEvent*> myChunks[s_CpuProfilerMaxChunks] = {};
+		std::atomic<uint32_t> myCount = 0;
+		std::atomic<uint32_t> myCapture = 0;
+		uint32_t myThreadIndex = 0;
+		std::string myName;
+	};
+
+	static const std::chrono::steady_clock::time_point s_CpuProfilerOrigin = std::chrono::steady_clock::now();
+	static std::atomic<bool> s_CpuProfilerRecording = false;
+	static std::atomic<uint32_t> s_CpuProfilerCapture = 0;
+	static std::atomic<uint64_t> s_CpuProfilerDropped = 0;
+
+	// Buffers outlive their threads so a capture keeps the events of workers that already exited
+	static std::mutex s_CpuProfilerMutex;
+	static std::vector<std::unique_ptr<CpuThreadBuffer>> s_CpuProfilerBuffers;
+	static thread_local CpuThreadBuffer* s_CpuProfilerThreadBuffer = nullptr;
+
+	static CpuThreadBuffer* locGetThreadBuffer()
+	{
+		if (s_CpuProfilerThreadBuffer == nullptr)
+		{
+			std::lock_guard<std::mutex> lock(s_CpuProfilerMutex);
+
+			s_CpuProfilerThreadBuffer = s_CpuProfilerBuffers.emplace_back(std::make_unique<CpuThreadBuffer>()).get();
+			s_CpuProfilerThreadBuffer->myThreadIndex = static_cast<uint32_t>(s_CpuProfilerBuffers.size());
+			s_CpuProfilerThreadBuffer->myCapture = s_CpuProfilerCapture.load();
+		}
+
+		return s_CpuProfilerThreadBuffer;
+	}
+
+	static std::string locEscape(const std::string& str)
+	{
+		std::string result;
+		for (const char c : str)
+		{
+			if (c == '\\' || c == '"')
+				result += '\\';
+
+			result += c;
+		}
+
+		return result;
+	}
+
+	void Gfx_CpuProfiler::Start()
+	{
+		s_CpuProfilerDropped = 0;
+		s_CpuProfilerCapture++;
+		s_CpuProfilerRecording = true;
+	}
+
+	void Gfx_CpuProfiler::Stop()
+	{
+		s_CpuProfilerRecording = false;
+	}
+
+	bool Gfx_CpuProfiler::IsRecording()
+	{
+		return s_CpuProfilerRecording.load(std::memory_order_relaxed);
+	}
+
+	bool Gfx_CpuProfiler::Export(const std::string& filePath)
+	{
+		std::ofstream file(filePath);
+		if (!file.is_open())
+		{
+			std::string message = "Gfx_CpuProfiler: failed to write " + filePath;
+			GFX_LOG(message, Gfx_Log::Level::Error)
+			return false;
+		}
+
+		const uint32_t capture = s_CpuProfilerCapture.load();
+		std::lock_guard<std::mutex> lock(s_CpuProfilerMutex);
+
+		// Complete events in microseconds, nesting is recovered from the times
+		file << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+
+		bool isFirst = true;
+		for (const std::unique_ptr<CpuThreadBuffer>& buffer : s_CpuProfilerBuffers)
+		{
+			const uint32_t count = buffer->myCapture.load(std::memory_order_acquire) == capture ? buffer->myCount.load(std::memory_order_acquire) : 0;
+			if (count == 0)
+				continue;
+
+			const std::string name = buffer->myName.empty() ? std::format("Thread {}", buffer->myThreadIndex) : buffer->myName;
+			file << std::format("{}{{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": {}, \"args\": {{\"name\": \"{}\"}}}}",
+				isFirst ? "" : ",\n", buffer->myThreadIndex, locEscape(name));
+			isFirst = false;
+
+			for (uint32_t i = 0; i < count; ++i)
+			{
+				const CpuEvent& event = buffer->myChunks[i / s_CpuProfilerChunkSize].load(std::memory_order_acquire)[i % s_CpuProfilerChunkSize];
+				file << std::format(",\n{{\"name\": \"{}\", \"cat\": \"cpu\", \"ph\": \"X\", \"pid\": 1, \"tid\": {}, \"ts\": {:.3f}, \"dur\": {:.3f}}}",
+					locEscape(event.myName), buffer->myThreadIndex, event.myStart / 1000.0, (event.myEnd - event.myStart) / 1000.0);
+			}
+		}
+
+		file << "\n]}\n";
+
+		const uint64_t dropped = s_CpuProfilerDropped.load();
+		if (dropped > 0)
+		{
+			std::string message = std::format("Gfx_CpuProfiler: {} events did not fit the thread buffers", dropped);
+			GFX_LOG(message, Gfx_Log::Level::Warning)
+		}
+
+		return true;
+	}
+
+	void Gfx_CpuProfiler::SetThreadName(const std::string& name)
+	{
+		CpuThreadBuffer* buffer = locGetThreadBuffer();
+
+		std::lock_guard<std::mutex> lock(s_CpuProfilerMutex);
+		buffer->myName = name;
+	}
+
+	void Gfx_CpuProfiler::Record(const char* name, uint64_t start, uint64_t end)
+	{
+		CpuThreadBuffer* buffer = locGetThreadBuffer();
+
+		// The first event of a new capture rewinds this thread's buffer
+		const uint32_t capture = s_CpuProfilerCapture.load(std::memory_order_relaxed);
+		uint32_t index = buffer->myCount.load(std::memory_order_relaxed);
+		if (buffer->myCapture.load(std::memory_order_relaxed) != capture)
+		{
+			// Cleared before the capture changes so Export never pairs the new capture with old events
+			buffer->myCount.store(0, std::memory_order_release);
+			buffer->myCapture.store(capture, std::memory_order_release);
+			index = 0;
+		}
+
+		const uint32_t chunkIndex = index / s_CpuProfilerChunkSize;
+		if (chunkIndex >= s_CpuProfilerMaxChunks)
+		{
+			s_CpuProfilerDropped.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+
+		CpuEvent* chunk = buffer->myChunks[chunkIndex].load(std::memory_order_relaxed);
+		if (chunk == nullptr)
+		{
+			chunk = new CpuEvent[s_CpuProfilerChunkSize];
+			buffer->myChunks[chunkIndex].store(chunk, std::memory_order_release);
+		}
+
+		chunk[index % s_CpuProfilerChunkSize] = { name, start, end };
+		buffer->myCount.store(index + 1, std::memory_order_release);
+	}
+
+	uint64_t Gfx_CpuProfiler::GetTime()
+	{
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - s_CpuProfilerOrigin).count();
+	}
+
+	Gfx_CpuScope::Gfx_CpuScope(const char* name)
+		:
+		m_Name{name},
+		m_Start{0}
+	{
+		if (Gfx_CpuProfiler::IsRecording())
+			m_Start = Gfx_CpuProfiler::GetTime();
+	}
+
+	Gfx_CpuScope::~Gfx_CpuScope()
+	{
+		// A scope that began before Start is dropped rather than stretched back to zero
+		if (m_Start != 0 && Gfx_CpuProfiler::IsRecording())
+			Gfx_CpuProfiler::Record(m_Name, m_Start, Gfx_CpuProfiler::GetTime());
+	}
+}
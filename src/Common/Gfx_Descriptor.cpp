@@ -8,11 +8,12 @@
 
 #include "Tools/Gfx_ShaderCompiler.h"
 
-#include <spirv_cross/spirv_cross.hpp>
-#include <spirv_cross/spirv_glsl.hpp>
-
 namespace SmolEngine
 {
+	// Live descriptors, patched when defragmentation moves the resources they reference
+	static std::mutex s_DescriptorMutex;
+	static std::unordered_set<Gfx_Descriptor*> s_Descriptors;
+
 	static VkDescriptorType locGetDescriptorType(DescriptorType type)
 	{
 		switch (type)
@@ -81,110 +82,95 @@ namespace SmolEngine
 
 	void DescriptorCreateDesc::Reflect(Gfx_Shader* shader)
 	{
-		const auto locAddElementFn = [this](ShaderStage stage, DescriptorType descriptorType, const spirv_cross::Compiler& compiler, const spirv_cross::Resource& res)
+		const ShaderReflection& reflection = shader->GetReflection();
+
+		if (reflection.myPushConstant.has_value())
 		{
-			auto& type = compiler.get_type(res.base_type_id);
+			PushConstantsDesc pcDesc;
+			pcDesc.myOffset = reflection.myPushConstant->myOffset;
+			pcDesc.mySize = reflection.myPushConstant->mySize;
+			pcDesc.myStages = reflection.myPushConstant->myStages;
+
+			SetPushConstants(&pcDesc);
+		}
 
-			uint32_t binding = compiler.get_decoration(res.id, spv::DecorationBinding);
-			uint32_t bufferElements = static_cast<uint32_t>(type.member_types.size());
+		for (const auto& binding : reflection.myBindings)
+		{
+			// Other sets (e.g. the bindless heap) are not owned by the descriptor
+			if (binding.mySet != mySet)
+				continue;
 
 			DescriptorDesc desc;
-			desc.myBinding = binding;
-			desc.myElements = bufferElements == 0 ? 1 : bufferElements;
-			desc.myName = res.name;
-			desc.myType = descriptorType;
-			desc.myStages = stage;
+			desc.myBinding = binding.myBinding;
+			desc.myElements = binding.myCount == 0 ? 1 : binding.myCount;
+			desc.myName = binding.myName;
+			desc.myType = binding.myType;
+			desc.myStages = binding.myStages;
 
-			const auto& it = myBindingIndices.find(binding);
+			const auto& it = myBindingIndices.find(desc.myBinding);
 			if (it != myBindingIndices.end())
 			{
 				GFX_ASSERT(desc.myType == it->second->myType)
 				GFX_ASSERT(desc.myName == it->second->myName)
 				GFX_ASSERT(desc.myElements == it->second->myElements)
 
-				it->second->myStages |= stage;
+				it->second->myStages |= desc.myStages;
 			}
 			else
 			{
 				Add(desc);
 			}
-		};
+		}
+	}
 
-		for (auto& [stage, binaries] : shader->m_Binary)
+	static size_t locGetDescriptorStride(DescriptorType type)
+	{
+		switch (type)
 		{
-			spirv_cross::Compiler compiler(binaries);
-			spirv_cross::ShaderResources resources = compiler.get_shader_resources();
-
-			for (const auto& res : resources.push_constant_buffers)
-			{
-				auto& type = compiler.get_type(res.base_type_id);
-
-				PushConstantsDesc pcDesc;
-				pcDesc.myOffset = 0;
-				pcDesc.mySize = static_cast<uint32_t>(compiler.get_declared_struct_size(type));
-				pcDesc.myStages = stage;
-
-				SetPushConstants(&pcDesc);
-			}
-
-			for (const auto& res : resources.uniform_buffers)
-			{
-				locAddElementFn(stage, DescriptorType::UNIFORM_BUFFER, compiler, res);
-			}
-
-			for (const auto& res : resources.storage_buffers)
-			{
-				locAddElementFn(stage, DescriptorType::STORAGE_BUFFER, compiler, res);
-			}
-
-			for (const auto& res : resources.acceleration_structures)
-			{
-				locAddElementFn(stage, DescriptorType::ACCEL_STRUCTURE, compiler, res);
-			}
-
-			for (const auto& res : resources.sampled_images)
-			{
-				locAddElementFn(stage, DescriptorType::COMBINED_IMAGE_SAMPLER_2D, compiler, res);
-			}
+		case DescriptorType::UNIFORM_BUFFER:
+		case DescriptorType::STORAGE_BUFFER:
+			return sizeof(VkDescriptorBufferInfo);
+		case DescriptorType::ACCEL_STRUCTURE:
+			return sizeof(VkAccelerationStructureKHR);
+		default:
+			return sizeof(VkDescriptorImageInfo);
+		}
+	}
 
-			for (const auto& res : resources.storage_images)
-			{
-				locAddElementFn(stage, DescriptorType::IMAGE_2D, compiler, res);
-			}
+	// Push layouts are capped by maxPushDescriptors, bigger sets use the frame lifetime fallback
+	static bool locIsPushSupported(const std::vector<VkDescriptorSetLayoutBinding>& layouts)
+	{
+		const Gfx_VulkanDevice& device = Gfx_App::GetDevice();
+		if (!device.GetPushDescriptorSupport())
+			return false;
 
-			for (const auto& res : resources.separate_images)
-			{
-				locAddElementFn(stage, DescriptorType::TEXTURE_2D, compiler, res);
-			}
+		uint32_t count = 0;
+		for (const VkDescriptorSetLayoutBinding& binding : layouts)
+			count += binding.descriptorCount;
 
-			for (const auto& res : resources.separate_samplers)
-			{
-				locAddElementFn(stage, DescriptorType::SEPARATE_SAMPLER, compiler, res);
-			}
-		}
+		return count <= device.pushDescriptorProperties.maxPushDescriptors;
 	}
 
 	Gfx_Descriptor::Gfx_Descriptor()
 		:
-		m_Pool{nullptr},
 		m_Layout{nullptr},
-		m_DescriptorSet{nullptr} {}
-
-	void Gfx_Descriptor::Create(DescriptorCreateDesc* desc)
+		m_DescriptorSet{nullptr},
+		m_UpdateTemplate{nullptr},
+		m_DirtyDescriptors{0},
+		m_TotalDescriptors{0},
+		m_SetIndex{0},
+		m_IsPushDescriptor{false},
+		m_IsPushSupported{false} {}
+
+	Gfx_Descriptor::~Gfx_Descriptor()
 	{
-		if (desc->myPushConstant.mySize > 0)
-		{
-			VkPushConstantRange range;
-			range.size = desc->myPushConstant.mySize;
-			range.stageFlags = Gfx_VulkanHelpers::GetShaderStage(desc->myPushConstant.myStages);
-			range.offset = desc->myPushConstant.myOffset;
-
-			m_PushConstantRange.emplace(range);
-		}
+		std::lock_guard<std::mutex> lock(s_DescriptorMutex);
+		s_Descriptors.erase(this);
+	}
 
-		VkDevice device = Gfx_App::GetDevice().GetLogicalDevice();
+	std::vector<VkDescriptorSetLayoutBinding> Gfx_Descriptor::GetLayoutBindings(const DescriptorCreateDesc* desc)
+	{
 		std::vector<VkDescriptorSetLayoutBinding> layouts;
-		std::map<DescriptorType, uint32_t> poolMap;
 
 		for (const Ref<DescriptorDesc>& resource : desc->myBindings)
 		{
@@ -195,50 +181,104 @@ namespace SmolEngine
 			layoutBinding.stageFlags = Gfx_VulkanHelpers::GetShaderStage(resource->myStages);
 
 			layouts.emplace_back(layoutBinding);
-			poolMap[resource->myType] += resource->myElements;
 		}
 
-		std::vector<VkDescriptorPoolSize> poolSizes;
+		return layouts;
+	}
 
-		for (auto& [type, count] : poolMap)
+	VkDescriptorSetLayout Gfx_Descriptor::FindLayout(const DescriptorCreateDesc* desc)
+	{
+		return Gfx_RenderContext::GetDescriptorAllocator().GetLayout(GetLayoutBindings(desc));
+	}
+
+	void Gfx_Descriptor::Create(DescriptorCreateDesc* desc)
+	{
+		if (desc->myPushConstant.mySize > 0)
 		{
-			VkDescriptorPoolSize poolSize{};
-			poolSize.descriptorCount = count;
-			poolSize.type = locGetDescriptorType(type);
+			VkPushConstantRange range;
+			range.size = desc->myPushConstant.mySize;
+			range.stageFlags = Gfx_VulkanHelpers::GetShaderStage(desc->myPushConstant.myStages);
+			range.offset = desc->myPushConstant.myOffset;
 
-			poolSizes.emplace_back(poolSize);
+			m_PushConstantRange.emplace(range);
 		}
 
-		VkDescriptorPoolCreateInfo descriptorPoolCI{};
-		{
-			descriptorPoolCI.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-			descriptorPoolCI.pNext = nullptr;
-			descriptorPoolCI.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
-			descriptorPoolCI.pPoolSizes = poolSizes.data();
-			descriptorPoolCI.maxSets = desc->myNumSets;
+		const std::vector<VkDescriptorSetLayoutBinding> layouts = GetLayoutBindings(desc);
+		m_SetIndex = desc->mySet;
 
-			VK_CHECK_RESULT(vkCreateDescriptorPool(device, &descriptorPoolCI, nullptr, &m_Pool));
+		// Layouts and pools are shared between all descriptors
+		Gfx_DescriptorAllocator& allocator = Gfx_RenderContext::GetDescriptorAllocator();
+		Gfx_DescriptorBuffer& descriptorBuffer = Gfx_RenderContext::GetDescriptorBuffer();
+		m_IsPushDescriptor = desc->myIsPushDescriptor;
+
+		if (m_IsPushDescriptor)
+		{
+			m_IsPushSupported = locIsPushSupported(layouts);
+			m_Layout = allocator.GetLayout(layouts, m_IsPushSupported ? VK_DESCRIPTOR_SET_LAYOUT_CREATE_PUSH_DESCRIPTOR_BIT_KHR : 0);
+		}
+		else if (descriptorBuffer.IsGood())
+		{
+			// No pools, the set lives in a region of the descriptor buffer
+			m_Layout = allocator.GetLayout(layouts);
+			m_BufferRegion = descriptorBuffer.Allocate(Gfx_DescriptorBuffer::GetLayoutSize(m_Layout), desc->myLifetime);
+		}
+		else
+		{
+			m_Layout = allocator.GetLayout(layouts);
+			m_Allocation = allocator.Allocate(m_Layout, desc->myLifetime);
+			m_DescriptorSet = m_Allocation.mySet;
 		}
 
-		VkDescriptorSetLayoutCreateInfo layoutCI{};
+		// CPU mirror of the set, sorted by binding so that the template only depends on the layout
+		std::vector<Ref<DescriptorDesc>> resources = desc->myBindings;
+		std::sort(resources.begin(), resources.end(), [](const Ref<DescriptorDesc>& a, const Ref<DescriptorDesc>& b)
 		{
-			layoutCI.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-			layoutCI.bindingCount = static_cast<uint32_t>(layouts.size());
-			layoutCI.pBindings = layouts.data();
+			return a->myBinding < b->myBinding;
+		});
 
-			VK_CHECK_RESULT(vkCreateDescriptorSetLayout(device, &layoutCI, nullptr, &m_Layout));
-		}
+		size_t dataSize = 0;
+		std::vector<VkDescriptorUpdateTemplateEntry> entries;
 
-		VkDescriptorSetAllocateInfo allocateCI{};
+		for (const Ref<DescriptorDesc>& resource : resources)
 		{
-			allocateCI.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-			allocateCI.descriptorPool = m_Pool;
-			allocateCI.descriptorSetCount = 1;
-			allocateCI.pSetLayouts = &m_Layout;
+			BindingData data{};
+			data.myType = resource->myType;
+			data.myVkType = locGetDescriptorType(resource->myType);
+			data.myBinding = resource->myBinding;
+			data.myCount = resource->myElements;
+			data.myStride = locGetDescriptorStride(resource->myType);
+			data.myOffset = dataSize;
+			data.myBufferOffset = descriptorBuffer.IsGood() ? Gfx_DescriptorBuffer::GetBindingOffset(m_Layout, data.myBinding) : 0;
+			data.mySampler = resource->mySampler == nullptr ? Gfx_RenderContext::GetDefaultSampler()->GetSampler() :
+				resource->mySampler->GetSampler();
+
+			VkDescriptorUpdateTemplateEntry entry{};
+			entry.dstBinding = data.myBinding;
+			entry.dstArrayElement = 0;
+			entry.descriptorCount = data.myCount;
+			entry.descriptorType = data.myVkType;
+			entry.offset = data.myOffset;
+			entry.stride = data.myStride;
+
+			entries.push_back(entry);
+			m_BindingData.push_back(data);
+
+			dataSize += data.myStride * data.myCount;
+			m_TotalDescriptors += data.myCount;
+		}
+
+		m_TemplateData.resize(dataSize);
+		if (m_IsPushDescriptor)
+			return;
 
-			VK_CHECK_RESULT(vkAllocateDescriptorSets(device, &allocateCI, &m_DescriptorSet));
+		{
+			std::lock_guard<std::mutex> lock(s_DescriptorMutex);
+			s_Descriptors.insert(this);
 		}
 
+		if (!entries.empty() && m_DescriptorSet != nullptr)
+			m_UpdateTemplate = allocator.GetUpdateTemplate(m_Layout, entries);
+
 		for (const Ref<DescriptorDesc>& resource : desc->myBindings)
 		{
 			if (resource->myType == DescriptorType::SEPARATE_SAMPLER || resource->myType == DescriptorType::IMAGE_2D
@@ -246,91 +286,54 @@ namespace SmolEngine
 			{
 				GFX_ASSERT_MSG((resource->myPixelStorage || resource->mySampler), "myPixelStorage == nullptr || mySampler == nullptr")
 
-				VkDescriptorImageInfo imageInfo{};
-				imageInfo.sampler = resource->mySampler == nullptr ? Gfx_RenderContext::GetDefaultSampler()->GetSampler() :
-					resource->mySampler->GetSampler();
-
-				imageInfo.imageView = resource->myPixelStorage->GetImageView();
-				imageInfo.imageLayout = resource->myPixelStorage->GetImageLayout();
-
-				std::vector<VkDescriptorImageInfo> descriptorImages;
-				descriptorImages.resize(resource->myElements);
-				for (uint32_t i = 0; i < resource->myElements; ++i)
-				{
-					descriptorImages[i] = imageInfo;
-				}
-
-				const VkWriteDescriptorSet& set = CreateImageWriteSet(resource.get(), descriptorImages);
-				vkUpdateDescriptorSets(device, 1, &set, 0, nullptr);
-				m_WriteSets[resource->myBinding] = set;
+				CmdUpdatePixelStorage(resource->myBinding, resource->myPixelStorage.get(), resource->myType);
 				continue;
 			}
 
 			if (resource->myType == DescriptorType::STORAGE_BUFFER || resource->myType == DescriptorType::UNIFORM_BUFFER)
 			{
-				VkDescriptorBufferInfo descriptorBufferInfo;
-
-				const auto& it = m_Buffers.find(resource->myBinding);
-				if (it == m_Buffers.end())
-				{
-					assert(resource->myBuffer != nullptr);
+				GFX_ASSERT(resource->myBuffer != nullptr)
 
-					Ref<BufferObject> obj = std::make_shared<BufferObject>();
-					obj->Buffer = resource->myBuffer;
-					obj->DesriptorInfo.buffer = obj->Buffer->GetRawBuffer();
-					obj->DesriptorInfo.offset = 0;
-					obj->DesriptorInfo.range = obj->Buffer->GetSize();
-
-					descriptorBufferInfo = obj->DesriptorInfo;
-					m_Buffers[resource->myBinding] = obj;
-				}
-				else
-					descriptorBufferInfo = it->second->DesriptorInfo;
-
-				const VkWriteDescriptorSet& set = CreateBufferWriteSet(resource.get(), descriptorBufferInfo);
-				vkUpdateDescriptorSets(device, 1, &set, 0, nullptr);
-				m_WriteSets[resource->myBinding] = set;
+				m_Buffers[resource->myBinding] = resource->myBuffer;
+				CmdUpdateBuffer(resource->myBinding, resource->myBuffer.get(), resource->myType);
 				continue;
 			}
 			 
 			if (resource->myType == DescriptorType::ACCEL_STRUCTURE && resource->myAccelStructure != nullptr) // TODO: assert
 			{
-				VkWriteDescriptorSetAccelerationStructureKHR descriptorAccelerationStructureInfo{};
-				descriptorAccelerationStructureInfo.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET_ACCELERATION_STRUCTURE_KHR;
-				descriptorAccelerationStructureInfo.accelerationStructureCount = 1;
-
-				auto handle = resource->myAccelStructure->GetHandle();
-				descriptorAccelerationStructureInfo.pAccelerationStructures = &handle;
-
-				VkWriteDescriptorSet accelerationStructureWrite{};
-				accelerationStructureWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-				accelerationStructureWrite.pNext = &descriptorAccelerationStructureInfo;
-				accelerationStructureWrite.dstSet = m_DescriptorSet;
-				accelerationStructureWrite.dstBinding = resource->myBinding;
-				accelerationStructureWrite.descriptorCount = resource->myElements;
-				accelerationStructureWrite.descriptorType = VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR;
-
-				vkUpdateDescriptorSets(device, 1, &accelerationStructureWrite, 0, nullptr);
-				m_WriteSets[resource->myBinding] = accelerationStructureWrite;
+				CmdUpdateAccelStructure(resource->myBinding, resource->myAccelStructure.get());
 				continue;
 			}
 		}
+
+		Flush();
 	}
 
 	void Gfx_Descriptor::Free()
 	{
+		{
+			std::lock_guard<std::mutex> lock(s_DescriptorMutex);
+			s_Descriptors.erase(this);
+		}
+
 		m_Buffers.clear();
-		m_WriteSets.clear();
+		m_BindingData.clear();
+		m_TemplateData.clear();
+		m_DirtyDescriptors = 0;
+		m_TotalDescriptors = 0;
 
 		if (m_DescriptorSet != nullptr)
 		{
-			VkDevice device = Gfx_App::GetDevice().GetLogicalDevice();
-			vkFreeDescriptorSets(device, m_Pool, 1, &m_DescriptorSet);
+			Gfx_RenderContext::GetDescriptorAllocator().Release(m_Allocation);
 			m_DescriptorSet = nullptr;
 		}
 
-		VK_DESTROY_DEVICE_HANDLE(m_Layout, vkDestroyDescriptorSetLayout);
-		VK_DESTROY_DEVICE_HANDLE(m_Pool, vkDestroyDescriptorPool);
+		if (m_BufferRegion.mySize > 0)
+			Gfx_RenderContext::GetDescriptorBuffer().Release(m_BufferRegion);
+
+		// Owned by the layout cache
+		m_Layout = nullptr;
+		m_UpdateTemplate = nullptr;
 	}
 
 	bool Gfx_Descriptor::IsGood() const
@@ -340,43 +343,392 @@ namespace SmolEngine
 
 	void Gfx_Descriptor::CmdUpdateBuffer(uint32_t binding, Gfx_Buffer* buffer, DescriptorType type)
 	{
+		BindingData* data = GetBindingData(binding, type);
+		if (data == nullptr)
+			return;
 
+		VkDescriptorBufferInfo* infos = reinterpret_cast<VkDescriptorBufferInfo*>(&m_TemplateData[data->myOffset]);
+		for (uint32_t i = 0; i < data->myCount; ++i)
+		{
+			infos[i].buffer = buffer->GetRawBuffer();
+			infos[i].offset = buffer->GetOffset();
+			infos[i].range = buffer->GetSize();
+		}
+
+		MarkDirty(data);
 	}
 
 	void Gfx_Descriptor::CmdUpdatePixelStorage(uint32_t binding, Gfx_PixelStorage* storage, DescriptorType type)
 	{
+		BindingData* data = GetBindingData(binding, type);
+		if (data == nullptr)
+			return;
 
+		// Every element of the array points to the same image
+		VkDescriptorImageInfo* infos = reinterpret_cast<VkDescriptorImageInfo*>(&m_TemplateData[data->myOffset]);
+		for (uint32_t i = 0; i < data->myCount; ++i)
+		{
+			infos[i].sampler = data->mySampler;
+			infos[i].imageView = storage != nullptr ? storage->GetImageView() : nullptr;
+			infos[i].imageLayout = storage != nullptr ? storage->GetImageLayout() : VK_IMAGE_LAYOUT_UNDEFINED;
+		}
+
+		MarkDirty(data);
 	}
 
 	void Gfx_Descriptor::CmdUpdatePixelStorages(uint32_t binding, const std::vector<Gfx_PixelStorage*>& storages, DescriptorType type)
 	{
+		BindingData* data = GetBindingData(binding, type);
+		if (data == nullptr)
+			return;
+
+		GFX_ASSERT(storages.size() <= data->myCount)
+
+		// Elements past storages.size() keep their previous image
+		VkDescriptorImageInfo* infos = reinterpret_cast<VkDescriptorImageInfo*>(&m_TemplateData[data->myOffset]);
+		const uint32_t count = std::min(static_cast<uint32_t>(storages.size()), data->myCount);
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			infos[i].sampler = data->mySampler;
+			infos[i].imageView = storages[i]->GetImageView();
+			infos[i].imageLayout = storages[i]->GetImageLayout();
+		}
+
+		MarkDirty(data);
 	}
 
-	VkWriteDescriptorSet Gfx_Descriptor::CreateImageWriteSet(const DescriptorDesc* desc, const std::vector<VkDescriptorImageInfo>& infos)
+	void Gfx_Descriptor::CmdUpdateAccelStructure(uint32_t binding, Gfx_AccelStructure* accelStructure)
 	{
-		VkWriteDescriptorSet writeSet = {};
-		writeSet.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-		writeSet.dstSet =  m_DescriptorSet;
-		writeSet.descriptorType = locGetDescriptorType(desc->myType);
-		writeSet.dstArrayElement = 0;
-		writeSet.dstBinding = desc->myBinding;
-		writeSet.descriptorCount = static_cast<uint32_t>(infos.size());
-		writeSet.pImageInfo = infos.data();
+		BindingData* data = GetBindingData(binding, DescriptorType::ACCEL_STRUCTURE);
+		if (data == nullptr)
+			return;
 
-		return writeSet;
+		VkAccelerationStructureKHR* handles = reinterpret_cast<VkAccelerationStructureKHR*>(&m_TemplateData[data->myOffset]);
+		for (uint32_t i = 0; i < data->myCount; ++i)
+			handles[i] = accelStructure->GetHandle();
+
+		MarkDirty(data);
 	}
 
-	VkWriteDescriptorSet Gfx_Descriptor::CreateBufferWriteSet(const DescriptorDesc* desc, const VkDescriptorBufferInfo& info)
+	void Gfx_Descriptor::Flush()
+	{
+		if (m_DirtyDescriptors == 0 || m_IsPushDescriptor)
+			return;
+
+		VkDevice device = Gfx_App::GetDevice().GetLogicalDevice();
+
+		if (m_BufferRegion.mySize > 0)
+		{
+			for (BindingData& data : m_BindingData)
+			{
+				if (data.myIsDirty)
+					WriteDescriptorBuffer(data);
+
+				data.myIsDirty = false;
+			}
+
+			m_DirtyDescriptors = 0;
+			return;
+		}
+
+		bool isComplete = true;
+		for (const BindingData& data : m_BindingData)
+			isComplete &= data.myIsWritten;
+
+		// A template rewrites the whole set in one call, partial writes are cheaper when a small part of a large set changed
+		if (m_UpdateTemplate != nullptr && isComplete && m_DirtyDescriptors * 4 >= m_TotalDescriptors)
+		{
+			vkUpdateDescriptorSetWithTemplate(device, m_DescriptorSet, m_UpdateTemplate, m_TemplateData.data());
+		}
+		else
+		{
+			std::vector<VkWriteDescriptorSet> writeSets;
+			std::vector<VkWriteDescriptorSetAccelerationStructureKHR> accelWriteSets;
+			writeSets.reserve(m_BindingData.size());
+			accelWriteSets.reserve(m_BindingData.size());
+
+			for (const BindingData& data : m_BindingData)
+			{
+				if (!data.myIsDirty)
+					continue;
+
+				VkWriteDescriptorSet writeSet = CreateWriteSet(data);
+				if (data.myType == DescriptorType::ACCEL_STRUCTURE)
+				{
+					VkWriteDescriptorSetAccelerationStructureKHR& accelWriteSet = accelWriteSets.emplace_back();
+					accelWriteSet = {};
+					accelWriteSet.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET_ACCELERATION_STRUCTURE_KHR;
+					accelWriteSet.accelerationStructureCount = data.myCount;
+					accelWriteSet.pAccelerationStructures = reinterpret_cast<const VkAccelerationStructureKHR*>(&m_TemplateData[data.myOffset]);
+
+					writeSet.pNext = &accelWriteSet;
+				}
+
+				writeSets.push_back(writeSet);
+			}
+
+			vkUpdateDescriptorSets(device, static_cast<uint32_t>(writeSets.size()), writeSets.data(), 0, nullptr);
+		}
+
+		for (BindingData& data : m_BindingData)
+			data.myIsDirty = false;
+
+		m_DirtyDescriptors = 0;
+	}
+
+	void Gfx_Descriptor::WriteDescriptorBuffer(const BindingData& data)
+	{
+		Gfx_DescriptorBuffer& descriptorBuffer = Gfx_RenderContext::GetDescriptorBuffer();
+		const size_t descriptorSize = Gfx_DescriptorBuffer::GetDescriptorSize(data.myVkType);
+
+		for (uint32_t i = 0; i < data.myCount; ++i)
+		{
+			const uint8_t* info = &m_TemplateData[data.myOffset + data.myStride * i];
+			const VkDeviceSize offset = m_BufferRegion.myOffset + data.myBufferOffset + descriptorSize * i;
+
+			switch (data.myType)
+			{
+			case DescriptorType::UNIFORM_BUFFER:
+			case DescriptorType::STORAGE_BUFFER:
+				descriptorBuffer.Write(offset, data.myVkType, nullptr, reinterpret_cast<const VkDescriptorBufferInfo*>(info));
+				break;
+			case DescriptorType::ACCEL_STRUCTURE:
+				descriptorBuffer.Write(offset, data.myVkType, nullptr, nullptr, *reinterpret_cast<const VkAccelerationStructureKHR*>(info));
+				break;
+			default:
+				descriptorBuffer.Write(offset, data.myVkType, reinterpret_cast<const VkDescriptorImageInfo*>(info), nullptr);
+				break;
+			}
+		}
+	}
+
+	void Gfx_Descriptor::CmdPush(VkCommandBuffer cmd, VkPipelineBindPoint bindPoint, VkPipelineLayout pipelineLayout, uint32_t setIndex,
+		const std::vector<DescriptorWrite>& writes)
+	{
+		GFX_ASSERT_MSG(m_IsPushDescriptor, "Gfx_Descriptor: not created with myIsPushDescriptor")
+
+		const Gfx_VulkanDevice& device = Gfx_App::GetDevice();
+
+		// Descriptor buffers write into a transient region of the current frame
+		Gfx_DescriptorBuffer& descriptorBuffer = Gfx_RenderContext::GetDescriptorBuffer();
+		if (descriptorBuffer.IsGood())
+		{
+			const DescriptorBufferRegion region = descriptorBuffer.Allocate(Gfx_DescriptorBuffer::GetLayoutSize(m_Layout), DescriptorLifetime::Frame);
+
+			for (const DescriptorWrite& write : writes)
+			{
+				BindingData* data = GetBindingData(write.myBinding, write.myType);
+				if (data == nullptr)
+					continue;
+
+				VkDescriptorBufferInfo bufferInfo{};
+				if (write.myBuffer != nullptr)
+				{
+					bufferInfo.buffer = write.myBuffer->GetRawBuffer();
+					bufferInfo.offset = write.myBuffer->GetOffset();
+					bufferInfo.range = write.myBuffer->GetSize();
+				}
+
+				VkDescriptorImageInfo imageInfo{};
+				imageInfo.sampler = write.mySampler != nullptr ? write.mySampler->GetSampler() : data->mySampler;
+				if (write.myPixelStorage != nullptr)
+				{
+					imageInfo.imageView = write.myPixelStorage->GetImageView();
+					imageInfo.imageLayout = write.myPixelStorage->GetImageLayout();
+				}
+
+				const VkDeviceSize offset = region.myOffset + data->myBufferOffset + Gfx_DescriptorBuffer::GetDescriptorSize(data->myVkType) * write.myArrayElement;
+				descriptorBuffer.Write(offset, data->myVkType, &imageInfo, &bufferInfo,
+					write.myAccelStructure != nullptr ? write.myAccelStructure->GetHandle() : nullptr);
+			}
+
+			const uint32_t bufferIndex = 0;
+			device.vkCmdSetDescriptorBufferOffsetsEXT(cmd, bindPoint, pipelineLayout, setIndex, 1, &bufferIndex, &region.myOffset);
+			return;
+		}
+
+		VkDescriptorSet dstSet = nullptr;
+		if (!m_IsPushSupported)
+		{
+			// Recycled when this frame index comes around again
+			DescriptorAllocation allocation = Gfx_RenderContext::GetDescriptorAllocator().Allocate(m_Layout, DescriptorLifetime::Frame);
+			dstSet = allocation.mySet;
+		}
+
+		// Reserved up front, write sets point into these
+		std::vector<VkDescriptorImageInfo> imageInfos;
+		std::vector<VkDescriptorBufferInfo> bufferInfos;
+		std::vector<VkAccelerationStructureKHR> accelHandles;
+		std::vector<VkWriteDescriptorSetAccelerationStructureKHR> accelWriteSets;
+		std::vector<VkWriteDescriptorSet> writeSets;
+
+		imageInfos.reserve(writes.size());
+		bufferInfos.reserve(writes.size());
+		accelHandles.reserve(writes.size());
+		accelWriteSets.reserve(writes.size());
+		writeSets.reserve(writes.size());
+
+		for (const DescriptorWrite& write : writes)
+		{
+			BindingData* data = GetBindingData(write.myBinding, write.myType);
+			if (data == nullptr)
+				continue;
+
+			VkWriteDescriptorSet writeSet = {};
+			writeSet.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			writeSet.dstSet = dstSet;
+			writeSet.dstBinding = write.myBinding;
+			writeSet.dstArrayElement = write.myArrayElement;
+			writeSet.descriptorCount = 1;
+			writeSet.descriptorType = data->myVkType;
+
+			switch (write.myType)
+			{
+			case DescriptorType::UNIFORM_BUFFER:
+			case DescriptorType::STORAGE_BUFFER:
+			{
+				GFX_ASSERT(write.myBuffer)
+
+				VkDescriptorBufferInfo& info = bufferInfos.emplace_back();
+				info.buffer = write.myBuffer->GetRawBuffer();
+				info.offset = write.myBuffer->GetOffset();
+				info.range = write.myBuffer->GetSize();
+
+				writeSet.pBufferInfo = &info;
+				break;
+			}
+			case DescriptorType::ACCEL_STRUCTURE:
+			{
+				GFX_ASSERT(write.myAccelStructure)
+
+				VkAccelerationStructureKHR& handle = accelHandles.emplace_back(write.myAccelStructure->GetHandle());
+				VkWriteDescriptorSetAccelerationStructureKHR& accelWriteSet = accelWriteSets.emplace_back();
+				accelWriteSet = {};
+				accelWriteSet.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET_ACCELERATION_STRUCTURE_KHR;
+				accelWriteSet.accelerationStructureCount = 1;
+				accelWriteSet.pAccelerationStructures = &handle;
+
+				writeSet.pNext = &accelWriteSet;
+				break;
+			}
+			default:
+			{
+				VkDescriptorImageInfo& info = imageInfos.emplace_back();
+				info.sampler = write.mySampler != nullptr ? write.mySampler->GetSampler() : data->mySampler;
+				info.imageView = write.myPixelStorage != nullptr ? write.myPixelStorage->GetImageView() : nullptr;
+				info.imageLayout = write.myPixelStorage != nullptr ? write.myPixelStorage->GetImageLayout() : VK_IMAGE_LAYOUT_UNDEFINED;
+
+				writeSet.pImageInfo = &info;
+				break;
+			}
+			}
+
+			writeSets.push_back(writeSet);
+		}
+
+		if (m_IsPushSupported)
+		{
+			device.vkCmdPushDescriptorSetKHR(cmd, bindPoint, pipelineLayout, setIndex,
+				static_cast<uint32_t>(writeSets.size()), writeSets.data());
+			return;
+		}
+
+		vkUpdateDescriptorSets(device.GetLogicalDevice(), static_cast<uint32_t>(writeSets.size()), writeSets.data(), 0, nullptr);
+		vkCmdBindDescriptorSets(cmd, bindPoint, pipelineLayout, setIndex, 1, &dstSet, 0, nullptr);
+	}
+
+	bool Gfx_Descriptor::IsDirty() const
+	{
+		return m_DirtyDescriptors > 0;
+	}
+
+	void Gfx_Descriptor::OnRelocated(const MemoryRelocations& relocations)
+	{
+		std::lock_guard<std::mutex> lock(s_DescriptorMutex);
+
+		for (Gfx_Descriptor* descriptor : s_Descriptors)
+		{
+			for (BindingData& data : descriptor->m_BindingData)
+			{
+				if (!data.myIsWritten || data.myType == DescriptorType::ACCEL_STRUCTURE)
+					continue;
+
+				bool isMoved = false;
+				for (uint32_t i = 0; i < data.myCount; ++i)
+				{
+					uint8_t* info = &descriptor->m_TemplateData[data.myOffset + data.myStride * i];
+					if (data.myType == DescriptorType::UNIFORM_BUFFER || data.myType == DescriptorType::STORAGE_BUFFER)
+					{
+						VkDescriptorBufferInfo* bufferInfo = reinterpret_cast<VkDescriptorBufferInfo*>(info);
+						const VkBuffer buffer = relocations.Find(bufferInfo->buffer);
+
+						isMoved |= buffer != bufferInfo->buffer;
+						bufferInfo->buffer = buffer;
+						continue;
+					}
+
+					VkDescriptorImageInfo* imageInfo = reinterpret_cast<VkDescriptorImageInfo*>(info);
+					const VkImageView imageView = relocations.Find(imageInfo->imageView);
+
+					isMoved |= imageView != imageInfo->imageView;
+					imageInfo->imageView = imageView;
+				}
+
+				if (isMoved)
+					descriptor->MarkDirty(&data);
+			}
+
+			descriptor->Flush();
+		}
+	}
+
+	Gfx_Descriptor::BindingData* Gfx_Descriptor::GetBindingData(uint32_t binding, DescriptorType type)
+	{
+		for (BindingData& data : m_BindingData)
+		{
+			if (data.myBinding == binding)
+			{
+				GFX_ASSERT_MSG((data.myType == type), "Gfx_Descriptor: descriptor type does not match the binding")
+				return &data;
+			}
+		}
+
+		GFX_ASSERT_MSG(false, "Gfx_Descriptor: binding not found")
+		return nullptr;
+	}
+
+	void Gfx_Descriptor::MarkDirty(BindingData* data)
+	{
+		if (!data->myIsDirty)
+			m_DirtyDescriptors += data->myCount;
+
+		data->myIsDirty = true;
+		data->myIsWritten = true;
+	}
+
+	VkWriteDescriptorSet Gfx_Descriptor::CreateWriteSet(const BindingData& data)
 	{
 		VkWriteDescriptorSet writeSet = {};
 		writeSet.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
 		writeSet.dstSet = m_DescriptorSet;
-		writeSet.descriptorType = locGetDescriptorType(desc->myType);
-		writeSet.dstBinding = desc->myBinding;
+		writeSet.descriptorType = data.myVkType;
+		writeSet.dstBinding = data.myBinding;
 		writeSet.dstArrayElement = 0;
-		writeSet.descriptorCount = 1;
-		writeSet.pBufferInfo = &info;
+		writeSet.descriptorCount = data.myCount;
+
+		switch (data.myType)
+		{
+		case DescriptorType::UNIFORM_BUFFER:
+		case DescriptorType::STORAGE_BUFFER:
+			writeSet.pBufferInfo = reinterpret_cast<const VkDescriptorBufferInfo*>(&m_TemplateData[data.myOffset]);
+			break;
+		case DescriptorType::ACCEL_STRUCTURE:
+			break;
+		default:
+			writeSet.pImageInfo = reinterpret_cast<const VkDescriptorImageInfo*>(&m_TemplateData[data.myOffset]);
+			break;
+		}
 
 		return writeSet;
 	}
-}
\ No newline at end of file
+}
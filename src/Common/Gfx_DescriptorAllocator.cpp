@@ -0,0 +1,300 @@
+#include "Gfx_Precompiled.h"
+#include "Common/Gfx_DescriptorAllocator.h"
+
+#include <string_view>
+
+namespace SmolEngine
+{
+	// Descriptors reserved per set in every generic pool
+	static const std::pair<VkDescriptorType, float> s_PoolRatios[] =
+	{
+		{ VK_DESCRIPTOR_TYPE_SAMPLER, 0.5f },
+		{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 4.0f },
+		{ VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, 4.0f },
+		{ VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1.0f },
+		{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 2.0f },
+		{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 2.0f },
+		{ VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR, 1.0f }
+	};
+
+	static const uint32_t s_InitialSetsPerPool = 64;
+	static const uint32_t s_MaxSetsPerPool = 4096;
+
+	Gfx_DescriptorAllocator::Gfx_DescriptorAllocator()
+		:
+		m_FrameIndex{0},
+		m_Generation{0} {}
+
+	void Gfx_DescriptorAllocator::Create(uint32_t framesInFlight)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		m_StaticPools.mySetsPerPool = s_InitialSetsPerPool;
+		m_StaticPools.myFlags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
+
+		m_FramePools.resize(framesInFlight);
+		for (PoolList& list : m_FramePools)
+		{
+			list.mySetsPerPool = s_InitialSetsPerPool;
+			list.myFlags = 0;
+		}
+	}
+
+	void Gfx_DescriptorAllocator::Free()
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		DestroyList(m_StaticPools);
+		for (PoolList& list : m_FramePools)
+			DestroyList(list);
+
+		m_FramePools.clear();
+
+		for (auto& [hash, entries] : m_Layouts)
+		{
+			for (LayoutEntry& entry : entries)
+			{
+				VK_DESTROY_DEVICE_HANDLE(entry.myLayout, vkDestroyDescriptorSetLayout);
+			}
+		}
+
+		for (auto& [layout, updateTemplate] : m_UpdateTemplates)
+		{
+			VK_DESTROY_DEVICE_HANDLE(updateTemplate, vkDestroyDescriptorUpdateTemplate);
+		}
+
+		m_Layouts.clear();
+		m_LayoutSizes.clear();
+		m_UpdateTemplates.clear();
+	}
+
+	VkDescriptorSetLayout Gfx_DescriptorAllocator::GetLayout(const std::vector<VkDescriptorSetLayoutBinding>& bindings, VkDescriptorSetLayoutCreateFlags flags)
+	{
+		// Every layout of a descriptor buffer pipeline must be a descriptor buffer layout
+		if (Gfx_App::GetDevice().GetDescriptorBufferSupport())
+			flags |= VK_DESCRIPTOR_SET_LAYOUT_CREATE_DESCRIPTOR_BUFFER_BIT_EXT;
+
+		std::vector<VkDescriptorSetLayoutBinding> sorted = bindings;
+		std::sort(sorted.begin(), sorted.end(), [](const VkDescriptorSetLayoutBinding& a, const VkDescriptorSetLayoutBinding& b)
+		{
+			return a.binding < b.binding;
+		});
+
+		std::vector<uint32_t> key;
+		key.reserve(2 + sorted.size() * 4);
+		key.push_back(flags);
+		key.push_back(static_cast<uint32_t>(sorted.size()));
+
+		for (const VkDescriptorSetLayoutBinding& binding : sorted)
+		{
+			key.push_back(binding.binding);
+			key.push_back(static_cast<uint32_t>(binding.descriptorType));
+			key.push_back(binding.descriptorCount);
+			key.push_back(binding.stageFlags);
+		}
+
+		const size_t hash = std::hash<std::string_view>{}(std::string_view(reinterpret_cast<const char*>(key.data()), key.size() * sizeof(uint32_t)));
+
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		std::vector<LayoutEntry>& entries = m_Layouts[hash];
+		for (const LayoutEntry& entry : entries)
+		{
+			if (entry.myKey == key)
+				return entry.myLayout;
+		}
+
+		LayoutEntry entry{};
+		entry.myKey = std::move(key);
+
+		VkDescriptorSetLayoutCreateInfo layoutCI{};
+		{
+			layoutCI.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+			layoutCI.flags = flags;
+			layoutCI.bindingCount = static_cast<uint32_t>(sorted.size());
+			layoutCI.pBindings = sorted.data();
+
+			VK_CHECK_RESULT(vkCreateDescriptorSetLayout(Gfx_App::GetDevice().GetLogicalDevice(), &layoutCI, nullptr, &entry.myLayout));
+		}
+
+		std::map<VkDescriptorType, uint32_t> sizes;
+		for (const VkDescriptorSetLayoutBinding& binding : sorted)
+			sizes[binding.descriptorType] += binding.descriptorCount;
+
+		for (auto& [type, count] : sizes)
+			entry.mySizes.push_back({ type, count });
+
+		m_LayoutSizes[entry.myLayout] = entry.mySizes;
+		entries.emplace_back(entry);
+		return entry.myLayout;
+	}
+
+	VkDescriptorUpdateTemplate Gfx_DescriptorAllocator::GetUpdateTemplate(VkDescriptorSetLayout layout, const std::vector<VkDescriptorUpdateTemplateEntry>& entries)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		VkDescriptorUpdateTemplate& updateTemplate = m_UpdateTemplates[layout];
+		if (updateTemplate == nullptr)
+		{
+			VkDescriptorUpdateTemplateCreateInfo templateCI{};
+			templateCI.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_UPDATE_TEMPLATE_CREATE_INFO;
+			templateCI.templateType = VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_DESCRIPTOR_SET;
+			templateCI.descriptorSetLayout = layout;
+			templateCI.descriptorUpdateEntryCount = static_cast<uint32_t>(entries.size());
+			templateCI.pDescriptorUpdateEntries = entries.data();
+
+			VK_CHECK_RESULT(vkCreateDescriptorUpdateTemplate(Gfx_App::GetDevice().GetLogicalDevice(), &templateCI, nullptr, &updateTemplate));
+		}
+
+		return updateTemplate;
+	}
+
+	DescriptorAllocation Gfx_DescriptorAllocator::Allocate(VkDescriptorSetLayout layout, DescriptorLifetime lifetime)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		PoolList& list = lifetime == DescriptorLifetime::Static ? m_StaticPools : m_FramePools[m_FrameIndex];
+
+		DescriptorAllocation allocation = AllocateFromList(list, layout);
+		allocation.myLifetime = lifetime;
+		allocation.myGeneration = m_Generation;
+		return allocation;
+	}
+
+	void Gfx_DescriptorAllocator::Release(DescriptorAllocation& allocation)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		// Frame sets are recycled in bulk, sets from before ResetAll are already gone
+		if (allocation.mySet != nullptr && allocation.myLifetime == DescriptorLifetime::Static && allocation.myGeneration == m_Generation)
+		{
+			vkFreeDescriptorSets(Gfx_App::GetDevice().GetLogicalDevice(), allocation.myPool, 1, &allocation.mySet);
+		}
+
+		allocation = {};
+	}
+
+	void Gfx_DescriptorAllocator::BeginFrame(uint32_t frameIndex)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		GFX_ASSERT(frameIndex < m_FramePools.size())
+
+		m_FrameIndex = frameIndex;
+		ResetList(m_FramePools[frameIndex]);
+	}
+
+	void Gfx_DescriptorAllocator::ResetAll()
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		ResetList(m_StaticPools);
+		for (PoolList& list : m_FramePools)
+			ResetList(list);
+
+		m_Generation++;
+	}
+
+	VkDescriptorPool Gfx_DescriptorAllocator::CreatePool(uint32_t maxSets, VkDescriptorPoolCreateFlags flags, const std::vector<VkDescriptorPoolSize>& extraSizes)
+	{
+		const bool raytracing = Gfx_App::GetDevice().GetRaytracingSupport();
+
+		std::vector<VkDescriptorPoolSize> poolSizes;
+		for (const auto& [type, ratio] : s_PoolRatios)
+		{
+			if (type == VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR && !raytracing)
+				continue;
+
+			uint32_t count = static_cast<uint32_t>(ratio * maxSets);
+			// Guarantees that at least one set of an oversized layout fits
+			for (const VkDescriptorPoolSize& extra : extraSizes)
+			{
+				if (extra.type == type)
+					count += extra.descriptorCount;
+			}
+
+			poolSizes.push_back({ type, count });
+		}
+
+		VkDescriptorPool pool = nullptr;
+		VkDescriptorPoolCreateInfo descriptorPoolCI{};
+		{
+			descriptorPoolCI.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+			descriptorPoolCI.flags = flags;
+			descriptorPoolCI.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+			descriptorPoolCI.pPoolSizes = poolSizes.data();
+			descriptorPoolCI.maxSets = maxSets;
+
+			VK_CHECK_RESULT(vkCreateDescriptorPool(Gfx_App::GetDevice().GetLogicalDevice(), &descriptorPoolCI, nullptr, &pool));
+		}
+
+		return pool;
+	}
+
+	bool Gfx_DescriptorAllocator::TryAllocate(VkDescriptorPool pool, VkDescriptorSetLayout layout, VkDescriptorSet& outSet)
+	{
+		VkDescriptorSetAllocateInfo allocateCI{};
+		allocateCI.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		allocateCI.descriptorPool = pool;
+		allocateCI.descriptorSetCount = 1;
+		allocateCI.pSetLayouts = &layout;
+
+		VkResult result = vkAllocateDescriptorSets(Gfx_App::GetDevice().GetLogicalDevice(), &allocateCI, &outSet);
+		if (result == VK_ERROR_OUT_OF_POOL_MEMORY || result == VK_ERROR_FRAGMENTED_POOL)
+			return false;
+
+		VK_CHECK_RESULT(result);
+		return result == VK_SUCCESS;
+	}
+
+	DescriptorAllocation Gfx_DescriptorAllocator::AllocateFromList(PoolList& list, VkDescriptorSetLayout layout)
+	{
+		DescriptorAllocation allocation{};
+
+		// Walks every existing pool starting from the current one, static pools may have free space again
+		const uint32_t poolCount = static_cast<uint32_t>(list.myPools.size());
+		for (uint32_t i = 0; i < poolCount; ++i)
+		{
+			const uint32_t index = (list.myCurrent + i) % poolCount;
+			if (TryAllocate(list.myPools[index], layout, allocation.mySet))
+			{
+				list.myCurrent = index;
+				allocation.myPool = list.myPools[index];
+				return allocation;
+			}
+		}
+
+		if (poolCount > 0)
+			list.mySetsPerPool = std::min(list.mySetsPerPool * 2, s_MaxSetsPerPool);
+
+		VkDescriptorPool pool = CreatePool(list.mySetsPerPool, list.myFlags, m_LayoutSizes[layout]);
+		list.myPools.push_back(pool);
+		list.myCurrent = poolCount;
+
+		bool allocated = TryAllocate(pool, layout, allocation.mySet);
+		GFX_ASSERT_MSG(allocated, "Gfx_DescriptorAllocator: failed to allocate descriptor set from a new pool")
+
+		allocation.myPool = pool;
+		return allocation;
+	}
+
+	void Gfx_DescriptorAllocator::ResetList(PoolList& list)
+	{
+		VkDevice device = Gfx_App::GetDevice().GetLogicalDevice();
+		for (VkDescriptorPool pool : list.myPools)
+			vkResetDescriptorPool(device, pool, 0);
+
+		list.myCurrent = 0;
+	}
+
+	void Gfx_DescriptorAllocator::DestroyList(PoolList& list)
+	{
+		for (VkDescriptorPool& pool : list.myPools)
+		{
+			VK_DESTROY_DEVICE_HANDLE(pool, vkDestroyDescriptorPool);
+		}
+
+		list.myPools.clear();
+		list.myCurrent = 0;
+	}
+}
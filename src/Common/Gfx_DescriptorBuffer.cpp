@@ -0,0 +1,285 @@
+#include "Gfx_Precompiled.h"
+#include "Common/Gfx_DescriptorBuffer.h"
+
+#include "Backend/Gfx_VulkanHelpers.h"
+
+namespace SmolEngine
+{
+	static const VkDeviceSize s_DescriptorBufferStaticSize = 16 * 1024 * 1024;
+	static const VkDeviceSize s_DescriptorBufferFrameSize = 1024 * 1024;
+
+	static VkDeviceSize locAlignUp(VkDeviceSize value, VkDeviceSize alignment)
+	{
+		return (value + alignment - 1) / alignment * alignment;
+	}
+
+	Gfx_DescriptorBuffer::Gfx_DescriptorBuffer()
+		:
+		m_Mapped{nullptr},
+		m_Alignment{1},
+		m_StaticSize{0},
+		m_FrameSize{0},
+		m_FrameUsed{0},
+		m_FrameIndex{0},
+		m_FrameCount{0} {}
+
+	void Gfx_DescriptorBuffer::Create(uint32_t framesInFlight)
+	{
+		const Gfx_VulkanDevice& device = Gfx_App::GetDevice();
+		if (!device.GetDescriptorBufferSupport())
+			return;
+
+		const VkPhysicalDeviceDescriptorBufferPropertiesEXT& props = device.descriptorBufferProperties;
+		m_Alignment = std::max<VkDeviceSize>(props.descriptorBufferOffsetAlignment, 1);
+
+		// Sampler and resource descriptors share one buffer, so both ranges limit its size
+		const VkDeviceSize maxRange = std::min(props.maxResourceDescriptorBufferRange, props.maxSamplerDescriptorBufferRange);
+		const VkDeviceSize desiredSize = s_DescriptorBufferStaticSize + s_DescriptorBufferFrameSize * framesInFlight;
+		const double scale = std::min(1.0, static_cast<double>(maxRange) / static_cast<double>(desiredSize));
+
+		// Rounded down so that every region starts aligned
+		m_FrameSize = static_cast<VkDeviceSize>(s_DescriptorBufferFrameSize * scale) / m_Alignment * m_Alignment;
+		m_StaticSize = static_cast<VkDeviceSize>(s_DescriptorBufferStaticSize * scale) / m_Alignment * m_Alignment;
+
+		BufferCreateDesc bufferDesc{};
+		bufferDesc.mySize = m_StaticSize + m_FrameSize * framesInFlight;
+		bufferDesc.myMemUsage = VMA_MEMORY_USAGE_CPU_TO_GPU;
+		bufferDesc.myBufferUsage = VK_BUFFER_USAGE_RESOURCE_DESCRIPTOR_BUFFER_BIT_EXT | VK_BUFFER_USAGE_SAMPLER_DESCRIPTOR_BUFFER_BIT_EXT |
+			VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT;
+
+		m_Buffer.Create(bufferDesc);
+		m_Mapped = static_cast<uint8_t*>(m_Buffer.MapMemory());
+
+		m_FreeRanges.push_back({ 0, m_StaticSize });
+	}
+
+	void Gfx_DescriptorBuffer::Free()
+	{
+		m_Buffer.UnMapMemory();
+		m_Buffer.Free();
+
+		m_Mapped = nullptr;
+		m_FreeRanges.clear();
+		m_Retired.clear();
+	}
+
+	bool Gfx_DescriptorBuffer::IsGood() const
+	{
+		return m_Mapped != nullptr;
+	}
+
+	void Gfx_DescriptorBuffer::BeginFrame(uint32_t frameIndex)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		m_FrameIndex = frameIndex;
+		m_FrameUsed = 0;
+		m_FrameCount++;
+
+		const uint64_t framesInFlight = Gfx_App::GetFramesInFlight();
+		std::erase_if(m_Retired, [&](const RetiredRegion& retired)
+		{
+			if (m_FrameCount - retired.myFrame <= framesInFlight)
+				return false;
+
+			AddFreeRange(retired.myRegion.myOffset, retired.myRegion.mySize);
+			return true;
+		});
+	}
+
+	DescriptorBufferRegion Gfx_DescriptorBuffer::Allocate(VkDeviceSize size, DescriptorLifetime lifetime)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		DescriptorBufferRegion region{};
+		region.mySize = locAlignUp(std::max<VkDeviceSize>(size, 1), m_Alignment);
+		region.myLifetime = lifetime;
+
+		if (lifetime == DescriptorLifetime::Frame)
+		{
+			GFX_ASSERT_MSG((m_FrameUsed + region.mySize <= m_FrameSize), "Gfx_DescriptorBuffer: frame region is full")
+
+			region.myOffset = m_StaticSize + m_FrameSize * m_FrameIndex + m_FrameUsed;
+			m_FrameUsed += region.mySize;
+			return region;
+		}
+
+		// First fit
+		for (size_t i = 0; i < m_FreeRanges.size(); ++i)
+		{
+			DescriptorBufferRegion& range = m_FreeRanges[i];
+			if (range.mySize < region.mySize)
+				continue;
+
+			region.myOffset = range.myOffset;
+			range.myOffset += region.mySize;
+			range.mySize -= region.mySize;
+
+			if (range.mySize == 0)
+				m_FreeRanges.erase(m_FreeRanges.begin() + i);
+
+			return region;
+		}
+
+		GFX_ASSERT_MSG(false, "Gfx_DescriptorBuffer: out of descriptor memory")
+		return {};
+	}
+
+	void Gfx_DescriptorBuffer::Release(DescriptorBufferRegion& region)
+	{
+		if (region.mySize > 0 && region.myLifetime == DescriptorLifetime::Static)
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_Retired.push_back({ region, m_FrameCount });
+		}
+
+		region = {};
+	}
+
+	void Gfx_DescriptorBuffer::Write(VkDeviceSize offset, VkDescriptorType type, const VkDescriptorImageInfo* imageInfo,
+		const VkDescriptorBufferInfo* bufferInfo, VkAccelerationStructureKHR accelStructure)
+	{
+		const Gfx_VulkanDevice& device = Gfx_App::GetDevice();
+
+		VkDescriptorGetInfoEXT getInfo{};
+		getInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_GET_INFO_EXT;
+		getInfo.type = type;
+
+		VkDescriptorAddressInfoEXT addressInfo{};
+		addressInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_ADDRESS_INFO_EXT;
+
+		switch (type)
+		{
+		case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
+		case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER:
+		{
+			if (bufferInfo == nullptr || bufferInfo->buffer == nullptr)
+				return;
+
+			addressInfo.address = Gfx_VulkanHelpers::GetBufferDeviceAddress(bufferInfo->buffer) + bufferInfo->offset;
+			addressInfo.range = bufferInfo->range;
+
+			if (type == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER)
+				getInfo.data.pUniformBuffer = &addressInfo;
+			else
+				getInfo.data.pStorageBuffer = &addressInfo;
+
+			break;
+		}
+		case VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR:
+		{
+			if (accelStructure == nullptr)
+				return;
+
+			VkAccelerationStructureDeviceAddressInfoKHR accelAddressInfo{};
+			accelAddressInfo.sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_DEVICE_ADDRESS_INFO_KHR;
+			accelAddressInfo.accelerationStructure = accelStructure;
+
+			getInfo.data.accelerationStructure = device.vkGetAccelerationStructureDeviceAddressKHR(device.GetLogicalDevice(), &accelAddressInfo);
+			break;
+		}
+		case VK_DESCRIPTOR_TYPE_SAMPLER:
+		{
+			if (imageInfo == nullptr || imageInfo->sampler == nullptr)
+				return;
+
+			getInfo.data.pSampler = &imageInfo->sampler;
+			break;
+		}
+		default:
+		{
+			// Unwritten elements are left as is, partially bound like regular sets
+			if (imageInfo == nullptr || imageInfo->imageView == nullptr)
+				return;
+
+			if (type == VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE)
+				getInfo.data.pSampledImage = imageInfo;
+			else if (type == VK_DESCRIPTOR_TYPE_STORAGE_IMAGE)
+				getInfo.data.pStorageImage = imageInfo;
+			else
+				getInfo.data.pCombinedImageSampler = imageInfo;
+
+			break;
+		}
+		}
+
+		device.vkGetDescriptorEXT(device.GetLogicalDevice(), &getInfo, GetDescriptorSize(type), m_Mapped + offset);
+	}
+
+	void Gfx_DescriptorBuffer::CmdBind(VkCommandBuffer cmd) const
+	{
+		VkDescriptorBufferBindingInfoEXT bindingInfo{};
+		bindingInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_BUFFER_BINDING_INFO_EXT;
+		bindingInfo.address = m_Buffer.GetDeviceAddress();
+		bindingInfo.usage = VK_BUFFER_USAGE_RESOURCE_DESCRIPTOR_BUFFER_BIT_EXT | VK_BUFFER_USAGE_SAMPLER_DESCRIPTOR_BUFFER_BIT_EXT;
+
+		Gfx_App::GetDevice().vkCmdBindDescriptorBuffersEXT(cmd, 1, &bindingInfo);
+	}
+
+	size_t Gfx_DescriptorBuffer::GetDescriptorSize(VkDescriptorType type)
+	{
+		const VkPhysicalDeviceDescriptorBufferPropertiesEXT& props = Gfx_App::GetDevice().descriptorBufferProperties;
+
+		switch (type)
+		{
+		case VK_DESCRIPTOR_TYPE_SAMPLER:
+			return props.samplerDescriptorSize;
+		case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE:
+			return props.sampledImageDescriptorSize;
+		case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
+			return props.storageImageDescriptorSize;
+		case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
+			return props.uniformBufferDescriptorSize;
+		case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER:
+			return props.storageBufferDescriptorSize;
+		case VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR:
+			return props.accelerationStructureDescriptorSize;
+		case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
+			return props.combinedImageSamplerDescriptorSize;
+		default:
+			GFX_ASSERT_MSG(false, "Gfx_DescriptorBuffer: descriptor type has no size in descriptor buffers")
+			return 0;
+		}
+	}
+
+	VkDeviceSize Gfx_DescriptorBuffer::GetLayoutSize(VkDescriptorSetLayout layout)
+	{
+		const Gfx_VulkanDevice& device = Gfx_App::GetDevice();
+
+		VkDeviceSize size = 0;
+		device.vkGetDescriptorSetLayoutSizeEXT(device.GetLogicalDevice(), layout, &size);
+		return size;
+	}
+
+	VkDeviceSize Gfx_DescriptorBuffer::GetBindingOffset(VkDescriptorSetLayout layout, uint32_t binding)
+	{
+		const Gfx_VulkanDevice& device = Gfx_App::GetDevice();
+
+		VkDeviceSize offset = 0;
+		device.vkGetDescriptorSetLayoutBindingOffsetEXT(device.GetLogicalDevice(), layout, binding, &offset);
+		return offset;
+	}
+
+	void Gfx_DescriptorBuffer::AddFreeRange(VkDeviceSize offset, VkDeviceSize size)
+	{
+		auto it = std::lower_bound(m_FreeRanges.begin(), m_FreeRanges.end(), offset, [](const DescriptorBufferRegion& range, VkDeviceSize value)
+		{
+			return range.myOffset < value;
+		});
+
+		it = m_FreeRanges.insert(it, { offset, size });
+
+		// Merge with the next and the previous range
+		if (it + 1 != m_FreeRanges.end() && it->myOffset + it->mySize == (it + 1)->myOffset)
+		{
+			it->mySize += (it + 1)->mySize;
+			m_FreeRanges.erase(it + 1);
+		}
+
+		if (it != m_FreeRanges.begin() && (it - 1)->myOffset + (it - 1)->mySize == it->myOffset)
+		{
+			(it - 1)->mySize += it->mySize;
+			m_FreeRanges.erase(it);
+		}
+	}
+}
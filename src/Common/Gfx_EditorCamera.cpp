@@ -179,6 +179,19 @@ namespace SmolEngine
 		UpdateCameraView();
 	}
 
+	void Gfx_EditorCamera::SetPose(const glm::vec3& position, float pitch, float yaw)
+	{
+		m_Position = position;
+		m_Pitch = pitch;
+		m_Yaw = yaw;
+
+		m_PitchDelta = 0.0f;
+		m_YawDelta = 0.0f;
+		m_PositionDelta = glm::vec3(0.0f);
+
+		UpdateCameraView();
+	}
+
 	std::pair<float, float> Gfx_EditorCamera::PanSpeed() const
 	{
 		const float x = std::min(float(m_ViewportWidth) / 1000.0f, 24.0f); // max = 2.4f
@@ -31,6 +31,8 @@ namespace SmolEngine
 		GFX_ASSERT(m_Desc.myAttachments.size() > 0)
 		GFX_ASSERT(m_Desc.mySize.x > 0 && m_Desc.mySize.y > 0)
 
+		GFX_ASSERT_MSG((!info->myIsTargetsSwapchain || !Gfx_App::IsHeadless()), "Gfx_Framebuffer: there is no swapchain in headless mode")
+
 		if (info->mySampler == nullptr)
 			info->mySampler = Gfx_RenderContext::GetDefaultSampler();
 
@@ -54,8 +56,9 @@ namespace SmolEngine
 
 			const bool isDepthAttachement = Gfx_VulkanHelpers::IsDepthFormat(attachmentDesc.myFormat);
 
-			VkImageUsageFlags usageFlags = isDepthAttachement ? VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT :
-				VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+			// Transfer source so attachments can be read back
+			VkImageUsageFlags usageFlags = isDepthAttachement ? VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT :
+				VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
 			VkImageAspectFlags aspectFlags = VK_IMAGE_ASPECT_COLOR_BIT;
 
 			if (isDepthAttachement)
@@ -82,6 +85,7 @@ namespace SmolEngine
 			pixelStorageDesc.mySize = info->mySize;
 			pixelStorageDesc.myFormat = attachmentDesc.myFormat;
 			pixelStorageDesc.myMipLevels = attachmentDesc.myMips;
+			pixelStorageDesc.myPool = MemoryPool::Dedicated;
 
 			attachment.myPixelStorage = Gfx_RenderContext::CreatePixelStorage(pixelStorageDesc);
 
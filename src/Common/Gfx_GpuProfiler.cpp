@@ -0,0 +1,314 @@
+#include "Gfx_Precompiled.h"
+#include "Common/Gfx_GpuProfiler.h"
+#include "Common/Gfx_CmdBuffer.h"
+
+#include "Gfx_RenderContext.h"
+
+#include <imgui/imgui.h>
+#include <implot/implot.h>
+
+namespace SmolEngine
+{
+	// Two timestamps per scope
+	static const uint32_t s_GpuProfilerMaxQueries = 512;
+	static const uint32_t s_GpuProfilerHistory = 256;
+
+	Gfx_GpuProfiler::Gfx_GpuProfiler()
+		:
+		m_FrameCmd{nullptr},
+		m_TimestampPeriod{0.0f},
+		m_TimestampMask{UINT64_MAX},
+		m_FrameIndex{0},
+		m_FrameCount{0} {}
+
+	void Gfx_GpuProfiler::Create(uint32_t framesInFlight)
+	{
+		const Gfx_VulkanDevice& device = Gfx_App::GetDevice();
+		const VkPhysicalDeviceLimits& limits = device.GetDeviceProperties()->limits;
+		const uint32_t validBits = device.GetQueueFamilyProperties()[device.GetQueueFamilyIndices().Graphics].timestampValidBits;
+		if (limits.timestampComputeAndGraphics != VK_TRUE || validBits == 0)
+		{
+			GFX_LOG("Gfx_GpuProfiler: timestamps are not supported on this device", Gfx_Log::Level::Warning)
+			return;
+		}
+
+		// Counters with fewer valid bits wrap, deltas are taken modulo the mask
+		m_TimestampPeriod = limits.timestampPeriod;
+		m_TimestampMask = validBits >= 64 ? UINT64_MAX : (1ull << validBits) - 1;
+		m_Slots.resize(framesInFlight);
+
+		for (FrameSlot& slot : m_Slots)
+		{
+			VkQueryPoolCreateInfo poolInfo{};
+			poolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+			poolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+			poolInfo.queryCount = s_GpuProfilerMaxQueries;
+
+			VK_CHECK_RESULT(vkCreateQueryPool(Gfx_App::GetDevice().GetLogicalDevice(), &poolInfo, nullptr, &slot.myPool));
+		}
+	}
+
+	void Gfx_GpuProfiler::Free()
+	{
+		for (FrameSlot& slot : m_Slots)
+		{
+			VK_DESTROY_DEVICE_HANDLE(slot.myPool, vkDestroyQueryPool);
+		}
+
+		m_Slots.clear();
+		m_OpenScopes.clear();
+		m_Histories.clear();
+	}
+
+	void Gfx_GpuProfiler::BeginFrame(uint32_t frameIndex)
+	{
+		m_FrameIndex = frameIndex;
+		m_FrameCount++;
+		m_FrameCmd = nullptr;
+
+		if (!IsGood())
+			return;
+
+		GFX_ASSERT_MSG((frameIndex < m_Slots.size()), "Gfx_GpuProfiler: frame index must come from the ring sized by Create")
+
+		FrameSlot& slot = m_Slots[frameIndex];
+		if (slot.myIsRecorded)
+			Resolve(slot);
+
+		slot.myScopes.clear();
+		slot.myQueryCount = 0;
+		slot.myFrame = m_FrameCount;
+		slot.myIsRecorded = false;
+	}
+
+	void Gfx_GpuProfiler::CmdReset(Gfx_CmdBuffer* cmd)
+	{
+		m_OpenScopes.clear();
+		if (!IsGood())
+			return;
+
+		FrameSlot& slot = m_Slots[m_FrameIndex];
+		vkCmdResetQueryPool(cmd->GetBuffer(), slot.myPool, 0, s_GpuProfilerMaxQueries);
+
+		m_FrameCmd = cmd->GetBuffer();
+		slot.myIsRecorded = true;
+	}
+
+	void Gfx_GpuProfiler::CmdBeginScope(Gfx_CmdBuffer* cmd, const std::string& name)
+	{
+		OpenScope& open = m_OpenScopes.emplace_back();
+		open.myResult = UINT32_MAX;
+
+		FrameSlot* slot = IsGood() ? &m_Slots[m_FrameIndex] : nullptr;
+		if (slot == nullptr || cmd->GetBuffer() != m_FrameCmd || slot->myQueryCount + 2 > s_GpuProfilerMaxQueries)
+			return;
+
+		ScopeRecord& record = slot->myScopes.emplace_back();
+		record.myName = name;
+		record.myDepth = static_cast<uint32_t>(m_OpenScopes.size() - 1);
+		record.myBeginQuery = slot->myQueryCount++;
+		record.myEndQuery = UINT32_MAX;
+
+		open.myResult = static_cast<uint32_t>(slot->myScopes.size() - 1);
+		vkCmdWriteTimestamp(m_FrameCmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, slot->myPool, record.myBeginQuery);
+	}
+
+	void Gfx_GpuProfiler::CmdEndScope(Gfx_CmdBuffer* cmd)
+	{
+		GFX_ASSERT_MSG(!m_OpenScopes.empty(), "Gfx_GpuProfiler: EndScope without BeginScope")
+
+		const OpenScope open = m_OpenScopes.back();
+		m_OpenScopes.pop_back();
+
+		if (open.myResult == UINT32_MAX || cmd->GetBuffer() != m_FrameCmd)
+			return;
+
+		FrameSlot& slot = m_Slots[m_FrameIndex];
+		ScopeRecord& record = slot.myScopes[open.myResult];
+		record.myEndQuery = slot.myQueryCount++;
+
+		vkCmdWriteTimestamp(m_FrameCmd, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, slot.myPool, record.myEndQuery);
+	}
+
+	void Gfx_GpuProfiler::DrawTimeline()
+	{
+		if (ImGui::GetCurrentContext() == nullptr || ImPlot::GetCurrentContext() == nullptr)
+			return;
+
+		if (ImGui::Begin("GPU Profiler"))
+		{
+			const GpuScopeStats frameStats = GetFrameStats();
+			ImGui::Text("Frame: %.3f ms (avg %.3f, min %.3f, max %.3f)", frameStats.myLast, frameStats.myAverage, frameStats.myMin, frameStats.myMax);
+
+			auto plot = [](const char* name, const History& history)
+			{
+				const uint32_t count = std::min(history.myCount, s_GpuProfilerHistory);
+				const uint32_t offset = history.myCount > s_GpuProfilerHistory ? history.myCount % s_GpuProfilerHistory : 0;
+				ImPlot::PlotLine(name, history.myTimes.data(), static_cast<int>(count), 1.0, 0.0, 0, static_cast<int>(offset));
+			};
+
+			if (ImPlot::BeginPlot("##GpuTimeline", ImVec2(-1, 220)))
+			{
+				ImPlot::SetupAxes("frame", "ms", ImPlotAxisFlags_AutoFit, ImPlotAxisFlags_AutoFit);
+
+				plot("frame", m_FrameHistory);
+				for (const auto& [name, history] : m_Histories)
+					plot(name.c_str(), history);
+
+				ImPlot::EndPlot();
+			}
+
+			for (const GpuScopeResult& scope : m_LastFrame.myScopes)
+			{
+				GpuScopeStats stats{};
+				GetStats(scope.myName, stats);
+
+				ImGui::Text("%*s%s: %.3f ms (avg %.3f, max %.3f)", static_cast<int>(scope.myDepth * 2), "", scope.myName.c_str(),
+					scope.myTime, stats.myAverage, stats.myMax);
+			}
+		}
+
+		ImGui::End();
+	}
+
+	bool Gfx_GpuProfiler::IsGood() const
+	{
+		return !m_Slots.empty();
+	}
+
+	bool Gfx_GpuProfiler::GetStats(const std::string& name, GpuScopeStats& outStats) const
+	{
+		const auto& it = m_Histories.find(name);
+		if (it == m_Histories.end())
+			return false;
+
+		outStats = GetStats(it->second);
+		return true;
+	}
+
+	GpuScopeStats Gfx_GpuProfiler::GetFrameStats() const
+	{
+		return GetStats(m_FrameHistory);
+	}
+
+	const GpuFrameResult& Gfx_GpuProfiler::GetLastFrame() const
+	{
+		return m_LastFrame;
+	}
+
+	uint64_t Gfx_GpuProfiler::GetFrameCount() const
+	{
+		return m_FrameCount;
+	}
+
+	void Gfx_GpuProfiler::Resolve(FrameSlot& slot)
+	{
+		m_LastFrame.myScopes.clear();
+		m_LastFrame.myFrame = slot.myFrame;
+		m_LastFrame.myTime = 0.0f;
+
+		if (slot.myQueryCount == 0)
+			return;
+
+		// Value and availability per query, a scope still in flight or left open is skipped instead of waited on
+		std::vector<uint64_t> results(slot.myQueryCount * 2);
+		const VkResult result = vkGetQueryPoolResults(Gfx_App::GetDevice().GetLogicalDevice(), slot.myPool, 0, slot.myQueryCount,
+			results.size() * sizeof(uint64_t), results.data(), sizeof(uint64_t) * 2, VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+
+		if (result != VK_SUCCESS && result != VK_NOT_READY)
+			return;
+
+		// Ticks are measured from the first resolved timestamp so that the frame span survives a counter wrap
+		bool hasOrigin = false;
+		uint64_t origin = 0;
+		uint64_t frameBegin = UINT64_MAX;
+		uint64_t frameEnd = 0;
+		for (const ScopeRecord& record : slot.myScopes)
+		{
+			if (record.myEndQuery == UINT32_MAX)
+				continue;
+
+			const uint64_t* begin = &results[record.myBeginQuery * 2];
+			const uint64_t* end = &results[record.myEndQuery * 2];
+			if (begin[1] == 0 || end[1] == 0)
+				continue;
+
+			const uint64_t beginTicks = begin[0] & m_TimestampMask;
+			const uint64_t endTicks = end[0] & m_TimestampMask;
+			if (!hasOrigin)
+			{
+				origin = beginTicks;
+				hasOrigin = true;
+			}
+
+			GpuScopeResult& scope = m_LastFrame.myScopes.emplace_back();
+			scope.myName = record.myName;
+			scope.myDepth = record.myDepth;
+			scope.myTime = static_cast<float>(static_cast<double>((endTicks - beginTicks) & m_TimestampMask) * m_TimestampPeriod / 1e6);
+
+			Push(m_Histories[record.myName], scope.myTime, slot.myFrame);
+
+			frameBegin = std::min(frameBegin, (beginTicks - origin) & m_TimestampMask);
+			frameEnd = std::max(frameEnd, (endTicks - origin) & m_TimestampMask);
+		}
+
+		if (m_LastFrame.myScopes.empty())
+			return;
+
+		m_LastFrame.myTime = static_cast<float>(static_cast<double>(frameEnd - frameBegin) * m_TimestampPeriod / 1e6);
+		Push(m_FrameHistory, m_LastFrame.myTime, slot.myFrame);
+	}
+
+	void Gfx_GpuProfiler::Push(History& history, float time, uint64_t frame)
+	{
+		// A scope used more than once per frame is summed
+		if (history.myCount > 0 && history.myLastFrame == frame)
+		{
+			history.myTimes[(history.myCount - 1) % s_GpuProfilerHistory] += time;
+			return;
+		}
+
+		if (history.myTimes.empty())
+			history.myTimes.resize(s_GpuProfilerHistory);
+
+		history.myTimes[history.myCount % s_GpuProfilerHistory] = time;
+		history.myCount++;
+		history.myLastFrame = frame;
+	}
+
+	GpuScopeStats Gfx_GpuProfiler::GetStats(const History& history)
+	{
+		GpuScopeStats stats{};
+		const uint32_t count = std::min(history.myCount, s_GpuProfilerHistory);
+		if (count == 0)
+			return stats;
+
+		stats.myLast = history.myTimes[(history.myCount - 1) % s_GpuProfilerHistory];
+		stats.myMin = FLT_MAX;
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			const float time = history.myTimes[i];
+			stats.myAverage += time;
+			stats.myMin = std::min(stats.myMin, time);
+			stats.myMax = std::max(stats.myMax, time);
+		}
+
+		stats.myAverage /= count;
+		return stats;
+	}
+
+	Gfx_GpuScope::Gfx_GpuScope(Gfx_CmdBuffer* cmd, const std::string& name)
+		:
+		m_Cmd{cmd},
+		m_IsOpen{!name.empty()}
+	{
+		if (m_IsOpen)
+			Gfx_RenderContext::GetGpuProfiler().CmdBeginScope(m_Cmd, name);
+	}
+
+	Gfx_GpuScope::~Gfx_GpuScope()
+	{
+		if (m_IsOpen)
+			Gfx_RenderContext::GetGpuProfiler().CmdEndScope(m_Cmd);
+	}
+}
@@ -28,6 +28,10 @@ namespace SmolEngine
 			return sizeof(uint8_t) * 4;
 		case Format::B8G8R8A8_UNORM:
 			return sizeof(uint8_t) * 4;
+		case Format::R8G8B8A8_SRGB:
+			return sizeof(uint8_t) * 4;
+		case Format::B8G8R8A8_SRGB:
+			return sizeof(uint8_t) * 4;
 		case Format::D16_UNORM:
 			return sizeof(uint16_t);
 		case Format::D16_UNORM_S8_UINT:
@@ -94,11 +98,63 @@ namespace SmolEngine
 			return sizeof(uint32_t) * 2;
 		case Format::R32G32B32A32_SINT:
 			return sizeof(uint32_t) * 4;;
+		case Format::BC1_RGBA_UNORM:
+		case Format::BC1_RGBA_SRGB:
+		case Format::BC4_UNORM:
+		case Format::BC4_SNORM:
+			return 8;
+		case Format::BC2_UNORM:
+		case Format::BC2_SRGB:
+		case Format::BC3_UNORM:
+		case Format::BC3_SRGB:
+		case Format::BC5_UNORM:
+		case Format::BC5_SNORM:
+		case Format::BC6H_UFLOAT:
+		case Format::BC6H_SFLOAT:
+		case Format::BC7_UNORM:
+		case Format::BC7_SRGB:
+		case Format::ASTC_4x4_UNORM:
+		case Format::ASTC_4x4_SRGB:
+		case Format::ASTC_6x6_UNORM:
+		case Format::ASTC_6x6_SRGB:
+		case Format::ASTC_8x8_UNORM:
+		case Format::ASTC_8x8_SRGB:
+			return 16;
 		default:
 			return 0;
 		}
 	}
 
+	uint32_t Gfx_Helpers::GetFormatBlockExtent(Format format)
+	{
+		switch (format)
+		{
+		case Format::ASTC_6x6_UNORM:
+		case Format::ASTC_6x6_SRGB:
+			return 6;
+		case Format::ASTC_8x8_UNORM:
+		case Format::ASTC_8x8_SRGB:
+			return 8;
+		default:
+			return IsCompressedFormat(format) ? 4 : 1;
+		}
+	}
+
+	bool Gfx_Helpers::IsCompressedFormat(Format format)
+	{
+		return format >= Format::BC1_RGBA_UNORM && format <= Format::ASTC_8x8_SRGB;
+	}
+
+	size_t Gfx_Helpers::GetImageSize(Format format, const glm::uvec2& size)
+	{
+		// Partial blocks at the edges still take a whole block
+		const uint32_t blockExtent = GetFormatBlockExtent(format);
+		const size_t blocksX = (size.x + blockExtent - 1) / blockExtent;
+		const size_t blocksY = (size.y + blockExtent - 1) / blockExtent;
+
+		return blocksX * blocksY * GetFormatSize(format);
+	}
+
 	bool Gfx_Helpers::DecomposeTransform(const glm::mat4& transform, glm::vec3& translation, glm::vec3& rotation, glm::vec3& scale)
 	{
 		// From glm::decompose in matrix_decompose.inl
@@ -295,6 +351,11 @@ namespace SmolEngine
 			std::filesystem::create_directory(resourcesPath + "/spirv");
 			return resourcesPath + "/spirv/" + fileName + ".spirv";
 
+		case CachedPathType::Reflection:
+
+			std::filesystem::create_directory(resourcesPath + "/spirv");
+			return resourcesPath + "/spirv/" + fileName + ".reflection";
+
 		case CachedPathType::Pipeline:
 
 			return resourcesPath + "/pipeline/ " + fileName + ".pipeline_cache";
@@ -64,7 +64,8 @@ namespace SmolEngine
                 m_SceneAABB.MaxPoint(m_AABB.MaxPoint());
                 m_SceneAABB.MinPoint(m_AABB.MinPoint());
 
-                m_Scene.emplace_back(m_Root);
+                // The root is owned by whoever loaded it
+                m_Scene.emplace_back(m_Root, [](Gfx_Mesh*) {});
             }
 
             // Children
@@ -0,0 +1,220 @@
+#include "Gfx_Precompiled.h"
+#include "Common/Gfx_MipGenerator.h"
+#include "Common/Gfx_PixelStorage.h"
+#include "Common/Gfx_Shader.h"
+#include "Common/Gfx_Helpers.h"
+
+#include "Backend/Gfx_VulkanHelpers.h"
+
+namespace SmolEngine
+{
+	// Levels written by a single dispatch, matches o_Mips in mip_downsample.comp
+	static const uint32_t s_MipsPerDispatch = 4;
+	static const uint32_t s_MipGroupSize = 8;
+
+	struct MipPushConstants
+	{
+		glm::vec2 myInverseSize;
+		uint32_t myMipCount;
+	};
+
+	static std::string locGetShaderPath()
+	{
+		return Gfx_App::GetSingleton()->GetAssetsPath() + "shaders/mip_downsample.comp";
+	}
+
+	Gfx_MipGenerator::Gfx_MipGenerator()
+		:
+		m_Sampler{nullptr},
+		m_SetLayout{nullptr},
+		m_PipelineLayout{nullptr},
+		m_Pipeline{nullptr},
+		m_IsInitialized{false} {}
+
+	void Gfx_MipGenerator::Free()
+	{
+		VK_DESTROY_DEVICE_HANDLE(m_Pipeline, vkDestroyPipeline);
+		VK_DESTROY_DEVICE_HANDLE(m_PipelineLayout, vkDestroyPipelineLayout);
+		VK_DESTROY_DEVICE_HANDLE(m_SetLayout, vkDestroyDescriptorSetLayout);
+		VK_DESTROY_DEVICE_HANDLE(m_Sampler, vkDestroySampler);
+
+		m_Shader = nullptr;
+		m_IsInitialized = false;
+	}
+
+	bool Gfx_MipGenerator::IsComputeSupported(Format format, uint32_t arrayLayers) const
+	{
+		const Gfx_VulkanDevice& device = Gfx_App::GetDevice();
+
+		// Push descriptors keep the per-mip views out of any pool, so uploads in flight need no extra tracking
+		if (!device.GetPushDescriptorSupport() || !device.GetDeviceFeatures()->shaderStorageImageWriteWithoutFormat)
+			return false;
+
+		if (arrayLayers != 1 || Gfx_Helpers::IsCompressedFormat(format))
+			return false;
+
+		// sRGB has no storage support on most devices, blits convert it correctly
+		VkFormatProperties formatProperties{};
+		vkGetPhysicalDeviceFormatProperties(device.GetPhysicalDevice(), Gfx_VulkanHelpers::GetFormat(format), &formatProperties);
+
+		const VkFormatFeatureFlags required = VK_FORMAT_FEATURE_STORAGE_IMAGE_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+		if ((formatProperties.optimalTilingFeatures & required) != required)
+			return false;
+
+		return m_IsInitialized ? m_Pipeline != nullptr : Gfx_Helpers::IsPathValid(locGetShaderPath());
+	}
+
+	void Gfx_MipGenerator::CmdGenerate(VkCommandBuffer cmd, Gfx_PixelStorage* storage)
+	{
+		const PixelStorageCreateDesc& desc = storage->GetDesc();
+		if (desc.myMipLevels <= 1)
+			return;
+
+		if (!m_IsInitialized)
+		{
+			m_IsInitialized = true;
+			if (!CreatePipeline())
+			{
+				GFX_LOG(std::string("Gfx_MipGenerator: compute downsampler unavailable, using blits"), Gfx_Log::Level::Warning)
+			}
+		}
+
+		const bool hasStorageUsage = (desc.myUsageFlags & VK_IMAGE_USAGE_STORAGE_BIT) != 0;
+		if (m_Pipeline != nullptr && hasStorageUsage && IsComputeSupported(desc.myFormat, desc.myArrayLayers))
+		{
+			CmdGenerateCompute(cmd, storage);
+			return;
+		}
+
+		Gfx_VulkanHelpers::GenerateMipMaps(cmd, storage);
+	}
+
+	bool Gfx_MipGenerator::CreatePipeline()
+	{
+		const Gfx_VulkanDevice& device = Gfx_App::GetDevice();
+		if (!device.GetPushDescriptorSupport() || !Gfx_Helpers::IsPathValid(locGetShaderPath()))
+			return false;
+
+		VkDevice logicalDevice = device.GetLogicalDevice();
+
+		ShaderCreateDesc shaderDesc{};
+		shaderDesc.myStages = { { ShaderStage::Compute, locGetShaderPath() } };
+		shaderDesc.myOptimization = ShaderOptimization::Performance;
+
+		m_Shader = std::make_shared<Gfx_Shader>();
+		m_Shader->Create(&shaderDesc);
+
+		VkSamplerCreateInfo samplerCI{};
+		samplerCI.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+		samplerCI.magFilter = VK_FILTER_LINEAR;
+		samplerCI.minFilter = VK_FILTER_LINEAR;
+		samplerCI.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+		samplerCI.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		samplerCI.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		samplerCI.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		samplerCI.maxLod = 0.0f;
+		VK_CHECK_RESULT(vkCreateSampler(logicalDevice, &samplerCI, nullptr, &m_Sampler));
+
+		VkDescriptorSetLayoutBinding bindings[2] = {};
+		bindings[0].binding = 0;
+		bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		bindings[0].descriptorCount = 1;
+		bindings[0].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+		bindings[1].binding = 1;
+		bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+		bindings[1].descriptorCount = s_MipsPerDispatch;
+		bindings[1].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+		VkDescriptorSetLayoutCreateInfo setLayoutCI{};
+		setLayoutCI.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+		setLayoutCI.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_PUSH_DESCRIPTOR_BIT_KHR;
+		setLayoutCI.bindingCount = 2;
+		setLayoutCI.pBindings = bindings;
+		VK_CHECK_RESULT(vkCreateDescriptorSetLayout(logicalDevice, &setLayoutCI, nullptr, &m_SetLayout));
+
+		VkPushConstantRange pushConstantRange{};
+		pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+		pushConstantRange.size = sizeof(MipPushConstants);
+
+		VkPipelineLayoutCreateInfo pipelineLayoutCI{};
+		pipelineLayoutCI.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+		pipelineLayoutCI.setLayoutCount = 1;
+		pipelineLayoutCI.pSetLayouts = &m_SetLayout;
+		pipelineLayoutCI.pushConstantRangeCount = 1;
+		pipelineLayoutCI.pPushConstantRanges = &pushConstantRange;
+		VK_CHECK_RESULT(vkCreatePipelineLayout(logicalDevice, &pipelineLayoutCI, nullptr, &m_PipelineLayout));
+
+		VkComputePipelineCreateInfo pipelineCI{};
+		pipelineCI.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+		pipelineCI.stage = m_Shader->GetShaderStages()[0];
+		pipelineCI.layout = m_PipelineLayout;
+		VK_CHECK_RESULT(vkCreateComputePipelines(logicalDevice, nullptr, 1, &pipelineCI, nullptr, &m_Pipeline));
+
+		return true;
+	}
+
+	void Gfx_MipGenerator::CmdGenerateCompute(VkCommandBuffer cmd, Gfx_PixelStorage* storage)
+	{
+		const Gfx_VulkanDevice& device = Gfx_App::GetDevice();
+		const PixelStorageCreateDesc& desc = storage->GetDesc();
+
+		VkImageSubresourceRange subresourceRange = {};
+		subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		subresourceRange.levelCount = desc.myMipLevels;
+		subresourceRange.layerCount = desc.myArrayLayers;
+
+		// GENERAL for every level, sampled and stored in the same pass
+		Gfx_VulkanHelpers::InsertImageMemoryBarrier(cmd, storage, VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+			VK_IMAGE_LAYOUT_GENERAL, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, subresourceRange);
+
+		vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_Pipeline);
+
+		for (uint32_t srcMip = 0; srcMip + 1 < desc.myMipLevels; srcMip += s_MipsPerDispatch)
+		{
+			const uint32_t mipCount = std::min(s_MipsPerDispatch, desc.myMipLevels - srcMip - 1);
+			const uint32_t width = std::max(desc.mySize.x >> (srcMip + 1), 1u);
+			const uint32_t height = std::max(desc.mySize.y >> (srcMip + 1), 1u);
+
+			VkDescriptorImageInfo sourceInfo{};
+			sourceInfo.sampler = m_Sampler;
+			sourceInfo.imageView = storage->GetMipView(srcMip);
+			sourceInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+			// Unused elements repeat the last level, the shader never stores to them
+			VkDescriptorImageInfo mipInfos[s_MipsPerDispatch] = {};
+			for (uint32_t i = 0; i < s_MipsPerDispatch; ++i)
+			{
+				mipInfos[i].imageView = storage->GetMipView(srcMip + 1 + std::min(i, mipCount - 1));
+				mipInfos[i].imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+			}
+
+			VkWriteDescriptorSet writeSets[2] = {};
+			writeSets[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			writeSets[0].dstBinding = 0;
+			writeSets[0].descriptorCount = 1;
+			writeSets[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+			writeSets[0].pImageInfo = &sourceInfo;
+			writeSets[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			writeSets[1].dstBinding = 1;
+			writeSets[1].descriptorCount = s_MipsPerDispatch;
+			writeSets[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+			writeSets[1].pImageInfo = mipInfos;
+
+			device.vkCmdPushDescriptorSetKHR(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_PipelineLayout, 0, 2, writeSets);
+
+			MipPushConstants pushConstants{};
+			pushConstants.myInverseSize = glm::vec2(1.0f / width, 1.0f / height);
+			pushConstants.myMipCount = mipCount;
+			vkCmdPushConstants(cmd, m_PipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(MipPushConstants), &pushConstants);
+
+			vkCmdDispatch(cmd, (width + s_MipGroupSize - 1) / s_MipGroupSize, (height + s_MipGroupSize - 1) / s_MipGroupSize, 1);
+
+			// The last level of this dispatch is the source of the next one
+			VkMemoryBarrier memoryBarrier{};
+			memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+			memoryBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+			memoryBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+			vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &memoryBarrier, 0, nullptr, 0, nullptr);
+		}
+	}
+}
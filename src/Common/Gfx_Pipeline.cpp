@@ -8,6 +8,8 @@
 
 #include "Backend/Gfx_VulkanHelpers.h"
 
+#include "Gfx_RenderContext.h"
+
 namespace SmolEngine
 {
 	Gfx_Pipeline::Gfx_Pipeline(Type type)
@@ -49,6 +51,118 @@ namespace SmolEngine
 		return m_Pipeline;
 	}
 
+	std::optional<uint32_t> Gfx_Pipeline::GetBindlessSet() const
+	{
+		return m_BindlessSet;
+	}
+
+	void Gfx_Pipeline::CreateLayout(Gfx_Shader* shader, const std::vector<Gfx_Descriptor*>& descriptors, std::optional<uint32_t> bindlessSet)
+	{
+		std::vector<VkDescriptorSetLayout> setLayouts;
+		auto placeLayout = [&setLayouts](uint32_t setIndex, VkDescriptorSetLayout layout)
+		{
+			if (setLayouts.size() <= setIndex)
+				setLayouts.resize(setIndex + 1, nullptr);
+
+			GFX_ASSERT_MSG((setLayouts[setIndex] == nullptr), "Gfx_Pipeline: set index is used more than once")
+			setLayouts[setIndex] = layout;
+		};
+
+		for (Gfx_Descriptor* descriptor : descriptors)
+			placeLayout(descriptor->m_SetIndex, descriptor->m_Layout);
+
+		if (bindlessSet.has_value())
+		{
+			const Gfx_BindlessHeap& heap = Gfx_RenderContext::GetBindlessHeap();
+			GFX_ASSERT_MSG(heap.IsGood(), "Gfx_Pipeline: bindless heap is not supported by the device")
+
+			placeLayout(bindlessSet.value(), heap.GetLayout());
+		}
+
+		// Layouts are cached by bindings, so descriptors created later for these sets stay compatible
+		if (shader != nullptr)
+		{
+			for (const ShaderBindingReflection& binding : shader->GetReflection().myBindings)
+			{
+				if (binding.mySet < setLayouts.size() && setLayouts[binding.mySet] != nullptr)
+					continue;
+
+				DescriptorCreateDesc setDesc{};
+				setDesc.mySet = binding.mySet;
+				setDesc.Reflect(shader);
+
+				placeLayout(binding.mySet, Gfx_Descriptor::FindLayout(&setDesc));
+			}
+		}
+
+		// Unused set indices get an empty layout
+		VkDescriptorSetLayout emptyLayout = Gfx_RenderContext::GetDescriptorAllocator().GetLayout({});
+		for (VkDescriptorSetLayout& layout : setLayouts)
+		{
+			if (layout == nullptr)
+				layout = emptyLayout;
+		}
+
+		// Push constants are shared by all sets, the first descriptor that declares them wins
+		std::optional<VkPushConstantRange> pushConstantRange;
+		for (Gfx_Descriptor* descriptor : descriptors)
+		{
+			if (descriptor->m_PushConstantRange.has_value())
+			{
+				pushConstantRange = descriptor->m_PushConstantRange;
+				break;
+			}
+		}
+
+		if (!pushConstantRange.has_value() && shader != nullptr && shader->GetReflection().myPushConstant.has_value())
+		{
+			const ShaderPushConstantReflection& reflection = shader->GetReflection().myPushConstant.value();
+
+			VkPushConstantRange range;
+			range.size = reflection.mySize;
+			range.offset = reflection.myOffset;
+			range.stageFlags = Gfx_VulkanHelpers::GetShaderStage(reflection.myStages);
+
+			pushConstantRange.emplace(range);
+		}
+
+		VkPipelineLayoutCreateInfo pipelineLayoutCI = {};
+		pipelineLayoutCI.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+		pipelineLayoutCI.pNext = nullptr;
+		pipelineLayoutCI.setLayoutCount = static_cast<uint32_t>(setLayouts.size());
+		pipelineLayoutCI.pSetLayouts = setLayouts.data();
+
+		if (pushConstantRange.has_value())
+		{
+			pipelineLayoutCI.pushConstantRangeCount = 1;
+			pipelineLayoutCI.pPushConstantRanges = &pushConstantRange.value();
+		}
+
+		m_BindlessSet = bindlessSet;
+		VK_CHECK_RESULT(vkCreatePipelineLayout(Gfx_App::GetDevice().GetLogicalDevice(), &pipelineLayoutCI, nullptr, &m_Layout));
+	}
+
+	static VkPipelineCreateFlags locGetCreateFlags()
+	{
+		return Gfx_RenderContext::GetDescriptorBuffer().IsGood() ? VK_PIPELINE_CREATE_DESCRIPTOR_BUFFER_BIT_EXT : 0;
+	}
+
+	template<typename T>
+	static std::vector<Gfx_Descriptor*> locGetDescriptors(const T& descriptor, const std::vector<T>& descriptorSets)
+	{
+		std::vector<Gfx_Descriptor*> descriptors;
+		if (descriptor != nullptr)
+			descriptors.push_back(&*descriptor);
+
+		for (const T& set : descriptorSets)
+		{
+			if (set != nullptr)
+				descriptors.push_back(&*set);
+		}
+
+		return descriptors;
+	}
+
 	static bool locIsBlendEnabled(const GraphicsPipelineCreateDesc* desc)
 	{
 		return desc->mySrcColorBlendFactor != BlendFactor::NONE || desc->myDstColorBlendFactor != BlendFactor::NONE ||
@@ -62,24 +176,14 @@ namespace SmolEngine
 
 	void Gfx_GraphicsPipeline::Create(GraphicsPipelineCreateDesc* desc)
 	{
+		GFX_PROFILE_SCOPE("Gfx_GraphicsPipeline::Create")
+
 		GFX_ASSERT(locIsPipelineCreateDescValid(desc))
 
 		m_Desc = *desc;
 		VkDevice device = Gfx_App::GetDevice().GetLogicalDevice();
 
-		VkPipelineLayoutCreateInfo pipelineLayoutCI = {};
-		pipelineLayoutCI.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-		pipelineLayoutCI.pNext = nullptr;
-		pipelineLayoutCI.setLayoutCount = 1;
-		pipelineLayoutCI.pSetLayouts = &desc->myDescriptor->m_Layout;
-
-		if (desc->myDescriptor->m_PushConstantRange.has_value())
-		{
-			pipelineLayoutCI.pushConstantRangeCount = 1;
-			pipelineLayoutCI.pPushConstantRanges = &desc->myDescriptor->m_PushConstantRange.value();
-		}
-
-		VK_CHECK_RESULT(vkCreatePipelineLayout(device, &pipelineLayoutCI, nullptr, &m_Layout));
+		CreateLayout(desc->myShader.get(), locGetDescriptors(desc->myDescriptor, desc->myDescriptorSets), desc->myBindlessSet);
 
 		VkPipelineInputAssemblyStateCreateInfo inputAssemblyState = {};
 		inputAssemblyState.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
@@ -197,6 +301,7 @@ namespace SmolEngine
 		VkGraphicsPipelineCreateInfo pipelineCreateInfo = {};
 		pipelineCreateInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
 		pipelineCreateInfo.layout = m_Layout;
+		pipelineCreateInfo.flags = locGetCreateFlags();
 		pipelineCreateInfo.renderPass = desc->myFramebuffer->GetRenderPass();
 		pipelineCreateInfo.pVertexInputState = &vertexInputState;
 		pipelineCreateInfo.pInputAssemblyState = &inputAssemblyState;
@@ -226,26 +331,18 @@ namespace SmolEngine
 
 	void Gfx_ComputePipeline::Create(ComputePipelineCreateDesc* desc)
 	{
+		GFX_PROFILE_SCOPE("Gfx_ComputePipeline::Create")
+
 		m_Desc = *desc;
 
-		VkPipelineLayoutCreateInfo pipelineLayoutCI = {};
-		pipelineLayoutCI.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-		pipelineLayoutCI.pNext = nullptr;
-		pipelineLayoutCI.setLayoutCount = 1;
-		pipelineLayoutCI.pSetLayouts = &desc->myDescriptor->m_Layout;
-
-		if (m_Desc.myDescriptor->m_PushConstantRange.has_value())
-		{
-			pipelineLayoutCI.pushConstantRangeCount = 1;
-			pipelineLayoutCI.pPushConstantRanges = &desc->myDescriptor->m_PushConstantRange.value();
-		}
+		CreateLayout(desc->myShader, locGetDescriptors(desc->myDescriptor, desc->myDescriptorSets), desc->myBindlessSet);
 
 		VkDevice device = Gfx_App::GetDevice().GetLogicalDevice();
-		VK_CHECK_RESULT(vkCreatePipelineLayout(device, &pipelineLayoutCI, nullptr, &m_Layout));
 
 		VkComputePipelineCreateInfo computePipelineCreateInfo{};
 		computePipelineCreateInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
 		computePipelineCreateInfo.layout = m_Layout;
+		computePipelineCreateInfo.flags = locGetCreateFlags();
 		computePipelineCreateInfo.stage = desc->myShader->m_ShaderStages[0];
 
 		VkPipelineCacheCreateInfo pipelineCacheCreateInfo = {};
@@ -261,24 +358,15 @@ namespace SmolEngine
 
 	void Gfx_RaytracingPipeline::Create(RaytracingPipelineCreateDesc* desc)
 	{
+		GFX_PROFILE_SCOPE("Gfx_RaytracingPipeline::Create")
+
 		GFX_ASSERT(desc->myDescriptor || desc->myShader)
 
 		m_Desc = *desc;
 
-		VkPipelineLayoutCreateInfo pipelineLayoutCI = {};
-		pipelineLayoutCI.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-		pipelineLayoutCI.pNext = nullptr;
-		pipelineLayoutCI.setLayoutCount = 1;
-		pipelineLayoutCI.pSetLayouts = &desc->myDescriptor->m_Layout;
-
-		if (desc->myDescriptor->m_PushConstantRange.has_value())
-		{
-			pipelineLayoutCI.pushConstantRangeCount = 1;
-			pipelineLayoutCI.pPushConstantRanges = &desc->myDescriptor->m_PushConstantRange.value();
-		}
+		CreateLayout(desc->myShader, locGetDescriptors(desc->myDescriptor, desc->myDescriptorSets), desc->myBindlessSet);
 
 		VkDevice device = Gfx_App::GetDevice().GetLogicalDevice();
-		VK_CHECK_RESULT(vkCreatePipelineLayout(device, &pipelineLayoutCI, nullptr, &m_Layout));
 
 		VkRayTracingPipelineCreateInfoKHR rayTracingPipelineCI = {};
 		rayTracingPipelineCI.sType = VK_STRUCTURE_TYPE_RAY_TRACING_PIPELINE_CREATE_INFO_KHR;
@@ -288,6 +376,7 @@ namespace SmolEngine
 		rayTracingPipelineCI.pGroups = desc->myShader->m_ShaderGroupsRT.data();
 		rayTracingPipelineCI.maxPipelineRayRecursionDepth = desc->myMaxRayRecursionDepth;
 		rayTracingPipelineCI.layout = m_Layout;
+		rayTracingPipelineCI.flags = locGetCreateFlags();
 
 		VK_CHECK_RESULT(Gfx_App::GetDevice().vkCreateRayTracingPipelinesKHR(device, VK_NULL_HANDLE,
 			VK_NULL_HANDLE, 1, &rayTracingPipelineCI, nullptr, &m_Pipeline));
@@ -9,7 +9,9 @@ namespace SmolEngine
 	Gfx_PixelStorage::Gfx_PixelStorage() :
 		m_Alloc{nullptr},
 		m_Image{nullptr},
-		m_ImageView{nullptr} 
+		m_RelocatedImage{nullptr},
+		m_ImageView{nullptr},
+		m_IsRelocatable{false}
 	{
 
 	}
@@ -23,28 +25,185 @@ namespace SmolEngine
 	{
 		m_Desc = *desc;
 
-		m_Desc.myMipLevels == 0 ? static_cast<uint32_t>(floor(log2(std::max(m_Desc.mySize.x, m_Desc.mySize.y)))) + 1 : m_Desc.myMipLevels;
+		m_Desc.myMipLevels = m_Desc.myMipLevels == 0 ? static_cast<uint32_t>(floor(log2(std::max(m_Desc.mySize.x, m_Desc.mySize.y)))) + 1 : m_Desc.myMipLevels;
 
+		VkImageCreateInfo imageCI = GetImageCreateInfo();
+		imageCI.initialLayout = desc->myLayout;
+
+		m_Alloc = Gfx_VulkanAllocator::AllocImage(imageCI, VMA_MEMORY_USAGE_GPU_ONLY, m_Image, m_Desc.myPool);
+		m_ImageView = CreateImageView();
+
+		// Attachments are referenced by framebuffers, only images that can be copied both ways are moved by Defragment
+		const VkImageUsageFlags copyUsage = VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+		const VkImageUsageFlags attachmentUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT |
+			VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
+
+		m_IsRelocatable = m_Alloc != nullptr && m_Desc.myPool != MemoryPool::Dedicated &&
+			(m_Desc.myUsageFlags & copyUsage) == copyUsage && (m_Desc.myUsageFlags & attachmentUsage) == 0;
+
+		if (m_IsRelocatable)
+			Gfx_VulkanAllocator::RegisterRelocatable(m_Alloc, this);
+	}
+
+	void Gfx_PixelStorage::SetImageLayout(VkImageLayout layout)
+	{
+		m_Desc.myLayout = layout;
+	}
+
+	void Gfx_PixelStorage::Free()
+	{
+		VkDevice device = Gfx_App::GetDevice().GetLogicalDevice();
+
+		for (VkImageView& view : m_MipViews)
+		{
+			VK_DESTROY_DEVICE_HANDLE(view, vkDestroyImageView);
+		}
+
+		m_MipViews.clear();
+
+		if (m_ImageView != nullptr && m_Image != nullptr)
+		{
+			if (m_IsRelocatable)
+				Gfx_VulkanAllocator::UnregisterRelocatable(m_Alloc);
+
+			vkDestroyImageView(device, m_ImageView, nullptr);
+			Gfx_VulkanAllocator::FreeImage(m_Image, m_Alloc);
+
+			m_Alloc = nullptr;
+			m_Image = nullptr;
+			m_ImageView = nullptr;
+			m_IsRelocatable = false;
+		}
+	}
+
+	bool Gfx_PixelStorage::IsGood() const
+	{
+		return m_Alloc != nullptr;
+	}
+
+	VkImageView Gfx_PixelStorage::GetMipView(uint32_t mip)
+	{
+		GFX_ASSERT(mip < m_Desc.myMipLevels)
+
+		if (m_MipViews.empty())
+			m_MipViews.resize(m_Desc.myMipLevels, nullptr);
+
+		if (m_MipViews[mip] == nullptr)
+		{
+			VkImageViewCreateInfo imageViewCI = {};
+			imageViewCI.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+			imageViewCI.viewType = VK_IMAGE_VIEW_TYPE_2D;
+			imageViewCI.format = Gfx_VulkanHelpers::GetFormat(m_Desc.myFormat);
+			imageViewCI.subresourceRange.aspectMask = m_Desc.myAspectMask;
+			imageViewCI.subresourceRange.baseMipLevel = mip;
+			imageViewCI.subresourceRange.levelCount = 1;
+			imageViewCI.subresourceRange.baseArrayLayer = 0;
+			imageViewCI.subresourceRange.layerCount = 1;
+			imageViewCI.image = m_Image;
+
+			VK_CHECK_RESULT(vkCreateImageView(Gfx_App::GetDevice().GetLogicalDevice(), &imageViewCI, nullptr, &m_MipViews[mip]));
+		}
+
+		return m_MipViews[mip];
+	}
+
+	bool Gfx_PixelStorage::CmdRelocate(VkCommandBuffer cmd, VmaAllocation dstAllocation)
+	{
+		VkDevice device = Gfx_App::GetDevice().GetLogicalDevice();
+
+		const VkImageCreateInfo imageCI = GetImageCreateInfo();
+		VK_CHECK_RESULT(vkCreateImage(device, &imageCI, nullptr, &m_RelocatedImage));
+		VK_CHECK_RESULT(Gfx_VulkanAllocator::BindImage(dstAllocation, m_RelocatedImage));
+
+		// Nothing was written yet, the new image starts undefined as well
+		if (m_Desc.myLayout == VK_IMAGE_LAYOUT_UNDEFINED)
+			return true;
+
+		ImageLayoutTransitionDesc transitionDesc{};
+		transitionDesc.CmdBuffer = cmd;
+		transitionDesc.SubresourceRange = { m_Desc.myAspectMask, 0, m_Desc.myMipLevels, 0, m_Desc.myArrayLayers };
+		transitionDesc.SrcStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT;
+		transitionDesc.DstStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT;
+
+		transitionDesc.Image = m_Image;
+		transitionDesc.OldImageLayout = m_Desc.myLayout;
+		transitionDesc.NewImageLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+		Gfx_VulkanHelpers::SetImageLayout(transitionDesc);
+
+		transitionDesc.Image = m_RelocatedImage;
+		transitionDesc.OldImageLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		transitionDesc.NewImageLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		Gfx_VulkanHelpers::SetImageLayout(transitionDesc);
+
+		std::vector<VkImageCopy> regions(m_Desc.myMipLevels);
+		for (uint32_t mip = 0; mip < m_Desc.myMipLevels; ++mip)
+		{
+			VkImageCopy& region = regions[mip];
+			region.srcSubresource = { m_Desc.myAspectMask, mip, 0, m_Desc.myArrayLayers };
+			region.dstSubresource = region.srcSubresource;
+			region.extent = { std::max(m_Desc.mySize.x >> mip, 1u), std::max(m_Desc.mySize.y >> mip, 1u), 1 };
+		}
+
+		vkCmdCopyImage(cmd, m_Image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, m_RelocatedImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+			static_cast<uint32_t>(regions.size()), regions.data());
+
+		// The old image is destroyed, only the new one goes back to the tracked layout
+		transitionDesc.OldImageLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		transitionDesc.NewImageLayout = m_Desc.myLayout;
+		Gfx_VulkanHelpers::SetImageLayout(transitionDesc);
+		return true;
+	}
+
+	void Gfx_PixelStorage::OnRelocated(MemoryRelocations& relocations)
+	{
+		VkDevice device = Gfx_App::GetDevice().GetLogicalDevice();
+
+		// The allocation itself now points to the new memory and is kept
+		const VkImageView oldView = m_ImageView;
+		vkDestroyImageView(device, m_ImageView, nullptr);
+		vkDestroyImage(device, m_Image, nullptr);
+
+		m_Image = m_RelocatedImage;
+		m_RelocatedImage = nullptr;
+		m_ImageView = CreateImageView();
+		relocations.Add(oldView, m_ImageView);
+
+		for (uint32_t mip = 0; mip < static_cast<uint32_t>(m_MipViews.size()); ++mip)
+		{
+			const VkImageView oldMipView = m_MipViews[mip];
+			if (oldMipView == nullptr)
+				continue;
+
+			vkDestroyImageView(device, oldMipView, nullptr);
+			m_MipViews[mip] = nullptr;
+			relocations.Add(oldMipView, GetMipView(mip));
+		}
+	}
+
+	VkImageCreateInfo Gfx_PixelStorage::GetImageCreateInfo() const
+	{
 		VkImageCreateInfo imageCI = {};
 		imageCI.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
 		imageCI.imageType = VK_IMAGE_TYPE_2D;
 		imageCI.format = Gfx_VulkanHelpers::GetFormat(m_Desc.myFormat);
 		imageCI.mipLevels = m_Desc.myMipLevels;
-		imageCI.extent.depth = 1;
 		imageCI.arrayLayers = m_Desc.myArrayLayers;
 		imageCI.samples = VK_SAMPLE_COUNT_1_BIT;
 		imageCI.tiling = VK_IMAGE_TILING_OPTIMAL;
-		imageCI.initialLayout = desc->myLayout;
+		imageCI.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
 		imageCI.extent = { m_Desc.mySize.x, m_Desc.mySize.y, 1 };
 		imageCI.usage = m_Desc.myUsageFlags;
 		imageCI.flags = m_Desc.myCreateFlags;
 
-		m_Alloc = Gfx_VulkanAllocator::AllocImage(imageCI, VMA_MEMORY_USAGE_GPU_ONLY, m_Image);
+		return imageCI;
+	}
 
+	VkImageView Gfx_PixelStorage::CreateImageView() const
+	{
 		VkImageViewCreateInfo imageViewCI = {};
 		imageViewCI.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
 
-		switch (imageCI.flags)
+		switch (m_Desc.myCreateFlags)
 		{
 		case VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT:
 		{
@@ -63,41 +222,17 @@ namespace SmolEngine
 		}
 		}
 
-		imageViewCI.format = imageCI.format;
+		imageViewCI.format = Gfx_VulkanHelpers::GetFormat(m_Desc.myFormat);
 		imageViewCI.components = { VK_COMPONENT_SWIZZLE_R, VK_COMPONENT_SWIZZLE_G, VK_COMPONENT_SWIZZLE_B, VK_COMPONENT_SWIZZLE_A };
 		imageViewCI.subresourceRange.aspectMask = m_Desc.myAspectMask;
 		imageViewCI.subresourceRange.baseMipLevel = 0;
 		imageViewCI.subresourceRange.baseArrayLayer = 0;
-		imageViewCI.subresourceRange.layerCount = imageCI.arrayLayers;
+		imageViewCI.subresourceRange.layerCount = m_Desc.myArrayLayers;
 		imageViewCI.subresourceRange.levelCount = m_Desc.myMipLevels;
 		imageViewCI.image = m_Image;
 
-		VK_CHECK_RESULT(vkCreateImageView(Gfx_App::GetDevice().GetLogicalDevice(), &imageViewCI, nullptr, &m_ImageView));
-	}
-
-	void Gfx_PixelStorage::SetImageLayout(VkImageLayout layout)
-	{
-		m_Desc.myLayout = layout;
+		VkImageView imageView = nullptr;
+		VK_CHECK_RESULT(vkCreateImageView(Gfx_App::GetDevice().GetLogicalDevice(), &imageViewCI, nullptr, &imageView));
+		return imageView;
 	}
-
-	void Gfx_PixelStorage::Free()
-	{
-		VkDevice device = Gfx_App::GetDevice().GetLogicalDevice();
-
-		if (m_ImageView != nullptr && m_Image != nullptr)
-		{
-			vkDestroyImageView(device, m_ImageView, nullptr);
-			Gfx_VulkanAllocator::FreeImage(m_Image, m_Alloc);
-
-			m_Alloc = nullptr;
-			m_Image = nullptr;
-			m_ImageView = nullptr;
-		}
-	}
-
-	bool Gfx_PixelStorage::IsGood() const
-	{
-		return m_Alloc != nullptr;
-	}
-
 }
\ No newline at end of file
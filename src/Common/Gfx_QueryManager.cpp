@@ -0,0 +1,274 @@
+#include "Gfx_Precompiled.h"
+#include "Common/Gfx_QueryManager.h"
+#include "Common/Gfx_CmdBuffer.h"
+
+namespace SmolEngine
+{
+	static const uint32_t s_MaxStatisticsQueries = 64;
+	static const uint32_t s_MaxOcclusionQueries = 1024;
+
+	// Results are written in bit order, one value per flag
+	static const VkQueryPipelineStatisticFlags s_StatisticsFlags =
+		VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_VERTICES_BIT |
+		VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_PRIMITIVES_BIT |
+		VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT |
+		VK_QUERY_PIPELINE_STATISTIC_CLIPPING_INVOCATIONS_BIT |
+		VK_QUERY_PIPELINE_STATISTIC_CLIPPING_PRIMITIVES_BIT |
+		VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT |
+		VK_QUERY_PIPELINE_STATISTIC_COMPUTE_SHADER_INVOCATIONS_BIT;
+
+	static const uint32_t s_StatisticsCount = 7;
+
+	static VkQueryPool locCreatePool(VkQueryType type, uint32_t count, VkQueryPipelineStatisticFlags statistics = 0)
+	{
+		VkQueryPoolCreateInfo poolInfo{};
+		poolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+		poolInfo.queryType = type;
+		poolInfo.queryCount = count;
+		poolInfo.pipelineStatistics = statistics;
+
+		VkQueryPool pool = nullptr;
+		VK_CHECK_RESULT(vkCreateQueryPool(Gfx_App::GetDevice().GetLogicalDevice(), &poolInfo, nullptr, &pool));
+		return pool;
+	}
+
+	// Values followed by the availability word, per query
+	static bool locGetResults(VkQueryPool pool, uint32_t count, uint32_t valuesPerQuery, std::vector<uint64_t>& outResults)
+	{
+		const uint32_t stride = valuesPerQuery + 1;
+		outResults.resize(count * stride);
+
+		const VkResult result = vkGetQueryPoolResults(Gfx_App::GetDevice().GetLogicalDevice(), pool, 0, count, outResults.size() * sizeof(uint64_t),
+			outResults.data(), stride * sizeof(uint64_t), VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+
+		return result == VK_SUCCESS || result == VK_NOT_READY;
+	}
+
+	Gfx_QueryManager::Gfx_QueryManager()
+		:
+		m_FrameCmd{nullptr},
+		m_FrameIndex{0},
+		m_IsStatisticsSupported{false},
+		m_IsStatisticsEnabled{false},
+		m_IsStatisticsActive{false},
+		m_IsOcclusionActive{false},
+		m_IsPreciseOcclusion{false},
+		m_StatisticsDepth{0},
+		m_OcclusionDepth{0},
+		m_FrameCount{0} {}
+
+	void Gfx_QueryManager::Create(uint32_t framesInFlight)
+	{
+		const VkPhysicalDeviceFeatures* features = Gfx_App::GetDevice().GetDeviceFeatures();
+		m_IsStatisticsSupported = features->pipelineStatisticsQuery == VK_TRUE;
+		m_IsPreciseOcclusion = features->occlusionQueryPrecise == VK_TRUE;
+
+		m_Slots.resize(framesInFlight);
+		for (FrameSlot& slot : m_Slots)
+		{
+			slot.myOcclusionPool = locCreatePool(VK_QUERY_TYPE_OCCLUSION, s_MaxOcclusionQueries);
+
+			if (m_IsStatisticsSupported)
+				slot.myStatisticsPool = locCreatePool(VK_QUERY_TYPE_PIPELINE_STATISTICS, s_MaxStatisticsQueries, s_StatisticsFlags);
+		}
+	}
+
+	void Gfx_QueryManager::Free()
+	{
+		for (FrameSlot& slot : m_Slots)
+		{
+			VK_DESTROY_DEVICE_HANDLE(slot.myStatisticsPool, vkDestroyQueryPool);
+			VK_DESTROY_DEVICE_HANDLE(slot.myOcclusionPool, vkDestroyQueryPool);
+		}
+
+		m_Slots.clear();
+		m_Statistics.clear();
+		m_Occlusions.clear();
+	}
+
+	void Gfx_QueryManager::BeginFrame(uint32_t frameIndex)
+	{
+		m_FrameIndex = frameIndex;
+		m_FrameCount++;
+		m_FrameCmd = nullptr;
+
+		if (m_Slots.empty())
+			return;
+
+		GFX_ASSERT_MSG((frameIndex < m_Slots.size()), "Gfx_QueryManager: frame index must come from the ring sized by Create")
+
+		FrameSlot& slot = m_Slots[frameIndex];
+		if (slot.myIsRecorded)
+			Resolve(slot);
+
+		slot.myStatistics.clear();
+		slot.myOcclusions.clear();
+		slot.myFrame = m_FrameCount;
+		slot.myIsRecorded = false;
+	}
+
+	void Gfx_QueryManager::CmdReset(Gfx_CmdBuffer* cmd)
+	{
+		m_IsStatisticsActive = false;
+		m_IsOcclusionActive = false;
+		m_StatisticsDepth = 0;
+		m_OcclusionDepth = 0;
+
+		if (m_Slots.empty())
+			return;
+
+		FrameSlot& slot = m_Slots[m_FrameIndex];
+		vkCmdResetQueryPool(cmd->GetBuffer(), slot.myOcclusionPool, 0, s_MaxOcclusionQueries);
+
+		if (slot.myStatisticsPool != nullptr)
+			vkCmdResetQueryPool(cmd->GetBuffer(), slot.myStatisticsPool, 0, s_MaxStatisticsQueries);
+
+		m_FrameCmd = cmd->GetBuffer();
+		slot.myIsRecorded = true;
+	}
+
+	void Gfx_QueryManager::SetStatisticsEnabled(bool enabled)
+	{
+		m_IsStatisticsEnabled = enabled;
+	}
+
+	void Gfx_QueryManager::CmdBeginStatistics(Gfx_CmdBuffer* cmd, const std::string& name)
+	{
+		if (m_StatisticsDepth++ > 0 || !m_IsStatisticsEnabled || !m_IsStatisticsSupported || !IsRecording(cmd))
+			return;
+
+		FrameSlot& slot = m_Slots[m_FrameIndex];
+		if (slot.myStatistics.size() >= s_MaxStatisticsQueries)
+			return;
+
+		const uint32_t query = static_cast<uint32_t>(slot.myStatistics.size());
+		slot.myStatistics.push_back({ name, query });
+
+		vkCmdBeginQuery(m_FrameCmd, slot.myStatisticsPool, query, 0);
+		m_IsStatisticsActive = true;
+	}
+
+	void Gfx_QueryManager::CmdEndStatistics(Gfx_CmdBuffer* cmd)
+	{
+		GFX_ASSERT_MSG((m_StatisticsDepth > 0), "Gfx_QueryManager: EndStatistics without BeginStatistics")
+
+		if (--m_StatisticsDepth > 0 || !m_IsStatisticsActive)
+			return;
+
+		FrameSlot& slot = m_Slots[m_FrameIndex];
+		vkCmdEndQuery(m_FrameCmd, slot.myStatisticsPool, slot.myStatistics.back().myQuery);
+		m_IsStatisticsActive = false;
+	}
+
+	void Gfx_QueryManager::CmdBeginOcclusion(Gfx_CmdBuffer* cmd, uint64_t id)
+	{
+		if (m_OcclusionDepth++ > 0 || !IsRecording(cmd))
+			return;
+
+		FrameSlot& slot = m_Slots[m_FrameIndex];
+		if (slot.myOcclusions.size() >= s_MaxOcclusionQueries)
+			return;
+
+		const uint32_t query = static_cast<uint32_t>(slot.myOcclusions.size());
+		slot.myOcclusions.push_back({ id, query });
+
+		vkCmdBeginQuery(m_FrameCmd, slot.myOcclusionPool, query, m_IsPreciseOcclusion ? VK_QUERY_CONTROL_PRECISE_BIT : 0);
+		m_IsOcclusionActive = true;
+	}
+
+	void Gfx_QueryManager::CmdEndOcclusion(Gfx_CmdBuffer* cmd)
+	{
+		GFX_ASSERT_MSG((m_OcclusionDepth > 0), "Gfx_QueryManager: EndOcclusion without BeginOcclusion")
+
+		if (--m_OcclusionDepth > 0 || !m_IsOcclusionActive)
+			return;
+
+		FrameSlot& slot = m_Slots[m_FrameIndex];
+		vkCmdEndQuery(m_FrameCmd, slot.myOcclusionPool, slot.myOcclusions.back().myQuery);
+		m_IsOcclusionActive = false;
+	}
+
+	bool Gfx_QueryManager::IsStatisticsSupported() const
+	{
+		return m_IsStatisticsSupported;
+	}
+
+	bool Gfx_QueryManager::IsStatisticsEnabled() const
+	{
+		return m_IsStatisticsEnabled;
+	}
+
+	bool Gfx_QueryManager::GetStatistics(const std::string& name, PipelineStatistics& outStats) const
+	{
+		const auto& it = m_Statistics.find(name);
+		if (it == m_Statistics.end())
+			return false;
+
+		outStats = it->second;
+		return true;
+	}
+
+	bool Gfx_QueryManager::GetOcclusion(uint64_t id, OcclusionResult& outResult) const
+	{
+		const auto& it = m_Occlusions.find(id);
+		if (it == m_Occlusions.end())
+			return false;
+
+		outResult = it->second;
+		return true;
+	}
+
+	const std::unordered_map<std::string, PipelineStatistics>& Gfx_QueryManager::GetAllStatistics() const
+	{
+		return m_Statistics;
+	}
+
+	void Gfx_QueryManager::Resolve(FrameSlot& slot)
+	{
+		std::vector<uint64_t> results;
+
+		if (!slot.myStatistics.empty() && locGetResults(slot.myStatisticsPool, static_cast<uint32_t>(slot.myStatistics.size()), s_StatisticsCount, results))
+		{
+			// A pass recorded more than once per frame is summed
+			std::unordered_map<std::string, PipelineStatistics> frameStatistics;
+			for (const QueryRecord<std::string>& record : slot.myStatistics)
+			{
+				const uint64_t* values = &results[record.myQuery * (s_StatisticsCount + 1)];
+				if (values[s_StatisticsCount] == 0)
+					continue;
+
+				PipelineStatistics& stats = frameStatistics[record.myKey];
+				stats.myInputVertices += values[0];
+				stats.myInputPrimitives += values[1];
+				stats.myVertexInvocations += values[2];
+				stats.myClippingInvocations += values[3];
+				stats.myClippingPrimitives += values[4];
+				stats.myFragmentInvocations += values[5];
+				stats.myComputeInvocations += values[6];
+				stats.myFrame = slot.myFrame;
+			}
+
+			for (auto& [name, stats] : frameStatistics)
+				m_Statistics[name] = stats;
+		}
+
+		if (!slot.myOcclusions.empty() && locGetResults(slot.myOcclusionPool, static_cast<uint32_t>(slot.myOcclusions.size()), 1, results))
+		{
+			for (const QueryRecord<uint64_t>& record : slot.myOcclusions)
+			{
+				const uint64_t* values = &results[record.myQuery * 2];
+				if (values[1] == 0)
+					continue;
+
+				OcclusionResult& occlusion = m_Occlusions[record.myKey];
+				occlusion.mySamples = occlusion.myFrame == slot.myFrame ? occlusion.mySamples + values[0] : values[0];
+				occlusion.myFrame = slot.myFrame;
+			}
+		}
+	}
+
+	bool Gfx_QueryManager::IsRecording(Gfx_CmdBuffer* cmd) const
+	{
+		return !m_Slots.empty() && cmd->GetBuffer() == m_FrameCmd;
+	}
+}
@@ -0,0 +1,287 @@
+#include "Gfx_Precompiled.h"
+#include "Common/Gfx_Readback.h"
+#include "Common/Gfx_Helpers.h"
+#include "Common/Gfx_CmdBuffer.h"
+
+#include "Backend/Gfx_VulkanHelpers.h"
+
+#include <numeric>
+
+namespace SmolEngine
+{
+	// Smallest staging page, a slot keeps the size it needed last frame
+	static const VkDeviceSize s_ReadbackPageSize = 4 * 1024 * 1024;
+
+	// Bytes per texel of the aspect a copy reads, depth stencil formats are read without stencil
+	static uint32_t locGetTexelSize(Format format)
+	{
+		switch (format)
+		{
+		case Format::D16_UNORM_S8_UINT:
+			return sizeof(uint16_t);
+		case Format::D32_SFLOAT_S8_UINT:
+			return sizeof(float);
+		default:
+			return Gfx_Helpers::GetFormatSize(format);
+		}
+	}
+
+	static void locMemoryBarrier(VkCommandBuffer cmd, VkAccessFlags srcAccessMask, VkAccessFlags dstAccessMask, VkPipelineStageFlags srcStageMask, VkPipelineStageFlags dstStageMask)
+	{
+		VkMemoryBarrier memoryBarrier = {};
+		memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		memoryBarrier.srcAccessMask = srcAccessMask;
+		memoryBarrier.dstAccessMask = dstAccessMask;
+
+		vkCmdPipelineBarrier(cmd, srcStageMask, dstStageMask, 0, 1, &memoryBarrier, 0, nullptr, 0, nullptr);
+	}
+
+	Gfx_ReadbackTicket::Gfx_ReadbackTicket()
+		:
+		m_Size{0, 0},
+		m_Format{Format::R8G8B8A8_UNORM},
+		m_IsReady{false} {}
+
+	bool Gfx_ReadbackTicket::IsReady() const
+	{
+		return m_IsReady.load(std::memory_order_acquire);
+	}
+
+	const std::vector<uint8_t>& Gfx_ReadbackTicket::GetData() const
+	{
+		return m_Data;
+	}
+
+	const glm::uvec2& Gfx_ReadbackTicket::GetSize() const
+	{
+		return m_Size;
+	}
+
+	Format Gfx_ReadbackTicket::GetFormat() const
+	{
+		return m_Format;
+	}
+
+	Gfx_ReadbackQueue::Gfx_ReadbackQueue()
+		:
+		m_FrameIndex{0} {}
+
+	void Gfx_ReadbackQueue::Create(uint32_t framesInFlight)
+	{
+		m_Slots.resize(framesInFlight);
+	}
+
+	void Gfx_ReadbackQueue::Free()
+	{
+		m_Slots.clear();
+	}
+
+	void Gfx_ReadbackQueue::BeginFrame(uint32_t frameIndex)
+	{
+		GFX_ASSERT_MSG((frameIndex < m_Slots.size()), "Gfx_ReadbackQueue: frame index must come from the ring sized by Create")
+
+		m_FrameIndex = frameIndex;
+
+		// Copies of this frame index were recorded into an already signaled submit
+		FrameSlot& slot = m_Slots[frameIndex];
+		for (PendingCopy& pending : slot.myPending)
+			Resolve(slot.myPages[pending.myPage].get(), pending.myOffset, pending.myTicket.get());
+
+		// Overflow pages are folded into one that fits the whole frame next time
+		if (slot.myPages.size() > 1)
+		{
+			slot.myPages.clear();
+			slot.myPages.push_back(CreateStaging(std::max(slot.myUsed, s_ReadbackPageSize)));
+		}
+
+		slot.myPending.clear();
+		slot.myPageUsed = 0;
+		slot.myUsed = 0;
+	}
+
+	Ref<Gfx_ReadbackTicket> Gfx_ReadbackQueue::ReadbackAsync(Gfx_PixelStorage* storage, const ReadbackRegion& region)
+	{
+		Ref<Gfx_ReadbackTicket> ticket = std::make_shared<Gfx_ReadbackTicket>();
+
+		VkBufferImageCopy copy = {};
+		const VkDeviceSize size = PrepareImage(storage, region, copy, ticket.get());
+		const VkDeviceSize alignment = std::lcm<VkDeviceSize>(locGetTexelSize(storage->GetDesc().myFormat), 16);
+
+		uint32_t page = 0;
+		Gfx_Buffer* staging = Allocate(size, alignment, page, copy.bufferOffset);
+		CmdCopyImage(Gfx_App::GetCommandBuffer()->GetBuffer(), storage, copy, staging->GetRawBuffer());
+
+		m_Slots[m_FrameIndex].myPending.push_back({ ticket, page, copy.bufferOffset });
+		return ticket;
+	}
+
+	Ref<Gfx_ReadbackTicket> Gfx_ReadbackQueue::ReadbackAsync(Gfx_Buffer* buffer, size_t offset, size_t size)
+	{
+		if (size == 0)
+			size = buffer->GetSize() - offset;
+
+		Ref<Gfx_ReadbackTicket> ticket = std::make_shared<Gfx_ReadbackTicket>();
+		ticket->m_Data.resize(size);
+
+		uint32_t page = 0;
+		VkDeviceSize stagingOffset = 0;
+		Gfx_Buffer* staging = Allocate(size, 16, page, stagingOffset);
+		CmdCopyBuffer(Gfx_App::GetCommandBuffer()->GetBuffer(), buffer, offset, staging->GetRawBuffer(), stagingOffset, size);
+
+		m_Slots[m_FrameIndex].myPending.push_back({ ticket, page, stagingOffset });
+		return ticket;
+	}
+
+	Ref<Gfx_ReadbackTicket> Gfx_ReadbackQueue::Readback(Gfx_PixelStorage* storage, const ReadbackRegion& region)
+	{
+		Ref<Gfx_ReadbackTicket> ticket = std::make_shared<Gfx_ReadbackTicket>();
+
+		VkBufferImageCopy copy = {};
+		Ref<Gfx_Buffer> staging = CreateStaging(PrepareImage(storage, region, copy, ticket.get()));
+
+		Gfx_CmdBuffer cmdBuffer{};
+		CmdBufferCreateDesc cmdDesc{};
+		cmdBuffer.Create(&cmdDesc);
+
+		cmdBuffer.CmdBeginRecord();
+		CmdCopyImage(cmdBuffer.GetBuffer(), storage, copy, staging->GetRawBuffer());
+		cmdBuffer.CmdEndRecord();
+
+		Gfx_VulkanHelpers::ExecuteCmdBuffer(&cmdBuffer);
+
+		Resolve(staging.get(), 0, ticket.get());
+		return ticket;
+	}
+
+	Ref<Gfx_ReadbackTicket> Gfx_ReadbackQueue::Readback(Gfx_Buffer* buffer, size_t offset, size_t size)
+	{
+		if (size == 0)
+			size = buffer->GetSize() - offset;
+
+		Ref<Gfx_ReadbackTicket> ticket = std::make_shared<Gfx_ReadbackTicket>();
+		ticket->m_Data.resize(size);
+
+		Ref<Gfx_Buffer> staging = CreateStaging(size);
+
+		Gfx_CmdBuffer cmdBuffer{};
+		CmdBufferCreateDesc cmdDesc{};
+		cmdBuffer.Create(&cmdDesc);
+
+		cmdBuffer.CmdBeginRecord();
+		CmdCopyBuffer(cmdBuffer.GetBuffer(), buffer, offset, staging->GetRawBuffer(), 0, size);
+		cmdBuffer.CmdEndRecord();
+
+		Gfx_VulkanHelpers::ExecuteCmdBuffer(&cmdBuffer);
+
+		Resolve(staging.get(), 0, ticket.get());
+		return ticket;
+	}
+
+	Gfx_Buffer* Gfx_ReadbackQueue::Allocate(VkDeviceSize size, VkDeviceSize alignment, uint32_t& outPage, VkDeviceSize& outOffset)
+	{
+		FrameSlot& slot = m_Slots[m_FrameIndex];
+
+		VkDeviceSize offset = (slot.myPageUsed + alignment - 1) / alignment * alignment;
+		if (slot.myPages.empty() || offset + size > slot.myPages.back()->GetSize())
+		{
+			slot.myPages.push_back(CreateStaging(std::max(size, s_ReadbackPageSize)));
+			offset = 0;
+		}
+
+		slot.myPageUsed = offset + size;
+		slot.myUsed += size + alignment;
+
+		outPage = static_cast<uint32_t>(slot.myPages.size() - 1);
+		outOffset = offset;
+		return slot.myPages.back().get();
+	}
+
+	Ref<Gfx_Buffer> Gfx_ReadbackQueue::CreateStaging(VkDeviceSize size)
+	{
+		BufferCreateDesc bufferDesc{};
+		bufferDesc.mySize = size;
+		bufferDesc.myBufferUsage = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+		bufferDesc.myMemUsage = VMA_MEMORY_USAGE_GPU_TO_CPU;
+
+		Ref<Gfx_Buffer> buffer = std::make_shared<Gfx_Buffer>();
+		buffer->Create(bufferDesc);
+		return buffer;
+	}
+
+	VkDeviceSize Gfx_ReadbackQueue::PrepareImage(Gfx_PixelStorage* storage, const ReadbackRegion& region, VkBufferImageCopy& outCopy, Gfx_ReadbackTicket* ticket)
+	{
+		const PixelStorageCreateDesc& desc = storage->GetDesc();
+		GFX_ASSERT_MSG((!Gfx_Helpers::IsCompressedFormat(desc.myFormat)), "Gfx_ReadbackQueue: compressed images can't be read back")
+		GFX_ASSERT_MSG((region.myMip < desc.myMipLevels && region.myLayer < desc.myArrayLayers), "Gfx_ReadbackQueue: region is outside the image")
+		GFX_ASSERT_MSG((storage->GetImageLayout() != VK_IMAGE_LAYOUT_UNDEFINED), "Gfx_ReadbackQueue: image was never written")
+
+		const glm::uvec2 mipSize = { std::max(desc.mySize.x >> region.myMip, 1u), std::max(desc.mySize.y >> region.myMip, 1u) };
+		GFX_ASSERT_MSG((region.myOffset.x < mipSize.x && region.myOffset.y < mipSize.y), "Gfx_ReadbackQueue: region is outside the image")
+
+		glm::uvec2 size = region.mySize;
+		if (size.x == 0) size.x = mipSize.x - region.myOffset.x;
+		if (size.y == 0) size.y = mipSize.y - region.myOffset.y;
+
+		outCopy.imageSubresource.aspectMask = Gfx_VulkanHelpers::IsDepthFormat(desc.myFormat) ? VK_IMAGE_ASPECT_DEPTH_BIT : VK_IMAGE_ASPECT_COLOR_BIT;
+		outCopy.imageSubresource.mipLevel = region.myMip;
+		outCopy.imageSubresource.baseArrayLayer = region.myLayer;
+		outCopy.imageSubresource.layerCount = 1;
+		outCopy.imageOffset = { static_cast<int32_t>(region.myOffset.x), static_cast<int32_t>(region.myOffset.y), 0 };
+		outCopy.imageExtent = { size.x, size.y, 1 };
+
+		const VkDeviceSize bytes = static_cast<VkDeviceSize>(size.x) * size.y * locGetTexelSize(desc.myFormat);
+		ticket->m_Data.resize(bytes);
+		ticket->m_Size = size;
+		ticket->m_Format = desc.myFormat;
+		return bytes;
+	}
+
+	void Gfx_ReadbackQueue::CmdCopyImage(VkCommandBuffer cmd, Gfx_PixelStorage* storage, const VkBufferImageCopy& copy, VkBuffer staging)
+	{
+		const PixelStorageCreateDesc& desc = storage->GetDesc();
+		const VkImageLayout layout = storage->GetImageLayout();
+
+		VkImageSubresourceRange subresourceRange = {};
+		subresourceRange.aspectMask = desc.myAspectMask;
+		subresourceRange.levelCount = desc.myMipLevels;
+		subresourceRange.layerCount = desc.myArrayLayers;
+
+		Gfx_VulkanHelpers::InsertImageMemoryBarrier(cmd, storage, VK_ACCESS_MEMORY_WRITE_BIT, VK_ACCESS_TRANSFER_READ_BIT, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+			VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, subresourceRange);
+
+		vkCmdCopyImageToBuffer(cmd, storage->GetImage(), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, staging, 1, &copy);
+
+		Gfx_VulkanHelpers::InsertImageMemoryBarrier(cmd, storage, VK_ACCESS_TRANSFER_READ_BIT, VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT, layout,
+			VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, subresourceRange);
+
+		locMemoryBarrier(cmd, VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_HOST_READ_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT);
+	}
+
+	void Gfx_ReadbackQueue::CmdCopyBuffer(VkCommandBuffer cmd, Gfx_Buffer* buffer, size_t offset, VkBuffer staging, VkDeviceSize stagingOffset, size_t size)
+	{
+		GFX_ASSERT_MSG((buffer->GetBufferFlags() & VK_BUFFER_USAGE_TRANSFER_SRC_BIT), "Gfx_ReadbackQueue: buffer needs VK_BUFFER_USAGE_TRANSFER_SRC_BIT")
+		GFX_ASSERT_MSG((offset + size <= buffer->GetSize()), "Gfx_ReadbackQueue: range is outside the buffer")
+
+		locMemoryBarrier(cmd, VK_ACCESS_MEMORY_WRITE_BIT, VK_ACCESS_TRANSFER_READ_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
+
+		VkBufferCopy copyRegion = {};
+		copyRegion.srcOffset = buffer->GetOffset() + offset;
+		copyRegion.dstOffset = stagingOffset;
+		copyRegion.size = size;
+
+		vkCmdCopyBuffer(cmd, buffer->GetRawBuffer(), staging, 1, &copyRegion);
+
+		locMemoryBarrier(cmd, VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_HOST_READ_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT);
+	}
+
+	void Gfx_ReadbackQueue::Resolve(Gfx_Buffer* staging, VkDeviceSize offset, Gfx_ReadbackTicket* ticket)
+	{
+		Gfx_VulkanAllocator::InvalidateMemory(staging->GetVmaAllocation());
+
+		const uint8_t* data = static_cast<const uint8_t*>(staging->MapMemory());
+		memcpy(ticket->m_Data.data(), data + offset, ticket->m_Data.size());
+		staging->UnMapMemory();
+
+		ticket->m_IsReady.store(true, std::memory_order_release);
+	}
+}
@@ -14,6 +14,8 @@ namespace SmolEngine
 
 	void Gfx_Sampler::Create(SamplerCreateDesc* desc)
 	{
+		m_Desc = *desc;
+
 		VkSamplerCreateInfo samplerCI = {};
 
 		samplerCI.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
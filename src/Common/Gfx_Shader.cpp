@@ -2,9 +2,57 @@
 #include "Common/Gfx_Shader.h"
 #include "Common/Gfx_Helpers.h"
 #include "Tools/Gfx_ShaderCompiler.h"
+#include "Gfx_RenderContext.h"
 
 namespace SmolEngine
 {
+	void ShaderReflection::Merge(const ShaderReflection& other)
+	{
+		for (const auto& binding : other.myBindings)
+		{
+			auto it = std::find_if(myBindings.begin(), myBindings.end(), [&binding](const ShaderBindingReflection& b)
+				{
+					return b.mySet == binding.mySet && b.myBinding == binding.myBinding;
+				});
+
+			if (it != myBindings.end())
+			{
+				GFX_ASSERT(it->myType == binding.myType)
+				GFX_ASSERT(it->myCount == binding.myCount)
+
+				it->myStages |= binding.myStages;
+				continue;
+			}
+
+			myBindings.push_back(binding);
+		}
+
+		if (other.myPushConstant.has_value())
+		{
+			if (myPushConstant.has_value())
+			{
+				myPushConstant->mySize = std::max(myPushConstant->mySize, other.myPushConstant->mySize);
+				myPushConstant->myStages |= other.myPushConstant->myStages;
+			}
+			else
+				myPushConstant = other.myPushConstant;
+		}
+
+		for (const auto& constant : other.mySpecConstants)
+		{
+			auto it = std::find_if(mySpecConstants.begin(), mySpecConstants.end(), [&constant](const ShaderSpecConstantReflection& c)
+				{
+					return c.myConstantID == constant.myConstantID;
+				});
+
+			if (it == mySpecConstants.end())
+				mySpecConstants.push_back(constant);
+		}
+
+		if (other.myWorkgroupSize != glm::uvec3(0))
+			myWorkgroupSize = other.myWorkgroupSize;
+	}
+
 	ShaderCreateDesc& Gfx_Shader::GetDesc()
 	{
 		return m_CreateInfo;
@@ -15,34 +63,88 @@ namespace SmolEngine
 		Free();
 	}
 
+	const ShaderReflection& Gfx_Shader::GetReflection() const
+	{
+		return m_Reflection;
+	}
+
+	const ShaderReflection* Gfx_Shader::GetReflection(ShaderStage stage) const
+	{
+		const auto& it = m_StageReflection.find(stage);
+		if (it != m_StageReflection.end())
+			return &it->second;
+
+		return nullptr;
+	}
+
+	const ShaderCompileStats* Gfx_Shader::GetCompileStats(ShaderStage stage) const
+	{
+		const auto& it = m_CompileStats.find(stage);
+		if (it != m_CompileStats.end())
+			return &it->second;
+
+		return nullptr;
+	}
+
 	void Gfx_Shader::Create(ShaderCreateDesc* desc)
 	{
+		GFX_PROFILE_SCOPE("Gfx_Shader::Create")
+
 		m_CreateInfo = *desc;
+		m_StageReflection.clear();
+		m_CompileStats.clear();
+		m_Reflection = {};
 
 		const auto loadOrCompile = [this](ShaderCreateDesc* desc, ShaderStage stage, const std::string& path)
 		{
-			if (path.empty()){ return; }
-
-			auto& binaries = m_Binary[stage];
-			std::string cachedPath = Gfx_Helpers::GetCachedPath(path, CachedPathType::Shader);
-			if (Gfx_Helpers::IsPathValid(cachedPath))
-			{
-				Gfx_ShaderCompiler::LoadSPIRV(cachedPath, binaries);
-				return;
-			}
+			if (path.empty()){ return true; }
 
 			ShaderCompileDesc compileDesc{};
 			compileDesc.myDefines = desc->myDefines;
 			compileDesc.myFilePath = path;
 			compileDesc.myStage = stage;
+			compileDesc.myOptimization = desc->myOptimization;
+			compileDesc.myStripDebugInfo = desc->myStripDebugInfo;
+
+			auto& binaries = m_Binary[stage];
+			auto& reflection = m_StageReflection[stage];
+			std::string cachedPath = Gfx_ShaderCompiler::GetCachedPath(compileDesc, CachedPathType::Shader);
+			if (Gfx_Helpers::IsPathValid(cachedPath))
+			{
+				// Stripped binaries have no names left to reflect, a cache without its reflection is compiled again
+				std::string reflectionPath = Gfx_ShaderCompiler::GetCachedPath(compileDesc, CachedPathType::Reflection);
+				if (Gfx_ShaderCompiler::LoadReflection(reflectionPath, reflection))
+				{
+					Gfx_ShaderCompiler::LoadSPIRV(cachedPath, binaries);
+					return true;
+				}
+
+				reflection = {};
+			}
 
-			Gfx_ShaderCompiler::CompileSPIRV(compileDesc, m_Binary[stage]);
+			return Gfx_ShaderCompiler::CompileSPIRV(compileDesc, binaries, reflection, &m_CompileStats[stage]);
 		};
 
+		bool compiled = true;
 		for (auto& [stage, path] : m_CreateInfo.myStages)
-			loadOrCompile(desc, stage, path);
+		{
+			if (!loadOrCompile(desc, stage, path))
+			{
+				GFX_LOG("Gfx_Shader: failed to compile " + path, Gfx_Log::Level::Error)
+				compiled = false;
+			}
+		}
+
+		// No modules are created, IsGood reports the failure
+		if (!compiled)
+		{
+			m_Binary.clear();
+			m_StageReflection.clear();
+			return;
+		}
 
-		VkDevice device = Gfx_App::GetDevice().GetLogicalDevice();
+		for (auto& [stage, reflection] : m_StageReflection)
+			m_Reflection.Merge(reflection);
 
 		bool raytracingShaders = false;
 
@@ -53,15 +155,7 @@ namespace SmolEngine
 				raytracingShaders = true;
 
 			VkShaderStageFlagBits vkStage = Gfx_VulkanHelpers::GetShaderStage(stage);
-			VkShaderModule shaderModule = nullptr;
-			{
-				VkShaderModuleCreateInfo shaderModuleCI = {};
-				shaderModuleCI.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-				shaderModuleCI.codeSize = data.size() * sizeof(uint32_t);
-				shaderModuleCI.pCode = data.data();
-
-				VK_CHECK_RESULT(vkCreateShaderModule(device, &shaderModuleCI, nullptr, &shaderModule));
-			}
+			VkShaderModule shaderModule = Gfx_RenderContext::AcquireShaderModule(data);
 
 			VkPipelineShaderStageCreateInfo pipelineShaderStageCI{};
 			{
@@ -311,14 +405,14 @@ namespace SmolEngine
 	void Gfx_Shader::DestroyModules()
 	{
 		for (auto& [key, module] : m_ShaderModules)
-			VK_DESTROY_DEVICE_HANDLE(module, vkDestroyShaderModule);
+			Gfx_RenderContext::ReleaseShaderModule(module);
 
 		m_ShaderModules.clear();
 	}
 
 	bool Gfx_Shader::IsGood() const
 	{
-		return m_CreateInfo.myStages.size() > 0;
+		return !m_ShaderModules.empty();
 	}
 
 }
\ No newline at end of file
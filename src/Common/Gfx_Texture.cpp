@@ -7,15 +7,56 @@
 #include <stb_image/stb_image.h>
 
 #include <imgui/backends/imgui_impl_vulkan.h>
+#include <gli.hpp>
+
+#include <filesystem>
 
 namespace SmolEngine
 {
+	static bool locGetFormat(gli::format format, Format& outFormat)
+	{
+		switch (format)
+		{
+		case gli::FORMAT_RGBA8_UNORM_PACK8: outFormat = Format::R8G8B8A8_UNORM; return true;
+		case gli::FORMAT_RGBA16_SFLOAT_PACK16: outFormat = Format::R16G16B16A16_SFLOAT; return true;
+		case gli::FORMAT_RGBA32_SFLOAT_PACK32: outFormat = Format::R32G32B32A32_SFLOAT; return true;
+		case gli::FORMAT_RGBA_DXT1_UNORM_BLOCK8: outFormat = Format::BC1_RGBA_UNORM; return true;
+		case gli::FORMAT_RGBA_DXT1_SRGB_BLOCK8: outFormat = Format::BC1_RGBA_SRGB; return true;
+		case gli::FORMAT_RGBA_DXT3_UNORM_BLOCK16: outFormat = Format::BC2_UNORM; return true;
+		case gli::FORMAT_RGBA_DXT3_SRGB_BLOCK16: outFormat = Format::BC2_SRGB; return true;
+		case gli::FORMAT_RGBA_DXT5_UNORM_BLOCK16: outFormat = Format::BC3_UNORM; return true;
+		case gli::FORMAT_RGBA_DXT5_SRGB_BLOCK16: outFormat = Format::BC3_SRGB; return true;
+		case gli::FORMAT_R_ATI1N_UNORM_BLOCK8: outFormat = Format::BC4_UNORM; return true;
+		case gli::FORMAT_R_ATI1N_SNORM_BLOCK8: outFormat = Format::BC4_SNORM; return true;
+		case gli::FORMAT_RG_ATI2N_UNORM_BLOCK16: outFormat = Format::BC5_UNORM; return true;
+		case gli::FORMAT_RG_ATI2N_SNORM_BLOCK16: outFormat = Format::BC5_SNORM; return true;
+		case gli::FORMAT_RGB_BP_UFLOAT_BLOCK16: outFormat = Format::BC6H_UFLOAT; return true;
+		case gli::FORMAT_RGB_BP_SFLOAT_BLOCK16: outFormat = Format::BC6H_SFLOAT; return true;
+		case gli::FORMAT_RGBA_BP_UNORM_BLOCK16: outFormat = Format::BC7_UNORM; return true;
+		case gli::FORMAT_RGBA_BP_SRGB_BLOCK16: outFormat = Format::BC7_SRGB; return true;
+		case gli::FORMAT_RGBA_ASTC_4X4_UNORM_BLOCK16: outFormat = Format::ASTC_4x4_UNORM; return true;
+		case gli::FORMAT_RGBA_ASTC_4X4_SRGB_BLOCK16: outFormat = Format::ASTC_4x4_SRGB; return true;
+		case gli::FORMAT_RGBA_ASTC_6X6_UNORM_BLOCK16: outFormat = Format::ASTC_6x6_UNORM; return true;
+		case gli::FORMAT_RGBA_ASTC_6X6_SRGB_BLOCK16: outFormat = Format::ASTC_6x6_SRGB; return true;
+		case gli::FORMAT_RGBA_ASTC_8X8_UNORM_BLOCK16: outFormat = Format::ASTC_8x8_UNORM; return true;
+		case gli::FORMAT_RGBA_ASTC_8X8_SRGB_BLOCK16: outFormat = Format::ASTC_8x8_SRGB; return true;
+		default: return false;
+		}
+	}
+
 	Gfx_Texture::Gfx_Texture()
 		:
-		m_ImguiHandle{nullptr} {}
+		m_ImguiHandle{nullptr},
+		m_BindlessIndex{s_InvalidBindlessIndex},
+		m_BindlessStorageIndex{s_InvalidBindlessIndex},
+		m_IsReady{false}
+	{
+		m_RelocationListener = Gfx_VulkanAllocator::AddRelocationListener([this](const MemoryRelocations& relocations) { OnRelocated(relocations); });
+	}
 
 	Gfx_Texture::~Gfx_Texture()
 	{
+		Gfx_VulkanAllocator::RemoveRelocationListener(m_RelocationListener);
 		Free();
 	}
 
@@ -23,23 +64,28 @@ namespace SmolEngine
 	{
 		assert(info != nullptr);
 
-		if (!info->myFilePath.empty())
+		if (IsContainerFile(info->myFilePath))
 		{
-			int height, width, channels;
+			std::vector<uint8_t> data;
+			std::vector<VkBufferImageCopy> regions;
 
-			stbi_set_flip_vertically_on_load(1);
+			const bool loaded = LoadContainer(info, data, regions);
+			GFX_ASSERT_MSG(loaded, "VulkanTexture:: Texture not found or format is not supported!")
 
-			stbi_uc* data = nullptr;
-			{
-				data = stbi_load(info->myFilePath.c_str(), &width, &height, &channels, 4);
-				GFX_ASSERT_MSG(data, "VulkanTexture:: Texture not found!")
+			CreateStorage(info);
+			Gfx_VulkanHelpers::CopyRegionsToImage(m_PixelStorage.get(), data.data(), data.size(), regions, GetFinalLayout());
+			OnResident();
+			return;
+		}
 
-				info->mySize.x = width;
-				info->mySize.y = height;
+		if (!info->myFilePath.empty())
+		{
+			stbi_set_flip_vertically_on_load(1);
 
-				LoadEX(info, data);
-			}
+			void* data = DecodeImage(info);
+			GFX_ASSERT_MSG(data, "VulkanTexture:: Texture not found!")
 
+			LoadEX(info, data);
 			stbi_image_free(data);
 			return;
 		}
@@ -49,12 +95,22 @@ namespace SmolEngine
 
 	void Gfx_Texture::Free()
 	{
-		m_PixelStorage->Free();
-
-		for (auto& [key, view] : m_ImageViewMap)
+		if (Gfx_RenderContext::s_Instance)
 		{
-			VK_DESTROY_DEVICE_HANDLE(view, vkDestroyImageView);
+			Gfx_BindlessHeap& heap = Gfx_RenderContext::GetBindlessHeap();
+			heap.Release(BindlessType::Texture, m_BindlessIndex);
+			heap.Release(BindlessType::StorageImage, m_BindlessStorageIndex);
 		}
+
+		m_BindlessIndex = s_InvalidBindlessIndex;
+		m_BindlessStorageIndex = s_InvalidBindlessIndex;
+
+		// Async textures that never became resident have no storage of their own
+		if (m_PixelStorage != nullptr)
+			m_PixelStorage->Free();
+
+		m_Placeholder = nullptr;
+		m_IsReady = false;
 	}
 
 	const VkDescriptorImageInfo& Gfx_Texture::GetDescriptorImageInfo() const
@@ -64,6 +120,8 @@ namespace SmolEngine
 
 	std::pair<uint32_t, uint32_t> Gfx_Texture::GetMipSize(uint32_t mip) const
 	{
+		mip = std::max(mip, GetFirstResidentMip());
+
 		uint32_t width = m_Desc.mySize.x;
 		uint32_t height = m_Desc.mySize.y;
 		while (mip != 0)
@@ -78,35 +136,23 @@ namespace SmolEngine
 
 	VkDescriptorImageInfo Gfx_Texture::GetMipImageView(uint32_t mip)
 	{
-		if (m_ImageViewMap.find(mip) == m_ImageViewMap.end())
-		{
-			VkImageViewCreateInfo imageViewCreateInfo = {};
-			imageViewCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
-			imageViewCreateInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
-			imageViewCreateInfo.format = Gfx_VulkanHelpers::GetFormat(m_Desc.myFormat);
-			imageViewCreateInfo.flags = 0;
-			imageViewCreateInfo.subresourceRange = {};
-			imageViewCreateInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-			imageViewCreateInfo.subresourceRange.baseMipLevel = mip;
-			imageViewCreateInfo.subresourceRange.levelCount = 1;
-			imageViewCreateInfo.subresourceRange.baseArrayLayer = 0;
-			imageViewCreateInfo.subresourceRange.layerCount = 1;
-			imageViewCreateInfo.image = m_PixelStorage->GetImage();
-
-			VkImageView pView = nullptr;
-			VK_CHECK_RESULT(vkCreateImageView(Gfx_App::GetDevice().GetLogicalDevice(), &imageViewCreateInfo, nullptr, &pView));
-			m_ImageViewMap[mip] = pView;
-		}
+		// Owned by the pixel storage, so they follow it through relocation and retirement
+		Ref<Gfx_PixelStorage> storage = GetPixelStorage();
+		const uint32_t levels = storage->GetDesc().myMipLevels;
+		const uint32_t firstResident = m_Desc.myMipLevels > levels ? m_Desc.myMipLevels - levels : 0;
 
 		VkDescriptorImageInfo imageinfo{};
 		imageinfo.imageLayout = m_DescriptorImageInfo.imageLayout;
 		imageinfo.sampler = m_DescriptorImageInfo.sampler;
-		imageinfo.imageView = m_ImageViewMap[mip];
+		imageinfo.imageView = storage->GetMipView(std::max(mip, firstResident) - firstResident);
 		return imageinfo;
 	}
 
 	Ref<Gfx_PixelStorage> Gfx_Texture::GetPixelStorage()
 	{
+		if (!m_IsReady && m_Placeholder != nullptr)
+			return m_Placeholder->GetPixelStorage();
+
 		return m_PixelStorage;
 	}
 
@@ -125,19 +171,57 @@ namespace SmolEngine
 		return m_Desc.mySize.x > 0 && m_Desc.mySize.y > 0;
 	}
 
+	bool Gfx_Texture::IsReady() const
+	{
+		return m_IsReady;
+	}
+
+	uint32_t Gfx_Texture::GetBindlessIndex() const
+	{
+		return m_BindlessIndex;
+	}
+
+	uint32_t Gfx_Texture::GetBindlessStorageIndex() const
+	{
+		return m_BindlessStorageIndex;
+	}
+
 	uint32_t Gfx_Texture::GetMips() const
 	{
 		return m_Desc.myMipLevels;
 	}
 
+	uint32_t Gfx_Texture::GetFirstResidentMip() const
+	{
+		if (m_PixelStorage == nullptr)
+			return 0;
+
+		return m_Desc.myMipLevels - m_PixelStorage->GetDesc().myMipLevels;
+	}
+
 	void Gfx_Texture::LoadEX(TextureCreateDesc* info, void* data)
+	{
+		CreateStorage(info);
+
+		if (data != nullptr)
+			Gfx_VulkanHelpers::CopyDataToImage(m_PixelStorage.get(), data, GetFinalLayout());
+		else
+			Gfx_VulkanHelpers::InitializeImageResource(m_PixelStorage.get(), GetFinalLayout());
+
+		OnResident();
+	}
+
+	void Gfx_Texture::CreateStorage(TextureCreateDesc* info)
 	{
 		GFX_ASSERT(info);
-		GFX_ASSERT(info->mySize.x > 0 && info->mySize.y > 0)
+		GFX_ASSERT((info->mySize.x > 0 && info->mySize.y > 0))
 
 		if (info->mySampler == nullptr)
 			info->mySampler = Gfx_RenderContext::GetDefaultSampler();
 
+		if (info->myAutoMips)
+			info->myMipLevels = static_cast<uint32_t>(floor(log2(std::max(info->mySize.x, info->mySize.y)))) + 1;
+
 		m_Desc = *info;
 
 		PixelStorageCreateDesc pixelDesc{};
@@ -160,28 +244,199 @@ namespace SmolEngine
 			pixelDesc.myCreateFlags = VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT;
 		}
 
+		// Lets the compute downsampler write the mip chain
+		if (info->myMipLevels > 1 && Gfx_RenderContext::GetMipGenerator().IsComputeSupported(info->myFormat, info->myArrayLayers))
+		{
+			pixelDesc.myUsageFlags |= VK_IMAGE_USAGE_STORAGE_BIT;
+		}
+
 		if (info->myIsShaderWritable)
 		{
+			GFX_ASSERT_MSG((!Gfx_Helpers::IsCompressedFormat(info->myFormat)), "VulkanTexture:: Compressed textures can't be shader writable!")
 			pixelDesc.myUsageFlags |= VK_IMAGE_USAGE_STORAGE_BIT;
 		}
 
 		m_PixelStorage = Gfx_RenderContext::CreatePixelStorage(pixelDesc);
+	}
 
-		VkImageLayout finalLayout = info->myIsShaderWritable ? VK_IMAGE_LAYOUT_GENERAL : VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-
-		if (data != nullptr)
-			Gfx_VulkanHelpers::CopyDataToImage(m_PixelStorage.get(), data, finalLayout);
-		else
-			Gfx_VulkanHelpers::InitializeImageResource(m_PixelStorage.get(), finalLayout);
+	VkImageLayout Gfx_Texture::GetFinalLayout() const
+	{
+		return m_Desc.myIsShaderWritable ? VK_IMAGE_LAYOUT_GENERAL : VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	}
 
+	void Gfx_Texture::OnResident()
+	{
 		m_DescriptorImageInfo = {};
 		m_DescriptorImageInfo.imageLayout = m_PixelStorage->GetImageLayout();
 		m_DescriptorImageInfo.imageView = m_PixelStorage->GetImageView();
-		m_DescriptorImageInfo.sampler = info->mySampler->GetSampler();
+		m_DescriptorImageInfo.sampler = m_Desc.mySampler->GetSampler();
 
-		if(info->myImGUIHandleEnable)
+		if(m_Desc.myImGUIHandleEnable)
 			m_ImguiHandle = ImGui_ImplVulkan_AddTexture(m_DescriptorImageInfo.sampler,
 				m_DescriptorImageInfo.imageView, m_DescriptorImageInfo.imageLayout);
+
+		// The bindless index handed out with the placeholder stays valid, only its slot is rewritten
+		Gfx_BindlessHeap& heap = Gfx_RenderContext::GetBindlessHeap();
+		if (m_BindlessIndex != s_InvalidBindlessIndex)
+			heap.UpdateTexture(m_BindlessIndex, m_PixelStorage.get(), m_Desc.mySampler.get());
+		else
+			m_BindlessIndex = heap.RegisterTexture(m_PixelStorage.get(), m_Desc.mySampler.get());
+
+		if (m_Desc.myIsShaderWritable)
+			m_BindlessStorageIndex = heap.RegisterStorageImage(m_PixelStorage.get());
+
+		m_Placeholder = nullptr;
+		m_IsReady = true;
+	}
+
+	void Gfx_Texture::InitPlaceholder(const Ref<Gfx_Texture>& placeholder)
+	{
+		m_Placeholder = placeholder;
+		m_DescriptorImageInfo = placeholder->GetDescriptorImageInfo();
+		m_ImguiHandle = placeholder->GetImGuiTexture();
+
+		Gfx_BindlessHeap& heap = Gfx_RenderContext::GetBindlessHeap();
+		m_BindlessIndex = heap.RegisterTexture(placeholder->m_PixelStorage.get(), placeholder->m_Desc.mySampler.get());
+	}
+
+	void Gfx_Texture::SwapStorage(const Ref<Gfx_PixelStorage>& storage)
+	{
+		m_PixelStorage = storage;
+		m_Placeholder = nullptr;
+
+		m_DescriptorImageInfo.imageLayout = storage->GetImageLayout();
+		m_DescriptorImageInfo.imageView = storage->GetImageView();
+		m_DescriptorImageInfo.sampler = m_Desc.mySampler->GetSampler();
+
+		Gfx_BindlessHeap& heap = Gfx_RenderContext::GetBindlessHeap();
+		if (m_BindlessIndex != s_InvalidBindlessIndex)
+			heap.UpdateTexture(m_BindlessIndex, storage.get(), m_Desc.mySampler.get());
+		else
+			m_BindlessIndex = heap.RegisterTexture(storage.get(), m_Desc.mySampler.get());
+
+		m_IsReady = true;
+	}
+
+	void Gfx_Texture::OnRelocated(const MemoryRelocations& relocations)
+	{
+		const VkImageView imageView = relocations.Find(m_DescriptorImageInfo.imageView);
+		if (imageView == m_DescriptorImageInfo.imageView)
+			return;
+
+		// The placeholder patches its own ImGui set, mip views were already replaced and reported by the pixel storage
+		m_DescriptorImageInfo.imageView = imageView;
+		if (m_Placeholder != nullptr)
+			return;
+
+		if (m_ImguiHandle != nullptr)
+		{
+			VkWriteDescriptorSet writeSet = {};
+			writeSet.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			writeSet.dstSet = static_cast<VkDescriptorSet>(m_ImguiHandle);
+			writeSet.dstBinding = 0;
+			writeSet.descriptorCount = 1;
+			writeSet.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+			writeSet.pImageInfo = &m_DescriptorImageInfo;
+
+			vkUpdateDescriptorSets(Gfx_App::GetDevice().GetLogicalDevice(), 1, &writeSet, 0, nullptr);
+		}
 	}
 
-}
\ No newline at end of file
+	void* Gfx_Texture::DecodeImage(TextureCreateDesc* info)
+	{
+		int width = 0, height = 0, channels = 0;
+		void* data = nullptr;
+
+		// Always decoded to four channels, HDR files keep full float precision
+		if (stbi_is_hdr(info->myFilePath.c_str()))
+		{
+			data = stbi_loadf(info->myFilePath.c_str(), &width, &height, &channels, 4);
+			info->myFormat = Format::R32G32B32A32_SFLOAT;
+		}
+		else
+		{
+			data = stbi_load(info->myFilePath.c_str(), &width, &height, &channels, 4);
+			info->myFormat = info->myFormat == Format::R8G8B8A8_SRGB ? Format::R8G8B8A8_SRGB : Format::R8G8B8A8_UNORM;
+		}
+
+		info->mySize = { static_cast<uint32_t>(width), static_cast<uint32_t>(height) };
+		return data;
+	}
+
+	bool Gfx_Texture::IsContainerFile(const std::string& filePath)
+	{
+		std::string extension = std::filesystem::path(filePath).extension().string();
+		std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+
+		return extension == ".ktx" || extension == ".dds";
+	}
+
+	bool Gfx_Texture::LoadContainer(TextureCreateDesc* info, std::vector<uint8_t>& data, std::vector<VkBufferImageCopy>& regions)
+	{
+		gli::texture texture = gli::load(info->myFilePath);
+		if (texture.empty())
+			return false;
+
+		Format format{};
+		if (!locGetFormat(texture.format(), format))
+			return false;
+
+		VkFormatProperties formatProperties{};
+		vkGetPhysicalDeviceFormatProperties(Gfx_App::GetDevice().GetPhysicalDevice(), Gfx_VulkanHelpers::GetFormat(format), &formatProperties);
+		if ((formatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT) == 0)
+			return false;
+
+		const uint32_t layers = static_cast<uint32_t>(texture.layers());
+		const uint32_t faces = static_cast<uint32_t>(texture.faces());
+		const uint32_t levels = static_cast<uint32_t>(texture.levels());
+		const gli::extent3d extent = texture.extent();
+
+		// Cube arrays have no matching view type in Gfx_PixelStorage
+		if (faces > 1 && layers > 1)
+			return false;
+
+		// Pixel storages, copies and mip generation are all 2D, a volume would lose every slice but the first
+		if (texture.target() == gli::TARGET_3D || extent.z > 1)
+		{
+			std::string message = "VulkanTexture:: 3D textures are not supported, " + info->myFilePath;
+			GFX_LOG(message, Gfx_Log::Level::Error)
+			return false;
+		}
+
+		info->myFormat = format;
+		info->mySize = { static_cast<uint32_t>(extent.x), static_cast<uint32_t>(extent.y) };
+		info->myMipLevels = levels;
+		info->myAutoMips = false;
+		info->myArrayLayers = layers * faces;
+		info->myUsage = faces == 6 ? TextureUsage::CUBEMAP : layers > 1 ? TextureUsage::ARRAY : TextureUsage::DEFAULT;
+
+		const uint8_t* base = static_cast<const uint8_t*>(texture.data());
+		data.assign(base, base + texture.size());
+
+		regions.clear();
+		for (uint32_t layer = 0; layer < layers; ++layer)
+		{
+			for (uint32_t face = 0; face < faces; ++face)
+			{
+				for (uint32_t level = 0; level < levels; ++level)
+				{
+					const gli::extent3d levelExtent = texture.extent(level);
+
+					VkBufferImageCopy region{};
+					region.bufferOffset = static_cast<const uint8_t*>(texture.data(layer, face, level)) - base;
+					region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+					region.imageSubresource.mipLevel = level;
+					region.imageSubresource.baseArrayLayer = layer * faces + face;
+					region.imageSubresource.layerCount = 1;
+					region.imageExtent.width = static_cast<uint32_t>(levelExtent.x);
+					region.imageExtent.height = static_cast<uint32_t>(levelExtent.y);
+					region.imageExtent.depth = 1;
+
+					regions.push_back(region);
+				}
+			}
+		}
+
+		return true;
+	}
+}
@@ -0,0 +1,134 @@
+#include "Gfx_Precompiled.h"
+#include "Common/Gfx_TextureCache.h"
+#include "Common/Gfx_Helpers.h"
+
+#include <filesystem>
+
+namespace SmolEngine
+{
+	static const VkDeviceSize s_TextureCacheDefaultCapacity = 512ull * 1024 * 1024;
+
+	static VkDeviceSize locGetTextureSize(Gfx_Texture* texture)
+	{
+		Ref<Gfx_PixelStorage> storage = texture->GetPixelStorage();
+		if (storage == nullptr || !texture->IsReady())
+			return 0;
+
+		const PixelStorageCreateDesc& desc = storage->GetDesc();
+
+		VkDeviceSize size = 0;
+		for (uint32_t mip = 0; mip < desc.myMipLevels; ++mip)
+			size += Gfx_Helpers::GetImageSize(desc.myFormat, { std::max(desc.mySize.x >> mip, 1u), std::max(desc.mySize.y >> mip, 1u) });
+
+		return size * desc.myArrayLayers;
+	}
+
+	Gfx_TextureCache::Gfx_TextureCache()
+		:
+		m_Capacity{s_TextureCacheDefaultCapacity} {}
+
+	Ref<Gfx_Texture> Gfx_TextureCache::Find(const TextureCreateDesc& desc)
+	{
+		const std::string key = GetKey(desc);
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		const auto& it = m_Lookup.find(key);
+		if (it == m_Lookup.end())
+			return nullptr;
+
+		m_Entries.splice(m_Entries.begin(), m_Entries, it->second);
+		return it->second->myTexture;
+	}
+
+	Ref<Gfx_Texture> Gfx_TextureCache::Insert(const TextureCreateDesc& desc, const Ref<Gfx_Texture>& texture)
+	{
+		const std::string key = GetKey(desc);
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		const auto& it = m_Lookup.find(key);
+		if (it != m_Lookup.end())
+		{
+			m_Entries.splice(m_Entries.begin(), m_Entries, it->second);
+			return it->second->myTexture;
+		}
+
+		m_Entries.push_front({ key, texture });
+		m_Lookup[key] = m_Entries.begin();
+
+		TrimLocked();
+		return texture;
+	}
+
+	void Gfx_TextureCache::SetCapacity(VkDeviceSize bytes)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		m_Capacity = bytes;
+		TrimLocked();
+	}
+
+	void Gfx_TextureCache::Trim()
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		TrimLocked();
+	}
+
+	void Gfx_TextureCache::Clear()
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		m_Lookup.clear();
+		m_Entries.clear();
+	}
+
+	VkDeviceSize Gfx_TextureCache::GetCachedBytes()
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		VkDeviceSize size = 0;
+		for (const Entry& entry : m_Entries)
+			size += locGetTextureSize(entry.myTexture.get());
+
+		return size;
+	}
+
+	std::string Gfx_TextureCache::GetKey(const TextureCreateDesc& desc)
+	{
+		std::error_code error;
+		std::filesystem::path path = std::filesystem::weakly_canonical(desc.myFilePath, error);
+		if (error)
+			path = std::filesystem::path(desc.myFilePath).lexically_normal();
+
+		// Everything that changes the created image or how it is sampled, equal samplers created separately share the entry
+		std::string key = std::format("{}|{}|{}|{}|{}|{}|{}|{}", path.generic_string(), static_cast<int>(desc.myFormat), desc.myMipLevels,
+			desc.myAutoMips, desc.myArrayLayers, static_cast<int>(desc.myUsage), desc.myIsShaderWritable, desc.myImGUIHandleEnable);
+
+		if (desc.mySampler == nullptr)
+			return key + "|default";
+
+		const SamplerCreateDesc& sampler = desc.mySampler->GetDesc();
+		return key + std::format("|{}|{}|{}|{}|{}|{}|{}|{}|{}", static_cast<int>(sampler.myMipmapMode), static_cast<int>(sampler.myFilterMode),
+			static_cast<int>(sampler.myAddressMode), static_cast<int>(sampler.myBorderColor), sampler.myLoadBias, sampler.myMaxLoad,
+			sampler.myMinLoad, sampler.myAnisotropyEnable, sampler.myCompareEnable);
+	}
+
+	void Gfx_TextureCache::TrimLocked()
+	{
+		VkDeviceSize size = 0;
+		for (const Entry& entry : m_Entries)
+			size += locGetTextureSize(entry.myTexture.get());
+
+		for (auto it = m_Entries.end(); it != m_Entries.begin() && size > m_Capacity;)
+		{
+			--it;
+
+			// Still in use outside the cache, releasing it would not free anything
+			if (it->myTexture.use_count() > 1)
+				continue;
+
+			size -= locGetTextureSize(it->myTexture.get());
+			m_Lookup.erase(it->myKey);
+			it = m_Entries.erase(it);
+		}
+	}
+}
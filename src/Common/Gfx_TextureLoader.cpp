@@ -0,0 +1,310 @@
+#include "Gfx_Precompiled.h"
+#include "Common/Gfx_TextureLoader.h"
+#include "Common/Gfx_Helpers.h"
+
+#include "Backend/Gfx_VulkanHelpers.h"
+
+#include <stb_image/stb_image.h>
+
+namespace SmolEngine
+{
+	// Upper bound of staging memory recorded into a single submit
+	static const size_t s_TextureLoaderBatchSize = 64 * 1024 * 1024;
+	// Retired batches kept for reuse, more than that are released
+	static const size_t s_TextureLoaderFreeBatches = 2;
+
+	Gfx_TextureLoader::Gfx_TextureLoader()
+		:
+		m_InFlight{0},
+		m_Exit{false} {}
+
+	void Gfx_TextureLoader::Create()
+	{
+		// Global in stb_image, set once before any worker starts decoding
+		stbi_set_flip_vertically_on_load(1);
+
+		const uint32_t workerCount = std::clamp(std::thread::hardware_concurrency() / 2, 1u, 4u);
+		for (uint32_t i = 0; i < workerCount; ++i)
+			m_Workers.emplace_back(&Gfx_TextureLoader::WorkerLoop, this);
+	}
+
+	Gfx_TextureLoader::~Gfx_TextureLoader()
+	{
+		// Workers must not outlive the loader, GPU resources are left to Free
+		StopWorkers();
+	}
+
+	void Gfx_TextureLoader::Free()
+	{
+		StopWorkers();
+		RetireBatches(true);
+
+		for (DecodeJob& job : m_Decoded)
+			stbi_image_free(job.myData);
+
+		VkDevice device = Gfx_App::GetDevice().GetLogicalDevice();
+		for (UploadBatch& batch : m_FreeBatches)
+			vkDestroyFence(device, batch.myFence, nullptr);
+
+		m_FreeBatches.clear();
+		m_Decoded.clear();
+		m_DecodeQueue.clear();
+		m_InFlight = 0;
+	}
+
+	void Gfx_TextureLoader::Enqueue(const Ref<Gfx_Texture>& texture, const TextureCreateDesc& desc)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+
+			DecodeJob job{};
+			job.myTexture = texture;
+			job.myDesc = desc;
+
+			m_DecodeQueue.push_back(std::move(job));
+			m_InFlight++;
+		}
+
+		m_Condition.notify_one();
+	}
+
+	void Gfx_TextureLoader::Update()
+	{
+		RetireBatches(false);
+		SubmitDecoded();
+	}
+
+	void Gfx_TextureLoader::Flush()
+	{
+		while (true)
+		{
+			SubmitDecoded();
+			RetireBatches(true);
+
+			// Whatever is still pending is being decoded, sleeps until a worker hands over a result
+			std::unique_lock<std::mutex> lock(m_Mutex);
+			if (m_InFlight == 0 || m_Workers.empty())
+				return;
+
+			m_DecodedCondition.wait(lock, [this]() { return m_InFlight == 0 || !m_Decoded.empty(); });
+		}
+	}
+
+	uint32_t Gfx_TextureLoader::GetPendingCount() const
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		return m_InFlight;
+	}
+
+	void Gfx_TextureLoader::WorkerLoop()
+	{
+		Gfx_CpuProfiler::SetThreadName("Texture Decode");
+
+		while (true)
+		{
+			DecodeJob job{};
+			{
+				std::unique_lock<std::mutex> lock(m_Mutex);
+				m_Condition.wait(lock, [this]() { return m_Exit || !m_DecodeQueue.empty(); });
+
+				if (m_Exit)
+					return;
+
+				job = std::move(m_DecodeQueue.front());
+				m_DecodeQueue.pop_front();
+			}
+
+			GFX_PROFILE_SCOPE("Gfx_TextureLoader::Decode")
+
+			bool loaded = false;
+			if (Gfx_Texture::IsContainerFile(job.myDesc.myFilePath))
+			{
+				loaded = Gfx_Texture::LoadContainer(&job.myDesc, job.myBlocks, job.myRegions);
+			}
+			else
+			{
+				job.myData = Gfx_Texture::DecodeImage(&job.myDesc);
+				loaded = job.myData != nullptr;
+			}
+
+			{
+				std::lock_guard<std::mutex> lock(m_Mutex);
+				if (!loaded)
+				{
+					// The texture keeps the placeholder
+					std::string message = "Gfx_TextureLoader: failed to load " + job.myDesc.myFilePath;
+					GFX_LOG(message, Gfx_Log::Level::Error)
+
+					m_InFlight--;
+				}
+				else
+				{
+					m_Decoded.push_back(std::move(job));
+				}
+			}
+
+			m_DecodedCondition.notify_all();
+		}
+	}
+
+	void Gfx_TextureLoader::StopWorkers()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_Exit = true;
+		}
+
+		m_Condition.notify_all();
+		for (std::thread& worker : m_Workers)
+			worker.join();
+
+		m_Workers.clear();
+	}
+
+	void Gfx_TextureLoader::SubmitDecoded()
+	{
+		std::vector<DecodeJob> jobs;
+		std::vector<size_t> offsets;
+		size_t stagingSize = 0;
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+
+			size_t count = 0;
+			for (; count < m_Decoded.size(); ++count)
+			{
+				const size_t size = GetDataSize(m_Decoded[count]);
+
+				// Always take at least one texture, even if it exceeds the batch size
+				if (count > 0 && stagingSize + size > s_TextureLoaderBatchSize)
+					break;
+
+				offsets.push_back(stagingSize);
+				stagingSize = (stagingSize + size + 15) & ~static_cast<size_t>(15);
+			}
+
+			jobs.assign(std::make_move_iterator(m_Decoded.begin()), std::make_move_iterator(m_Decoded.begin() + count));
+			m_Decoded.erase(m_Decoded.begin(), m_Decoded.begin() + count);
+		}
+
+		if (jobs.empty())
+			return;
+
+		UploadBatch batch = AcquireBatch(stagingSize);
+		batch.myCmd->CmdBeginRecord();
+
+		uint8_t* mapped = static_cast<uint8_t*>(batch.myStaging->MapMemory());
+		for (size_t i = 0; i < jobs.size(); ++i)
+		{
+			DecodeJob& job = jobs[i];
+			job.myTexture->CreateStorage(&job.myDesc);
+			Gfx_PixelStorage* storage = job.myTexture->m_PixelStorage.get();
+
+			if (job.myData != nullptr)
+			{
+				memcpy(mapped + offsets[i], job.myData, GetDataSize(job));
+				stbi_image_free(job.myData);
+
+				Gfx_VulkanHelpers::CmdCopyBufferToImage(batch.myCmd->GetBuffer(), storage, batch.myStaging->GetRawBuffer(),
+					offsets[i], job.myTexture->GetFinalLayout());
+			}
+			else
+			{
+				memcpy(mapped + offsets[i], job.myBlocks.data(), job.myBlocks.size());
+				for (VkBufferImageCopy& region : job.myRegions)
+					region.bufferOffset += offsets[i];
+
+				Gfx_VulkanHelpers::CmdCopyRegionsToImage(batch.myCmd->GetBuffer(), storage, batch.myStaging->GetRawBuffer(),
+					job.myRegions, job.myTexture->GetFinalLayout());
+			}
+
+			batch.myTextures.push_back(job.myTexture);
+		}
+		Gfx_VulkanAllocator::FlushMemory(batch.myStaging->GetVmaAllocation(), 0, stagingSize);
+		batch.myStaging->UnMapMemory();
+
+		batch.myCmd->CmdEndRecord();
+
+		Gfx_VulkanHelpers::SubmitCmdBuffer(batch.myCmd.get(), batch.myFence);
+		m_Batches.push_back(std::move(batch));
+	}
+
+	size_t Gfx_TextureLoader::GetDataSize(const DecodeJob& job)
+	{
+		if (job.myData == nullptr)
+			return job.myBlocks.size();
+
+		return Gfx_Helpers::GetImageSize(job.myDesc.myFormat, job.myDesc.mySize);
+	}
+
+	void Gfx_TextureLoader::RetireBatches(bool wait)
+	{
+		VkDevice device = Gfx_App::GetDevice().GetLogicalDevice();
+
+		std::erase_if(m_Batches, [&](UploadBatch& batch)
+		{
+			if (wait)
+			{
+				GFX_PROFILE_SCOPE("Gfx_TextureLoader::WaitForFence")
+				VK_CHECK_RESULT(vkWaitForFences(device, 1, &batch.myFence, VK_TRUE, UINT64_MAX));
+			}
+
+			if (vkGetFenceStatus(device, batch.myFence) != VK_SUCCESS)
+				return false;
+
+			for (const Ref<Gfx_Texture>& texture : batch.myTextures)
+				texture->OnResident();
+
+			{
+				std::lock_guard<std::mutex> lock(m_Mutex);
+				m_InFlight -= static_cast<uint32_t>(batch.myTextures.size());
+			}
+
+			batch.myTextures.clear();
+			if (m_FreeBatches.size() < s_TextureLoaderFreeBatches)
+				m_FreeBatches.push_back(std::move(batch));
+			else
+				vkDestroyFence(device, batch.myFence, nullptr);
+
+			return true;
+		});
+	}
+
+	Gfx_TextureLoader::UploadBatch Gfx_TextureLoader::AcquireBatch(size_t stagingSize)
+	{
+		VkDevice device = Gfx_App::GetDevice().GetLogicalDevice();
+
+		UploadBatch batch{};
+		if (!m_FreeBatches.empty())
+		{
+			batch = std::move(m_FreeBatches.back());
+			m_FreeBatches.pop_back();
+
+			VK_CHECK_RESULT(vkResetFences(device, 1, &batch.myFence));
+			batch.myCmd->Reset();
+		}
+		else
+		{
+			batch.myCmd = std::make_shared<Gfx_CmdBuffer>();
+			CmdBufferCreateDesc cmdDesc{};
+			batch.myCmd->Create(&cmdDesc);
+
+			VkFenceCreateInfo fenceCI = {};
+			fenceCI.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+			VK_CHECK_RESULT(vkCreateFence(device, &fenceCI, nullptr, &batch.myFence));
+		}
+
+		// Kept across batches, so it lives in the default pool instead of the transient ring
+		if (batch.myStaging == nullptr || batch.myStaging->GetSize() < stagingSize)
+		{
+			BufferCreateDesc stagingDesc{};
+			stagingDesc.mySize = stagingSize;
+			stagingDesc.myBufferUsage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+			stagingDesc.myMemUsage = VMA_MEMORY_USAGE_CPU_TO_GPU;
+
+			batch.myStaging = std::make_shared<Gfx_Buffer>();
+			batch.myStaging->Create(stagingDesc);
+		}
+
+		return batch;
+	}
+}
@@ -0,0 +1,423 @@
+#include "Gfx_Precompiled.h"
+#include "Common/Gfx_TextureStreamer.h"
+#include "Common/Gfx_Helpers.h"
+
+#include "Backend/Gfx_VulkanHelpers.h"
+#include "Gfx_RenderContext.h"
+
+namespace SmolEngine
+{
+	// Levels up to this size are always resident
+	static const uint32_t s_StreamTailSize = 64;
+	// A texture nobody sampled for this long falls back to its tail
+	static const uint64_t s_StreamIdleFrames = 240;
+	static const VkDeviceSize s_StreamUploadBytesPerFrame = 32 * 1024 * 1024;
+	// Share of the VMA budget streaming may grow into
+	static const double s_StreamBudgetScale = 0.9;
+
+	Gfx_TextureStreamer::Gfx_TextureStreamer()
+		:
+		m_Budget{0},
+		m_ResidentBytes{0},
+		m_FrameIndex{0},
+		m_FrameCount{0} {}
+
+	void Gfx_TextureStreamer::Create(uint32_t framesInFlight)
+	{
+		Gfx_BindlessHeap& heap = Gfx_RenderContext::GetBindlessHeap();
+		if (!heap.IsGood())
+			return;
+
+		// One per frame in flight, the CPU reads a buffer only once its frame has finished
+		const uint32_t capacity = heap.GetCapacity(BindlessType::Texture);
+		std::vector<uint32_t> cleared(capacity, UINT32_MAX);
+
+		for (uint32_t i = 0; i < framesInFlight; ++i)
+		{
+			BufferCreateDesc bufferDesc{};
+			bufferDesc.mySize = capacity * sizeof(uint32_t);
+			bufferDesc.myBufferUsage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+			bufferDesc.myMemUsage = VMA_MEMORY_USAGE_GPU_TO_CPU;
+
+			Ref<Gfx_Buffer> buffer = std::make_shared<Gfx_Buffer>();
+			buffer->Create(bufferDesc);
+			buffer->SetData(cleared.data(), bufferDesc.mySize);
+
+			m_FeedbackBuffers.push_back(buffer);
+		}
+	}
+
+	void Gfx_TextureStreamer::Free()
+	{
+		SubmitUploads();
+		RetireUploads(true);
+
+		m_FeedbackBuffers.clear();
+		m_Textures.clear();
+		m_Retired.clear();
+		m_ResidentBytes = 0;
+	}
+
+	void Gfx_TextureStreamer::BeginFrame(uint32_t frameIndex)
+	{
+		m_FrameIndex = frameIndex;
+		m_FrameCount++;
+
+		const uint64_t framesInFlight = Gfx_App::GetFramesInFlight();
+		std::erase_if(m_Retired, [&](const RetiredStorage& retired)
+		{
+			return m_FrameCount - retired.myFrame > framesInFlight;
+		});
+
+		std::erase_if(m_Textures, [&](const StreamedTexture& entry)
+		{
+			if (!entry.myTexture.expired())
+				return false;
+
+			m_ResidentBytes -= GetLevelsSize(entry, entry.myResidentMip);
+			return true;
+		});
+
+		RetireUploads(false);
+
+		if (!m_Textures.empty())
+		{
+			ReadFeedback();
+			UpdateResidency();
+		}
+
+		SubmitUploads();
+	}
+
+	void Gfx_TextureStreamer::UpdateResidency()
+	{
+		// Textures waiting for an upload keep their levels until it has finished
+		std::vector<StreamedTexture*> textures;
+		textures.reserve(m_Textures.size());
+		for (StreamedTexture& entry : m_Textures)
+		{
+			if (!entry.myIsUploading)
+				textures.push_back(&entry);
+		}
+
+		// Under pressure the least needed levels go first: textures holding more than they asked for,
+		// then those asking for the coarsest levels
+		int64_t headroom = GetHeadroom();
+		if (headroom < 0)
+		{
+			std::sort(textures.begin(), textures.end(), [](const StreamedTexture* a, const StreamedTexture* b)
+			{
+				const bool aOver = a->myResidentMip < a->myRequestedMip;
+				const bool bOver = b->myResidentMip < b->myRequestedMip;
+				if (aOver != bOver)
+					return aOver;
+
+				return a->myRequestedMip > b->myRequestedMip;
+			});
+
+			for (StreamedTexture* entry : textures)
+			{
+				if (headroom >= 0)
+					break;
+
+				if (entry->myResidentMip >= entry->myTailMip)
+					continue;
+
+				const uint32_t mip = entry->myResidentMip + 1;
+				headroom += static_cast<int64_t>(GetLevelsSize(*entry, entry->myResidentMip) - GetLevelsSize(*entry, mip));
+				SetResidentMip(*entry, mip);
+			}
+
+			return;
+		}
+
+		// Largest gap between requested and resident first, one level per texture and frame
+		std::sort(textures.begin(), textures.end(), [](const StreamedTexture* a, const StreamedTexture* b)
+		{
+			return static_cast<int32_t>(a->myResidentMip - a->myRequestedMip) > static_cast<int32_t>(b->myResidentMip - b->myRequestedMip);
+		});
+
+		VkDeviceSize uploaded = 0;
+		for (StreamedTexture* entry : textures)
+		{
+			if (entry->myRequestedMip > entry->myResidentMip)
+			{
+				// Extra levels are kept as a cache until the texture goes idle
+				if (m_FrameCount - entry->myLastRequestFrame > s_StreamIdleFrames)
+					SetResidentMip(*entry, entry->myResidentMip + 1);
+
+				continue;
+			}
+
+			if (entry->myRequestedMip == entry->myResidentMip)
+				continue;
+
+			const VkDeviceSize size = GetLevelsSize(*entry, entry->myResidentMip - 1);
+			const VkDeviceSize growth = size - GetLevelsSize(*entry, entry->myResidentMip);
+			if (static_cast<int64_t>(growth) > headroom || uploaded + size > s_StreamUploadBytesPerFrame)
+				break;
+
+			SetResidentMip(*entry, entry->myResidentMip - 1);
+			headroom -= static_cast<int64_t>(growth);
+			uploaded += size;
+		}
+	}
+
+	Ref<Gfx_Texture> Gfx_TextureStreamer::Load(const std::string& filePath, const Ref<Gfx_Sampler>& sampler)
+	{
+		StreamedTexture entry{};
+		entry.myDesc.myFilePath = filePath;
+		entry.myDesc.mySampler = sampler != nullptr ? sampler : Gfx_RenderContext::GetDefaultSampler();
+
+		if (!Gfx_Texture::LoadContainer(&entry.myDesc, entry.myData, entry.myRegions))
+		{
+			std::string message = "Gfx_TextureStreamer: failed to load " + filePath;
+			GFX_LOG(message, Gfx_Log::Level::Error)
+			return nullptr;
+		}
+
+		const TextureCreateDesc& desc = entry.myDesc;
+		while (entry.myTailMip + 1 < desc.myMipLevels && std::max(desc.mySize.x, desc.mySize.y) >> entry.myTailMip > s_StreamTailSize)
+			entry.myTailMip++;
+
+		Ref<Gfx_Texture> texture = std::make_shared<Gfx_Texture>();
+		texture->m_Desc = desc;
+
+		entry.myTexture = texture;
+		entry.myResidentMip = desc.myMipLevels;
+		entry.myRequestedMip = entry.myTailMip;
+		entry.myLastRequestFrame = m_FrameCount;
+
+		// The tail is small and waited for here, so descriptors written with the texture never see a missing image
+		StreamedTexture& added = m_Textures.emplace_back(std::move(entry));
+		SetResidentMip(added, added.myTailMip);
+		SubmitUploads();
+		RetireUploads(true);
+		return texture;
+	}
+
+	void Gfx_TextureStreamer::SetBudget(VkDeviceSize bytes)
+	{
+		m_Budget = bytes;
+	}
+
+	uint32_t Gfx_TextureStreamer::GetFeedbackIndex() const
+	{
+		if (m_FeedbackBuffers.empty())
+			return s_InvalidBindlessIndex;
+
+		return m_FeedbackBuffers[m_FrameIndex]->GetBindlessIndex();
+	}
+
+	VkDeviceSize Gfx_TextureStreamer::GetResidentBytes() const
+	{
+		return m_ResidentBytes;
+	}
+
+	uint32_t Gfx_TextureStreamer::GetRequestedMip(uint32_t residentMip, uint32_t feedback, uint32_t tailMip)
+	{
+		// Written against the levels resident at the time, the chain is counted from the resident mip
+		const int64_t mip = static_cast<int64_t>(residentMip) + feedback - s_StreamerLodBias;
+		return static_cast<uint32_t>(std::clamp<int64_t>(mip, 0, tailMip));
+	}
+
+	void Gfx_TextureStreamer::ReadFeedback()
+	{
+		if (m_FeedbackBuffers.empty())
+		{
+			for (StreamedTexture& entry : m_Textures)
+			{
+				entry.myRequestedMip = 0;
+				entry.myLastRequestFrame = m_FrameCount;
+			}
+
+			return;
+		}
+
+		Gfx_Buffer* buffer = m_FeedbackBuffers[m_FrameIndex].get();
+		uint32_t* feedback = static_cast<uint32_t*>(buffer->MapMemory());
+		const size_t capacity = buffer->GetSize() / sizeof(uint32_t);
+
+		// GPU_TO_CPU memory is not always host coherent
+		Gfx_VulkanAllocator::InvalidateMemory(buffer->GetVmaAllocation());
+
+		for (StreamedTexture& entry : m_Textures)
+		{
+			const uint32_t index = entry.myTexture.lock()->GetBindlessIndex();
+			if (index >= capacity || feedback[index] == UINT32_MAX)
+				continue;
+
+			entry.myRequestedMip = GetRequestedMip(entry.myResidentMip, feedback[index], entry.myTailMip);
+			entry.myLastRequestFrame = m_FrameCount;
+			feedback[index] = UINT32_MAX;
+		}
+
+		Gfx_VulkanAllocator::FlushMemory(buffer->GetVmaAllocation());
+		buffer->UnMapMemory();
+
+		for (StreamedTexture& entry : m_Textures)
+		{
+			if (m_FrameCount - entry.myLastRequestFrame > s_StreamIdleFrames)
+				entry.myRequestedMip = entry.myTailMip;
+		}
+	}
+
+	void Gfx_TextureStreamer::SetResidentMip(StreamedTexture& entry, uint32_t mip)
+	{
+		const TextureCreateDesc& desc = entry.myDesc;
+
+		PixelStorageCreateDesc pixelDesc{};
+		pixelDesc.mySize = { std::max(desc.mySize.x >> mip, 1u), std::max(desc.mySize.y >> mip, 1u) };
+		pixelDesc.myMipLevels = desc.myMipLevels - mip;
+		pixelDesc.myArrayLayers = desc.myArrayLayers;
+		pixelDesc.myFormat = desc.myFormat;
+		pixelDesc.myUsageFlags = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+		pixelDesc.myCreateFlags = desc.myUsage == TextureUsage::CUBEMAP ? VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT : 0;
+
+		PendingUpload upload{};
+		upload.myTexture = entry.myTexture;
+		upload.myStorage = Gfx_RenderContext::CreatePixelStorage(pixelDesc);
+		upload.myMip = mip;
+
+		// Packs the levels from mip on into the frame's staging data, rebased to the new image
+		for (const VkBufferImageCopy& region : entry.myRegions)
+		{
+			if (region.imageSubresource.mipLevel < mip)
+				continue;
+
+			const size_t size = Gfx_Helpers::GetImageSize(desc.myFormat, { region.imageExtent.width, region.imageExtent.height });
+			const size_t offset = (m_StagingData.size() + 15) & ~static_cast<size_t>(15);
+
+			VkBufferImageCopy& rebased = upload.myRegions.emplace_back(region);
+			rebased.bufferOffset = offset;
+			rebased.imageSubresource.mipLevel -= mip;
+
+			m_StagingData.resize(offset);
+			m_StagingData.insert(m_StagingData.end(), entry.myData.begin() + region.bufferOffset, entry.myData.begin() + region.bufferOffset + size);
+		}
+
+		entry.myIsUploading = true;
+		m_Uploads.push_back(std::move(upload));
+	}
+
+	void Gfx_TextureStreamer::SubmitUploads()
+	{
+		if (m_Uploads.empty())
+			return;
+
+		UploadBatch batch{};
+
+		BufferCreateDesc stagingDesc{};
+		stagingDesc.myData = m_StagingData.data();
+		stagingDesc.mySize = m_StagingData.size();
+		stagingDesc.myFlags = BufferCreateDesc::CreateFlags::Staging;
+		stagingDesc.myPool = MemoryPool::Transient;
+
+		batch.myStaging = std::make_shared<Gfx_Buffer>();
+		batch.myStaging->Create(stagingDesc);
+
+		batch.myCmd = std::make_shared<Gfx_CmdBuffer>();
+		CmdBufferCreateDesc cmdDesc{};
+		batch.myCmd->Create(&cmdDesc);
+		batch.myCmd->CmdBeginRecord();
+
+		for (const PendingUpload& upload : m_Uploads)
+		{
+			Gfx_VulkanHelpers::CmdCopyRegionsToImage(batch.myCmd->GetBuffer(), upload.myStorage.get(), batch.myStaging->GetRawBuffer(),
+				upload.myRegions, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+		}
+
+		batch.myCmd->CmdEndRecord();
+
+		VkFenceCreateInfo fenceCI = {};
+		fenceCI.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+		VK_CHECK_RESULT(vkCreateFence(Gfx_App::GetDevice().GetLogicalDevice(), &fenceCI, nullptr, &batch.myFence));
+
+		Gfx_VulkanHelpers::SubmitCmdBuffer(batch.myCmd.get(), batch.myFence);
+
+		batch.myUploads = std::move(m_Uploads);
+		m_Batches.push_back(std::move(batch));
+
+		m_Uploads.clear();
+		m_StagingData.clear();
+	}
+
+	void Gfx_TextureStreamer::RetireUploads(bool wait)
+	{
+		VkDevice device = Gfx_App::GetDevice().GetLogicalDevice();
+		MemoryRelocations relocations;
+
+		std::erase_if(m_Batches, [&](UploadBatch& batch)
+		{
+			if (wait)
+			{
+				GFX_PROFILE_SCOPE("Gfx_TextureStreamer::WaitForFence")
+				VK_CHECK_RESULT(vkWaitForFences(device, 1, &batch.myFence, VK_TRUE, UINT64_MAX));
+			}
+
+			if (vkGetFenceStatus(device, batch.myFence) != VK_SUCCESS)
+				return false;
+
+			vkDestroyFence(device, batch.myFence, nullptr);
+
+			for (PendingUpload& upload : batch.myUploads)
+			{
+				// A texture released meanwhile drops its entry and the new storage with it
+				Ref<Gfx_Texture> texture = upload.myTexture.lock();
+				if (texture == nullptr)
+					continue;
+
+				auto it = std::find_if(m_Textures.begin(), m_Textures.end(), [&](const StreamedTexture& entry) { return entry.myTexture.lock() == texture; });
+				if (it == m_Textures.end())
+					continue;
+
+				StreamedTexture& entry = *it;
+
+				RetiredStorage retired{};
+				retired.myStorage = texture->m_PixelStorage;
+				retired.myFrame = m_FrameCount;
+				texture->SwapStorage(upload.myStorage);
+
+				// Bindless slots were rewritten by the swap, regular sets still hold the old view
+				if (retired.myStorage != nullptr)
+				{
+					relocations.Add(retired.myStorage->GetImageView(), upload.myStorage->GetImageView());
+					m_ResidentBytes -= GetLevelsSize(entry, entry.myResidentMip);
+					m_Retired.push_back(std::move(retired));
+				}
+
+				entry.myResidentMip = upload.myMip;
+				entry.myIsUploading = false;
+				m_ResidentBytes += GetLevelsSize(entry, upload.myMip);
+			}
+
+			return true;
+		});
+
+		if (!relocations.IsEmpty())
+			Gfx_Descriptor::OnRelocated(relocations);
+	}
+
+	VkDeviceSize Gfx_TextureStreamer::GetLevelsSize(const StreamedTexture& entry, uint32_t firstMip) const
+	{
+		VkDeviceSize size = 0;
+		for (const VkBufferImageCopy& region : entry.myRegions)
+		{
+			if (region.imageSubresource.mipLevel >= firstMip)
+				size += Gfx_Helpers::GetImageSize(entry.myDesc.myFormat, { region.imageExtent.width, region.imageExtent.height });
+		}
+
+		return size;
+	}
+
+	int64_t Gfx_TextureStreamer::GetHeadroom() const
+	{
+		if (m_Budget > 0)
+			return static_cast<int64_t>(m_Budget) - static_cast<int64_t>(m_ResidentBytes);
+
+		VkDeviceSize usage = 0, budget = 0;
+		Gfx_VulkanAllocator::GetDeviceLocalBudget(usage, budget);
+
+		return static_cast<int64_t>(budget * s_StreamBudgetScale) - static_cast<int64_t>(usage);
+	}
+}
@@ -1,6 +1,8 @@
 #include "Gfx_Precompiled.h"
 #include "Common/Gfx_VertexBuffer.h"
 
+#include "Gfx_RenderContext.h"
+
 namespace SmolEngine
 {
 	static VkBufferUsageFlags locGetIndexBufferUsageFlags()
@@ -29,8 +31,13 @@ namespace SmolEngine
 		desc.myData = vertices;
 		desc.mySize = size;
 		desc.myFlags = isStatic ? BufferCreateDesc::CreateFlags::Static : BufferCreateDesc::CreateFlags::Default;
+		desc.myPool = isStatic ? MemoryPool::Geometry : MemoryPool::Default;
 		desc.myBufferUsage = flags;
 
+		// Static buffers share the geometry arena, larger ones fall back to their own allocation
+		if (isStatic && Gfx_RenderContext::s_Instance)
+			desc.myArena = &Gfx_RenderContext::GetGeometryArena();
+
 		m_Buffer.Create(desc);
 		m_VertexCount = vertexCount;
 
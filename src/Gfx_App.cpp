@@ -13,6 +13,8 @@
 namespace SmolEngine
 {
 	Gfx_App* Gfx_App::s_Instance = nullptr;
+	// Every headless frame is waited for in SwapBuffers, two slots keep per frame rings double buffered
+	static const uint32_t s_HeadlessFramesInFlight = 2;
 
 	Gfx_App::Gfx_App()
 	{
@@ -21,6 +23,10 @@ namespace SmolEngine
 
 	Gfx_App::~Gfx_App()
 	{
+		// The render context frees its resources through GetDevice, so it goes before the instance is cleared
+		m_Framebuffer = nullptr;
+		m_RenderContext = nullptr;
+
 		s_Instance = nullptr;
 
 		Shutdown();
@@ -29,17 +35,35 @@ namespace SmolEngine
 	void Gfx_App::Create(GfxContextCreateDesc* desc)
 	{
 		assert(desc != nullptr);
-		assert(desc->myWindowDesc != nullptr);
+		assert(desc->myIsHeadless || desc->myWindowDesc != nullptr);
+
+		GFX_PROFILE_SCOPE("Gfx_App::Create")
+		Gfx_CpuProfiler::SetThreadName("Main");
 
 		m_Desc = *desc;
 		m_Root = desc->myAssetPath;
+		m_StartTime = std::chrono::steady_clock::now();
 		m_EventHandler.OnEventFn = std::bind(&Gfx_App::OnEvent, this, std::placeholders::_1);
 
-		WindowCreateDesc* winDesc = desc->myWindowDesc;
+		glm::uvec2 size = desc->myHeadlessSize;
+		bool isTargetsSwapchain = false;
+
+		if (desc->myIsHeadless)
+		{
+			// Nothing to present ImGui to
+			m_Desc.myFeaturesFlags &= ~FeaturesFlags::ImguiEnable;
+		}
+		else
+		{
+			WindowCreateDesc* winDesc = desc->myWindowDesc;
+
+			m_Window = std::make_shared<Gfx_Window>();
+			desc->myWindowDesc->myEventHandler = &m_EventHandler;
+			m_Window->Create(winDesc);
 
-		m_Window = std::make_shared<Gfx_Window>();
-		desc->myWindowDesc->myEventHandler = &m_EventHandler;
-		m_Window->Create(winDesc);
+			size = { winDesc->myWidth, winDesc->myHeight };
+			isTargetsSwapchain = winDesc->myTargetsSwapchain;
+		}
 
 		CreateAPIContext();
 
@@ -50,11 +74,11 @@ namespace SmolEngine
 		{
 			FramebufferCreateDesc fbDesc = {};
 			fbDesc.mySampler = m_RenderContext->GetDefaultSampler();
-			fbDesc.mySize = { winDesc->myWidth, winDesc->myHeight };
-			fbDesc.myIsTargetsSwapchain = winDesc->myTargetsSwapchain;
-			fbDesc.myIsUsedByImGui = winDesc->myTargetsSwapchain ? false : true;
+			fbDesc.mySize = size;
+			fbDesc.myIsTargetsSwapchain = isTargetsSwapchain;
+			fbDesc.myIsUsedByImGui = !isTargetsSwapchain && !desc->myIsHeadless;
 
-			Format colorFormat = winDesc->myTargetsSwapchain ? Format::B8G8R8A8_UNORM : Format::R8G8B8A8_UNORM;
+			Format colorFormat = isTargetsSwapchain ? Format::B8G8R8A8_UNORM : Format::R8G8B8A8_UNORM;
 
 			FramebufferAttachment colorAttachment = FramebufferAttachment(colorFormat, glm::vec4(0), "COLOR_0");
 			FramebufferAttachment depthAttachment = FramebufferAttachment(Format::D32_SFLOAT_S8_UINT, glm::vec4(1), "Depth_0");
@@ -68,6 +92,17 @@ namespace SmolEngine
 
 	void Gfx_App::SwapBuffers()
 	{
+		GFX_PROFILE_SCOPE("Gfx_App::SwapBuffers")
+
+		// Textures released during the frame are only dropped from the cache by the next Insert otherwise
+		Gfx_RenderContext::GetTextureCache().Trim();
+
+		if (m_Desc.myIsHeadless) [[unlikely]]
+		{
+			SubmitHeadless();
+			return;
+		}
+
 		// ImGUI pass
 		if ((m_Desc.myFeaturesFlags
 			& FeaturesFlags::ImguiEnable) == FeaturesFlags::ImguiEnable) [[unlikely]]
@@ -79,8 +114,12 @@ namespace SmolEngine
 		const auto& present_ref = m_Semaphore.GetPresentCompleteSemaphore();
 		const auto& render_ref = m_Semaphore.GetRenderCompleteSemaphore();
 
-		VK_CHECK_RESULT(vkWaitForFences(m_Device.GetLogicalDevice(), 1,
-			&m_Semaphore.GetVkFences()[m_Swapchain.GetCurrentBufferIndex()], VK_TRUE, UINT64_MAX));
+		{
+			GFX_PROFILE_SCOPE("Gfx_App::WaitForFence")
+			VK_CHECK_RESULT(vkWaitForFences(m_Device.GetLogicalDevice(), 1,
+				&m_Semaphore.GetVkFences()[m_Swapchain.GetCurrentBufferIndex()], VK_TRUE, UINT64_MAX));
+		}
+
 		VK_CHECK_RESULT(vkResetFences(m_Device.GetLogicalDevice(), 1, 
 			&m_Semaphore.GetVkFences()[m_Swapchain.GetCurrentBufferIndex()]));
 
@@ -121,6 +160,7 @@ namespace SmolEngine
 				}
 			}
 
+			GFX_PROFILE_SCOPE("Gfx_App::WaitForFence")
 			VkResult result = (vkWaitForFences(m_Device.GetLogicalDevice(),
 				1, &m_Semaphore.GetVkFences()[m_Swapchain.GetCurrentBufferIndex()], VK_TRUE, UINT64_MAX));
 #ifdef  SMOLENGINE_DEBUG
@@ -137,23 +177,77 @@ namespace SmolEngine
 		m_CmdBuffer.Free();
 	}
 
+	void Gfx_App::SubmitHeadless()
+	{
+		VkDevice device = m_Device.GetLogicalDevice();
+		VkFence fence = m_Semaphore.GetVkFences()[m_FrameIndex];
+
+		{
+			GFX_PROFILE_SCOPE("Gfx_App::WaitForFence")
+			VK_CHECK_RESULT(vkWaitForFences(device, 1, &fence, VK_TRUE, UINT64_MAX));
+		}
+
+		VK_CHECK_RESULT(vkResetFences(device, 1, &fence));
+
+		m_CmdBuffer.CmdEndRecord();
+		m_CmdBuffer.m_State = Gfx_CmdBuffer::State::Wait;
+
+		VkSubmitInfo submitInfo = {};
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.pCommandBuffers = &m_CmdBuffer.m_Buffer;
+		submitInfo.commandBufferCount = 1;
+
+		VK_CHECK_RESULT(vkQueueSubmit(m_Device.GetQueue(Gfx_VulkanDevice::QueueFamilyFlags::Graphics), 1, &submitInfo, fence));
+
+		// The frame command buffer is released right away, same as after a present
+		{
+			GFX_PROFILE_SCOPE("Gfx_App::WaitForFence")
+			VK_CHECK_RESULT(vkWaitForFences(device, 1, &fence, VK_TRUE, UINT64_MAX));
+		}
+
+		m_CmdBuffer.Free();
+	}
+
 	void Gfx_App::ProcessEvents()
 	{
-		m_Window->ProcessEvents();
+		if (m_Window != nullptr)
+			m_Window->ProcessEvents();
 	}
 
 	void Gfx_App::BeginFrame(float time)
 	{
+		GFX_PROFILE_SCOPE("Gfx_App::BeginFrame")
+
 		m_DeltaTime = time;
 
 		if ((m_Desc.myFeaturesFlags
 			& FeaturesFlags::ImguiEnable) == FeaturesFlags::ImguiEnable) [[unlikely]] { m_ImGuiContext->NewFrame(); }
 
-		VK_CHECK_RESULT(m_Swapchain.AcquireNextImage(m_Semaphore.GetPresentCompleteSemaphore()));
+		// Per-frame rings are sized by GetFramesInFlight, the acquired image index may skip or repeat slots
+		m_FrameIndex = (m_FrameIndex + 1) % GetFramesInFlight();
+
+		if (!m_Desc.myIsHeadless) [[likely]]
+		{
+			GFX_PROFILE_SCOPE("Gfx_App::AcquireNextImage")
+			VK_CHECK_RESULT(m_Swapchain.AcquireNextImage(m_Semaphore.GetPresentCompleteSemaphore()));
+		}
+
+		// Sets of this frame index were consumed by an already signaled submit
+		Gfx_RenderContext::GetDescriptorAllocator().BeginFrame(GetFrameIndex());
+		Gfx_RenderContext::GetDescriptorBuffer().BeginFrame(GetFrameIndex());
+		Gfx_RenderContext::GetBindlessHeap().BeginFrame();
+		Gfx_RenderContext::GetTextureLoader().Update();
+		Gfx_RenderContext::GetTextureStreamer().BeginFrame(GetFrameIndex());
+		Gfx_RenderContext::GetReadbackQueue().BeginFrame(GetFrameIndex());
+		Gfx_RenderContext::GetGpuProfiler().BeginFrame(GetFrameIndex());
+		Gfx_RenderContext::GetQueryManager().BeginFrame(GetFrameIndex());
 
 		CmdBufferCreateDesc cmdDesc{};
 		m_CmdBuffer.Create(&cmdDesc);
 		m_CmdBuffer.CmdBeginRecord();
+
+		Gfx_RenderContext::GetGpuProfiler().CmdReset(&m_CmdBuffer);
+		Gfx_RenderContext::GetQueryManager().CmdReset(&m_CmdBuffer);
 	}
 
 	void Gfx_App::Shutdown()
@@ -161,11 +255,18 @@ namespace SmolEngine
 		if ((m_Desc.myFeaturesFlags
 			& FeaturesFlags::ImguiEnable) == FeaturesFlags::ImguiEnable) [[unlikely]] { m_ImGuiContext->ShutDown(); }
 
-		m_Window->ShutDown();
+		if (m_Window != nullptr)
+			m_Window->ShutDown();
     }
 
 	void Gfx_App::Resize(uint32_t* width, uint32_t* height)
 	{
+		if (m_Desc.myIsHeadless)
+		{
+			SetFramebufferSize(*width, *height);
+			return;
+		}
+
 		const WindowCreateDesc& winDesc = m_Window->GetCreateDesc();
 
 		m_Swapchain.OnResize(width, height, winDesc.myVSync, &m_CmdBuffer);
@@ -188,7 +289,7 @@ namespace SmolEngine
 
 	float Gfx_App::CalculateDeltaTime()
 	{
-		float time = (float)glfwGetTime();
+		float time = GetTime();
 		float deltaTime = time - m_LastFrameTime;
 		m_LastFrameTime = time;
 		return deltaTime;
@@ -211,11 +312,23 @@ namespace SmolEngine
 
 	glm::vec2 Gfx_App::GetWindowSize() const
 	{
+		if (m_Window == nullptr)
+			return glm::vec2(m_Framebuffer->GetSize());
+
 		return glm::vec2(m_Window->GetWidth(), m_Window->GetHeight());
 	}
 
 	float Gfx_App::GetGltfTime() const
 	{
+		return GetTime();
+	}
+
+	float Gfx_App::GetTime() const
+	{
+		// GLFW is never initialized without a window
+		if (m_Desc.myIsHeadless)
+			return std::chrono::duration<float>(std::chrono::steady_clock::now() - m_StartTime).count();
+
 		return (float)glfwGetTime();
 	}
 
@@ -231,20 +344,30 @@ namespace SmolEngine
 
 	void Gfx_App::CreateAPIContext()
 	{
-		GFX_ASSERT(glfwVulkanSupported() == GLFW_TRUE)
+		const bool isHeadless = m_Desc.myIsHeadless;
+		if (!isHeadless)
+		{
+			GFX_ASSERT(glfwVulkanSupported() == GLFW_TRUE)
+		}
 
-		m_Instance.Create();
+		m_Instance.Create(isHeadless);
 
 #ifdef AFTERMATH
 		// Enable Nsight Aftermath GPU crash dump creation.
 		// This needs to be done before the Vulkan device is created.
 		m_CrachTracker.Initialize();
 #endif
-		m_Device.Create(&m_Instance);
+		m_Device.Create(&m_Instance, isHeadless);
 
 		m_Allocator = new Gfx_VulkanAllocator();
 		m_Allocator->Init(&m_Device, &m_Instance);
 
+		if (isHeadless)
+		{
+			m_Semaphore.Create(&m_Device, s_HeadlessFramesInFlight);
+			return;
+		}
+
 		const WindowCreateDesc& winDesc = m_Window->GetCreateDesc();
 
 		m_Swapchain.Init(&m_Instance, &m_Device, GetWindow()->GetNativeWindow(), !winDesc.myTargetsSwapchain);
@@ -253,7 +376,7 @@ namespace SmolEngine
 		uint32_t* height = &m_Window->GetData()->myHeight;
 
 		m_Swapchain.Create(width, height, winDesc.myVSync);
-		m_Semaphore.Create(&m_Device);
+		m_Semaphore.Create(&m_Device, m_Swapchain.GetImageCount());
 		m_Swapchain.Prepare(*width, *height);
 
 		// Initialize ImGUI
@@ -307,6 +430,21 @@ namespace SmolEngine
 		return &Gfx_App::s_Instance->m_CmdBuffer;
 	}
 
+	uint32_t Gfx_App::GetFrameIndex()
+	{
+		return Gfx_App::s_Instance->m_FrameIndex;
+	}
+
+	uint32_t Gfx_App::GetFramesInFlight()
+	{
+		return static_cast<uint32_t>(Gfx_App::s_Instance->m_Semaphore.GetVkFences().size());
+	}
+
+	bool Gfx_App::IsHeadless()
+	{
+		return Gfx_App::s_Instance->m_Desc.myIsHeadless;
+	}
+
 	Gfx_VulkanSwapchain& Gfx_App::GetSwapchain()
 	{
 		return Gfx_App::GetSingleton()->m_Swapchain;
@@ -23,6 +23,7 @@
 #include <string>
 
 #include "Common/Gfx_Log.h"
+#include "Common/Gfx_CpuProfiler.h"
 #include "Gfx_App.h"
 
 
@@ -1,16 +1,123 @@
 #include "Gfx_Precompiled.h"
 #include "Gfx_RenderContext.h"
 
+#include <vulkan_memory_allocator/vk_mem_alloc.h>
+
 namespace SmolEngine
 {
 	Gfx_RenderContext* Gfx_RenderContext::s_Instance = nullptr;
 
+	static VkPipelineBindPoint locGetBindPoint(const Gfx_Pipeline* pipeline)
+	{
+		switch (pipeline->GetType())
+		{
+		case Gfx_Pipeline::Type::Compute:
+			return VK_PIPELINE_BIND_POINT_COMPUTE;
+		case Gfx_Pipeline::Type::Raytrcing:
+			return VK_PIPELINE_BIND_POINT_RAY_TRACING_KHR;
+		default:
+			return VK_PIPELINE_BIND_POINT_GRAPHICS;
+		}
+	}
+
 	Gfx_RenderContext::Gfx_RenderContext()
 	{
 		s_Instance = this;
 
+		m_DescriptorAllocator.Create(Gfx_App::GetFramesInFlight());
+		m_DescriptorBuffer.Create(Gfx_App::GetFramesInFlight());
+		m_BindlessHeap.Create();
+
+		const Gfx_VulkanDevice& device = Gfx_App::GetDevice();
+
+		BufferArenaCreateDesc geometryDesc{};
+		geometryDesc.myBufferUsage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT |
+			VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+		geometryDesc.myMemUsage = VMA_MEMORY_USAGE_GPU_ONLY;
+		geometryDesc.myPool = MemoryPool::Geometry;
+
+		if (device.GetRaytracingSupport())
+			geometryDesc.myBufferUsage |= VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT | VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR;
+
+		m_GeometryArena.Create(geometryDesc);
+
+		// Mapped once, views are written in place; a uniform range rarely exceeds 64KB
+		BufferArenaCreateDesc uniformDesc{};
+		uniformDesc.mySize = 8 * 1024 * 1024;
+		uniformDesc.myMaxAllocationSize = 64 * 1024;
+		uniformDesc.myBufferUsage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+		uniformDesc.myMemUsage = VMA_MEMORY_USAGE_CPU_TO_GPU;
+
+		if (device.GetDescriptorBufferSupport())
+			uniformDesc.myBufferUsage |= VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT;
+
+		m_UniformArena.Create(uniformDesc);
+
 		SamplerCreateDesc samplerDesc{};
 		m_DefaultSampler = CreateSampler(samplerDesc);
+
+		uint32_t placeholderPixel = 0xff808080;
+
+		TextureCreateDesc placeholderDesc{};
+		placeholderDesc.mySize = { 1, 1 };
+		placeholderDesc.myFormat = Format::R8G8B8A8_UNORM;
+		placeholderDesc.myUserData = &placeholderPixel;
+		m_PlaceholderTexture = CreateTexture(placeholderDesc);
+
+		m_TextureLoader.Create();
+		m_TextureStreamer.Create(Gfx_App::GetFramesInFlight());
+		m_ReadbackQueue.Create(Gfx_App::GetFramesInFlight());
+		m_GpuProfiler.Create(Gfx_App::GetFramesInFlight());
+		m_QueryManager.Create(Gfx_App::GetFramesInFlight());
+
+		// Descriptors copy buffer and image view handles, Defragment replaces both
+		m_RelocationListener = Gfx_VulkanAllocator::AddRelocationListener([this](const MemoryRelocations& relocations)
+		{
+			Gfx_Descriptor::OnRelocated(relocations);
+			m_BindlessHeap.OnRelocated(relocations);
+		});
+	}
+
+	Gfx_RenderContext::~Gfx_RenderContext()
+	{
+		Gfx_VulkanAllocator::RemoveRelocationListener(m_RelocationListener);
+		vkDeviceWaitIdle(Gfx_App::GetDevice().GetLogicalDevice());
+
+		// Loaders and per-frame pools still hold textures, buffers and descriptors
+		m_TextureLoader.Free();
+		m_TextureStreamer.Free();
+		m_TextureCache.Clear();
+		m_ReadbackQueue.Free();
+		m_GpuProfiler.Free();
+		m_QueryManager.Free();
+
+		// Shaders release their modules through s_Instance, so they go first
+		m_Pipelines.clear();
+		m_Shaders.clear();
+		m_MipGenerator.Free();
+
+		m_PixelStorages.clear();
+		m_Buffers.clear();
+		m_PlaceholderTexture = nullptr;
+		m_DefaultSampler = nullptr;
+
+		// Views that are still alive are detached from the arenas
+		m_GeometryArena.Free();
+		m_UniformArena.Free();
+
+		// The bindless heap lives in a region of the descriptor buffer, both use the allocator's layouts
+		m_BindlessHeap.Free();
+		m_DescriptorBuffer.Free();
+		m_DescriptorAllocator.Free();
+
+		// Modules still referenced by shaders that outlive the context
+		for (auto& [key, entry] : m_ShaderModules)
+			VK_DESTROY_DEVICE_HANDLE(entry.myModule, vkDestroyShaderModule);
+
+		m_ShaderModules.clear();
+		m_ShaderModuleKeys.clear();
+
+		s_Instance = nullptr;
 	}
 
 	Ref<Gfx_Shader> Gfx_RenderContext::CreateShader(ShaderCreateDesc& desc, const std::string& debugName)
@@ -69,9 +176,34 @@ namespace SmolEngine
 
 	Ref<Gfx_Texture> Gfx_RenderContext::CreateTexture(TextureCreateDesc& desc, const std::string& debugName)
 	{
+		// File textures are shared, the key is taken before Create fills in size and format
+		const TextureCreateDesc keyDesc = desc;
+		bool isCached = !desc.myFilePath.empty();
+		if (isCached)
+		{
+			if (Ref<Gfx_Texture> cached = s_Instance->m_TextureCache.Find(keyDesc))
+			{
+				// Queued by CreateTextureAsync, the caller expects the image and its desc right away
+				if (!cached->IsReady())
+					s_Instance->m_TextureLoader.Flush();
+
+				if (cached->IsReady())
+				{
+					desc = cached->m_Desc;
+					return cached;
+				}
+
+				// The async load failed and the entry keeps the placeholder, this texture is created on its own
+				isCached = false;
+			}
+		}
+
 		Ref<Gfx_Texture> texture = std::make_shared<Gfx_Texture>();
 		texture->Create(&desc);
 
+		if (isCached)
+			texture = s_Instance->m_TextureCache.Insert(keyDesc, texture);
+
 		if (!debugName.empty())
 		{
 			const auto& it = s_Instance->m_PixelStorages.find(debugName);
@@ -84,6 +216,24 @@ namespace SmolEngine
 		return texture;
 	}
 
+	Ref<Gfx_Texture> Gfx_RenderContext::CreateTextureAsync(const TextureCreateDesc& desc)
+	{
+		GFX_ASSERT_MSG((!desc.myFilePath.empty()), "Gfx_RenderContext: async textures are loaded from a file")
+
+		if (Ref<Gfx_Texture> cached = s_Instance->m_TextureCache.Find(desc))
+			return cached;
+
+		Ref<Gfx_Texture> texture = std::make_shared<Gfx_Texture>();
+		texture->InitPlaceholder(s_Instance->m_PlaceholderTexture);
+
+		// Another thread may have queued the same file in the meantime
+		Ref<Gfx_Texture> cached = s_Instance->m_TextureCache.Insert(desc, texture);
+		if (cached == texture)
+			s_Instance->m_TextureLoader.Enqueue(texture, desc);
+
+		return cached;
+	}
+
 	Ref<Gfx_Sampler> Gfx_RenderContext::CreateSampler(SamplerCreateDesc& desc, const std::string& debugname)
 	{
 		Ref<Gfx_Sampler> sampler = std::make_shared<Gfx_Sampler>();
@@ -100,8 +250,13 @@ namespace SmolEngine
 
 	Ref<Gfx_Buffer> Gfx_RenderContext::CreateBuffer(BufferCreateDesc& desc, const std::string& debugName)
 	{
+		// Plain uniform buffers go to the uniform arena unless the caller picked one
+		BufferCreateDesc bufferDesc = desc;
+		if (bufferDesc.myArena == nullptr && bufferDesc.myBufferUsage == VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT)
+			bufferDesc.myArena = &s_Instance->m_UniformArena;
+
 		Ref<Gfx_Buffer> buffer = std::make_shared<Gfx_Buffer>();
-		buffer->Create(desc);
+		buffer->Create(bufferDesc);
 
 		if (!debugName.empty())
 		{
@@ -148,6 +303,140 @@ namespace SmolEngine
 		return s_Instance->m_DefaultSampler;
 	}
 
+	Ref<Gfx_Texture> Gfx_RenderContext::GetPlaceholderTexture()
+	{
+		return s_Instance->m_PlaceholderTexture;
+	}
+
+	Gfx_TextureLoader& Gfx_RenderContext::GetTextureLoader()
+	{
+		return s_Instance->m_TextureLoader;
+	}
+
+	Gfx_MipGenerator& Gfx_RenderContext::GetMipGenerator()
+	{
+		return s_Instance->m_MipGenerator;
+	}
+
+	Gfx_TextureStreamer& Gfx_RenderContext::GetTextureStreamer()
+	{
+		return s_Instance->m_TextureStreamer;
+	}
+
+	Gfx_TextureCache& Gfx_RenderContext::GetTextureCache()
+	{
+		return s_Instance->m_TextureCache;
+	}
+
+	Gfx_ReadbackQueue& Gfx_RenderContext::GetReadbackQueue()
+	{
+		return s_Instance->m_ReadbackQueue;
+	}
+
+	Gfx_GpuProfiler& Gfx_RenderContext::GetGpuProfiler()
+	{
+		return s_Instance->m_GpuProfiler;
+	}
+
+	Gfx_QueryManager& Gfx_RenderContext::GetQueryManager()
+	{
+		return s_Instance->m_QueryManager;
+	}
+
+	Gfx_DescriptorAllocator& Gfx_RenderContext::GetDescriptorAllocator()
+	{
+		return s_Instance->m_DescriptorAllocator;
+	}
+
+	Gfx_BindlessHeap& Gfx_RenderContext::GetBindlessHeap()
+	{
+		return s_Instance->m_BindlessHeap;
+	}
+
+	Gfx_BufferArena& Gfx_RenderContext::GetGeometryArena()
+	{
+		return s_Instance->m_GeometryArena;
+	}
+
+	Gfx_BufferArena& Gfx_RenderContext::GetUniformArena()
+	{
+		return s_Instance->m_UniformArena;
+	}
+
+	Gfx_DescriptorBuffer& Gfx_RenderContext::GetDescriptorBuffer()
+	{
+		return s_Instance->m_DescriptorBuffer;
+	}
+
+	VkShaderModule Gfx_RenderContext::AcquireShaderModule(const std::vector<uint32_t>& binary)
+	{
+		const Gfx_VulkanDevice& device = Gfx_App::GetDevice();
+
+		VkShaderModuleCreateInfo shaderModuleCI = {};
+		shaderModuleCI.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+		shaderModuleCI.codeSize = binary.size() * sizeof(uint32_t);
+		shaderModuleCI.pCode = binary.data();
+
+		// The driver identifier is computed without creating a module, otherwise fall back to hashing the SPIR-V
+		std::string key;
+		if (device.GetShaderModuleIdentifierSupport())
+		{
+			VkShaderModuleIdentifierEXT identifier{};
+			identifier.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_IDENTIFIER_EXT;
+			device.vkGetShaderModuleCreateInfoIdentifierEXT(device.GetLogicalDevice(), &shaderModuleCI, &identifier);
+
+			key.assign(reinterpret_cast<const char*>(identifier.identifier), identifier.identifierSize);
+		}
+		else
+		{
+			const std::string_view data(reinterpret_cast<const char*>(binary.data()), shaderModuleCI.codeSize);
+			key = std::to_string(std::hash<std::string_view>{}(data)) + "_" + std::to_string(binary.size());
+		}
+
+		std::lock_guard<std::mutex> lock(s_Instance->m_ShaderModuleMutex);
+
+		// A hit only counts if the SPIR-V matches, a colliding binary is stored under the next free key
+		for (;;)
+		{
+			ShaderModuleEntry& entry = s_Instance->m_ShaderModules[key];
+			if (entry.myModule == nullptr)
+			{
+				VK_CHECK_RESULT(vkCreateShaderModule(device.GetLogicalDevice(), &shaderModuleCI, nullptr, &entry.myModule));
+				s_Instance->m_ShaderModuleKeys[entry.myModule] = key;
+				entry.myBinary = binary;
+			}
+
+			if (entry.myBinary == binary)
+			{
+				entry.myRefCount++;
+				return entry.myModule;
+			}
+
+			key += "_";
+		}
+	}
+
+	void Gfx_RenderContext::ReleaseShaderModule(VkShaderModule shaderModule)
+	{
+		// Already destroyed with the context
+		if (s_Instance == nullptr)
+			return;
+
+		std::lock_guard<std::mutex> lock(s_Instance->m_ShaderModuleMutex);
+
+		const auto& keyIt = s_Instance->m_ShaderModuleKeys.find(shaderModule);
+		GFX_ASSERT(keyIt != s_Instance->m_ShaderModuleKeys.end())
+
+		const auto& it = s_Instance->m_ShaderModules.find(keyIt->second);
+		if (--it->second.myRefCount == 0)
+		{
+			VK_DESTROY_DEVICE_HANDLE(it->second.myModule, vkDestroyShaderModule);
+
+			s_Instance->m_ShaderModules.erase(it);
+			s_Instance->m_ShaderModuleKeys.erase(keyIt);
+		}
+	}
+
 	void Gfx_RenderContext::CmdPushConstants(const Ref<Gfx_RenderPass>& renderPass, ShaderStage stage, uint32_t size, const void* data)
 	{
 		Ref<Gfx_CmdBuffer>& cmd = renderPass->myCmd;
@@ -162,9 +451,82 @@ namespace SmolEngine
 		Ref<Gfx_CmdBuffer>& cmd = renderPass->myCmd;
 		GFX_ASSERT(cmd)
 
-		VkDescriptorSet set = another == nullptr ? renderPass->myDescriptor->GetSet() : another->GetSet();
-		vkCmdBindDescriptorSets(cmd->GetBuffer(), VK_PIPELINE_BIND_POINT_GRAPHICS, renderPass->myPipeline->GetLayout(), 
-			0, 1, &set, 0, nullptr);
+		Gfx_Descriptor* descriptor = another == nullptr ? renderPass->myDescriptor.get() : another.get();
+		descriptor->Flush();
+
+		if (s_Instance->m_DescriptorBuffer.IsGood())
+		{
+			const uint32_t bufferIndex = 0;
+			const VkDeviceSize offset = descriptor->GetBufferOffset();
+			Gfx_App::GetDevice().vkCmdSetDescriptorBufferOffsetsEXT(cmd->GetBuffer(), locGetBindPoint(renderPass->myPipeline.get()),
+				renderPass->myPipeline->GetLayout(), descriptor->GetSetIndex(), 1, &bufferIndex, &offset);
+			return;
+		}
+
+		VkDescriptorSet set = descriptor->GetSet();
+		vkCmdBindDescriptorSets(cmd->GetBuffer(), locGetBindPoint(renderPass->myPipeline.get()), renderPass->myPipeline->GetLayout(), 
+			descriptor->GetSetIndex(), 1, &set, 0, nullptr);
+	}
+
+	void Gfx_RenderContext::CmdBindDescriptors(const Ref<Gfx_RenderPass>& renderPass, const std::vector<Ref<Gfx_Descriptor>>& descriptors)
+	{
+		Ref<Gfx_CmdBuffer>& cmd = renderPass->myCmd;
+		GFX_ASSERT(cmd)
+
+		std::vector<Gfx_Descriptor*> sorted;
+		for (const Ref<Gfx_Descriptor>& descriptor : descriptors)
+		{
+			descriptor->Flush();
+			sorted.push_back(descriptor.get());
+		}
+
+		std::sort(sorted.begin(), sorted.end(), [](const Gfx_Descriptor* a, const Gfx_Descriptor* b)
+		{
+			return a->GetSetIndex() < b->GetSetIndex();
+		});
+
+		const VkPipelineBindPoint bindPoint = locGetBindPoint(renderPass->myPipeline.get());
+		const bool useDescriptorBuffer = s_Instance->m_DescriptorBuffer.IsGood();
+
+		std::vector<VkDescriptorSet> sets;
+		std::vector<VkDeviceSize> offsets;
+		std::vector<uint32_t> bufferIndices;
+
+		// One call per run of consecutive set indices
+		for (size_t i = 0; i < sorted.size();)
+		{
+			const uint32_t firstSet = sorted[i]->GetSetIndex();
+			sets.clear();
+			offsets.clear();
+
+			while (i < sorted.size() && sorted[i]->GetSetIndex() == firstSet + sets.size())
+			{
+				sets.push_back(sorted[i]->GetSet());
+				offsets.push_back(sorted[i]->GetBufferOffset());
+				i++;
+			}
+
+			if (useDescriptorBuffer)
+			{
+				bufferIndices.assign(offsets.size(), 0);
+				Gfx_App::GetDevice().vkCmdSetDescriptorBufferOffsetsEXT(cmd->GetBuffer(), bindPoint, renderPass->myPipeline->GetLayout(),
+					firstSet, static_cast<uint32_t>(offsets.size()), bufferIndices.data(), offsets.data());
+				continue;
+			}
+
+			vkCmdBindDescriptorSets(cmd->GetBuffer(), bindPoint, renderPass->myPipeline->GetLayout(),
+				firstSet, static_cast<uint32_t>(sets.size()), sets.data(), 0, nullptr);
+		}
+	}
+
+	void Gfx_RenderContext::CmdPushDescriptor(const Ref<Gfx_RenderPass>& renderPass, const std::vector<DescriptorWrite>& writes, const Ref<Gfx_Descriptor>& another)
+	{
+		Ref<Gfx_CmdBuffer>& cmd = renderPass->myCmd;
+		GFX_ASSERT(cmd)
+
+		Gfx_Descriptor* descriptor = another == nullptr ? renderPass->myDescriptor.get() : another.get();
+		descriptor->CmdPush(cmd->GetBuffer(), locGetBindPoint(renderPass->myPipeline.get()), renderPass->myPipeline->GetLayout(),
+			descriptor->GetSetIndex(), writes);
 	}
 
 	void Gfx_RenderContext::CmdBindPipeline(const Ref<Gfx_RenderPass>& renderPass)
@@ -172,7 +534,34 @@ namespace SmolEngine
 		Ref<Gfx_CmdBuffer>& cmd = renderPass->myCmd;
 		GFX_ASSERT(cmd)
 
-		vkCmdBindPipeline(cmd->GetBuffer(), VK_PIPELINE_BIND_POINT_GRAPHICS, renderPass->myPipeline->GetPipeline());
+		const VkPipelineBindPoint bindPoint = locGetBindPoint(renderPass->myPipeline.get());
+		vkCmdBindPipeline(cmd->GetBuffer(), bindPoint, renderPass->myPipeline->GetPipeline());
+
+		// The heap stays bound for every draw, materials only push their indices
+		std::optional<uint32_t> bindlessSet = renderPass->myPipeline->GetBindlessSet();
+
+		// Sets are offsets into the descriptor buffer, which has to be bound before any of them
+		if (s_Instance->m_DescriptorBuffer.IsGood())
+		{
+			s_Instance->m_DescriptorBuffer.CmdBind(cmd->GetBuffer());
+
+			if (bindlessSet.has_value())
+			{
+				const uint32_t bufferIndex = 0;
+				const VkDeviceSize offset = s_Instance->m_BindlessHeap.GetBufferOffset();
+				Gfx_App::GetDevice().vkCmdSetDescriptorBufferOffsetsEXT(cmd->GetBuffer(), bindPoint, renderPass->myPipeline->GetLayout(),
+					bindlessSet.value(), 1, &bufferIndex, &offset);
+			}
+
+			return;
+		}
+
+		if (bindlessSet.has_value())
+		{
+			VkDescriptorSet set = s_Instance->m_BindlessHeap.GetSet();
+			vkCmdBindDescriptorSets(cmd->GetBuffer(), bindPoint, renderPass->myPipeline->GetLayout(),
+				bindlessSet.value(), 1, &set, 0, nullptr);
+		}
 	}
 
 	void Gfx_RenderContext::CmdRayDispatch(const Ref<Gfx_RenderPass>& renderPass, RayDispatchDesc* desc)
@@ -180,6 +569,8 @@ namespace SmolEngine
 		Ref<Gfx_CmdBuffer>& cmd = renderPass->myCmd;
 		GFX_ASSERT(cmd)
 
+		Gfx_GpuScope scope(cmd.get(), renderPass->myName);
+
 		std::unordered_map<ShaderStage, Gfx_Buffer>& bindingTable = renderPass->myShader->m_BindingTables;
 		const Gfx_VulkanDevice& device = Gfx_App::GetDevice();
 
@@ -187,25 +578,24 @@ namespace SmolEngine
 			device.rayTracingPipelineProperties.shaderGroupHandleAlignment);
 
 		VkStridedDeviceAddressRegionKHR raygenShaderSbtEntry{};
-		raygenShaderSbtEntry.deviceAddress = Gfx_VulkanHelpers::GetBufferDeviceAddress(bindingTable[ShaderStage::RayGen].GetRawBuffer());
+		raygenShaderSbtEntry.deviceAddress = bindingTable[ShaderStage::RayGen].GetDeviceAddress();
 		raygenShaderSbtEntry.stride = handleSizeAligned;
 		raygenShaderSbtEntry.size = handleSizeAligned;
 
 		VkStridedDeviceAddressRegionKHR missShaderSbtEntry{};
-		missShaderSbtEntry.deviceAddress = Gfx_VulkanHelpers::GetBufferDeviceAddress(bindingTable[desc->myRayMiss].GetRawBuffer());
+		missShaderSbtEntry.deviceAddress = bindingTable[desc->myRayMiss].GetDeviceAddress();
 		missShaderSbtEntry.stride = handleSizeAligned;
 		missShaderSbtEntry.size = handleSizeAligned;
 
 		VkStridedDeviceAddressRegionKHR hitShaderSbtEntry{};
-		hitShaderSbtEntry.deviceAddress = Gfx_VulkanHelpers::GetBufferDeviceAddress(bindingTable[desc->myRayHit].GetRawBuffer());
+		hitShaderSbtEntry.deviceAddress = bindingTable[desc->myRayHit].GetDeviceAddress();
 		hitShaderSbtEntry.stride = handleSizeAligned;
 		hitShaderSbtEntry.size = handleSizeAligned;
 
 		VkStridedDeviceAddressRegionKHR callableShaderSbtEntry{};
 		if (desc->myAnyHitOrCallable.has_value())
 		{
-			callableShaderSbtEntry.deviceAddress = Gfx_VulkanHelpers::GetBufferDeviceAddress(
-				bindingTable[desc->myAnyHitOrCallable.value()].GetRawBuffer());
+			callableShaderSbtEntry.deviceAddress = bindingTable[desc->myAnyHitOrCallable.value()].GetDeviceAddress();
 			callableShaderSbtEntry.stride = handleSizeAligned;
 			callableShaderSbtEntry.size = handleSizeAligned;
 		}
@@ -228,7 +618,15 @@ namespace SmolEngine
 		Ref<Gfx_CmdBuffer>& cmd = renderPass->myCmd;
 		GFX_ASSERT(cmd)
 
+		Gfx_GpuScope scope(cmd.get(), renderPass->myName);
+
+		if (!renderPass->myName.empty())
+			s_Instance->m_QueryManager.CmdBeginStatistics(cmd.get(), renderPass->myName);
+
 		vkCmdDispatch(cmd->GetBuffer(), groupCountX, groupCountY, groupCountZ);
+
+		if (!renderPass->myName.empty())
+			s_Instance->m_QueryManager.CmdEndStatistics(cmd.get());
 	}
 
 	void Gfx_RenderContext::CmdBeginRenderPass(const Ref<Gfx_RenderPass>& renderPass)
@@ -236,6 +634,13 @@ namespace SmolEngine
 		Ref<Gfx_CmdBuffer>& cmd = renderPass->myCmd;
 		GFX_ASSERT(cmd)
 
+		// Closed in CmdEndRenderPass, statistics queries have to begin and end outside of the render pass
+		if (!renderPass->myName.empty())
+		{
+			s_Instance->m_GpuProfiler.CmdBeginScope(cmd.get(), renderPass->myName);
+			s_Instance->m_QueryManager.CmdBeginStatistics(cmd.get(), renderPass->myName);
+		}
+
 		glm::uvec2 viewportSize = renderPass->myRenderTarget->GetSize();
 
 		VkRenderPassBeginInfo renderPassBeginInfo = {};
@@ -278,54 +683,88 @@ namespace SmolEngine
 		GFX_ASSERT(cmd)
 
 		vkCmdEndRenderPass(cmd->GetBuffer());
+
+		if (!renderPass->myName.empty())
+		{
+			s_Instance->m_QueryManager.CmdEndStatistics(cmd.get());
+			s_Instance->m_GpuProfiler.CmdEndScope(cmd.get());
+		}
+	}
+
+	void Gfx_RenderContext::CmdBeginOcclusionQuery(const Ref<Gfx_RenderPass>& renderPass, uint64_t id)
+	{
+		Ref<Gfx_CmdBuffer>& cmd = renderPass->myCmd;
+		GFX_ASSERT(cmd)
+
+		s_Instance->m_QueryManager.CmdBeginOcclusion(cmd.get(), id);
 	}
 
-	void Gfx_Pipeline::CmdDrawIndexed(Gfx_CmdBuffer* cmdBuffer, Gfx_VertexBuffer* vb, Gfx_IndexBuffer* ib)
+	void Gfx_RenderContext::CmdEndOcclusionQuery(const Ref<Gfx_RenderPass>& renderPass)
 	{
-		VkDeviceSize offsets[1] = { 0 };
+		Ref<Gfx_CmdBuffer>& cmd = renderPass->myCmd;
+		GFX_ASSERT(cmd)
+
+		s_Instance->m_QueryManager.CmdEndOcclusion(cmd.get());
+	}
+
+	void Gfx_RenderContext::CmdDrawIndexed(const Ref<Gfx_RenderPass>& renderPass, const Ref<Gfx_VertexBuffer>& vb, const Ref<Gfx_IndexBuffer>& ib)
+	{
+		Ref<Gfx_CmdBuffer>& cmd = renderPass->myCmd;
+		GFX_ASSERT(cmd)
+
+		VkDeviceSize offsets[1] = { vb->GetBuffer().GetOffset() };
 		VkBuffer vk_vb = vb->GetBuffer().GetRawBuffer();
 		VkBuffer vk_ib = ib->GetBuffer().GetRawBuffer();
-		VkCommandBuffer cmd = cmdBuffer->GetBuffer();
 
-		vkCmdBindVertexBuffers(cmd, 0, 1, &vk_vb, offsets);
-		vkCmdBindIndexBuffer(cmd, vk_ib, 0, VK_INDEX_TYPE_UINT32); // TODO:: add uint16_t
-		vkCmdDrawIndexed(cmd, ib->GetCount(), 1, 0, 0, 1);
+		vkCmdBindVertexBuffers(cmd->GetBuffer(), 0, 1, &vk_vb, offsets);
+		vkCmdBindIndexBuffer(cmd->GetBuffer(), vk_ib, ib->GetBuffer().GetOffset(), VK_INDEX_TYPE_UINT32); // TODO:: add uint16_t
+		vkCmdDrawIndexed(cmd->GetBuffer(), ib->GetCount(), 1, 0, 0, 0);
 	}
 
-	void Gfx_Pipeline::CmdDraw(Gfx_CmdBuffer* cmdBuffer, uint32_t vertextCount, Gfx_VertexBuffer* vb)
+	void Gfx_RenderContext::CmdDraw(const Ref<Gfx_RenderPass>& renderPass, uint32_t vertexCount)
 	{
-		VkCommandBuffer cmd = cmdBuffer->GetBuffer();
-		if (vb != nullptr)
-		{
-			VkDeviceSize offsets[1] = { 0 };
-			VkBuffer buffer = vb->GetBuffer().GetRawBuffer();
-			vkCmdBindVertexBuffers(cmd, 0, 1, &buffer, offsets);
-		}
+		Ref<Gfx_CmdBuffer>& cmd = renderPass->myCmd;
+		GFX_ASSERT(cmd)
+
+		vkCmdDraw(cmd->GetBuffer(), vertexCount, 1, 0, 0);
+	}
 
-		vkCmdDraw(cmd, vertextCount, 1, 0, 0);
+	void Gfx_RenderContext::CmdDraw(const Ref<Gfx_RenderPass>& renderPass, const Ref<Gfx_VertexBuffer>& vb)
+	{
+		Ref<Gfx_CmdBuffer>& cmd = renderPass->myCmd;
+		GFX_ASSERT(cmd)
+		GFX_ASSERT(vb)
+
+		VkDeviceSize offsets[1] = { vb->GetBuffer().GetOffset() };
+		VkBuffer buffer = vb->GetBuffer().GetRawBuffer();
+
+		vkCmdBindVertexBuffers(cmd->GetBuffer(), 0, 1, &buffer, offsets);
+		vkCmdDraw(cmd->GetBuffer(), vb->GetVertexCount(), 1, 0, 0);
 	}
 
-	void Gfx_Pipeline::CmdDrawMeshIndexed(Gfx_CmdBuffer* cmdBuffer, Gfx_Mesh* mesh, uint32_t instances /*= 1*/)
+	void Gfx_RenderContext::CmdDrawMeshIndexed(const Ref<Gfx_RenderPass>& renderPass, const Ref<Gfx_Mesh>& mesh, uint32_t instances /*= 1*/)
 	{
-		VkDeviceSize offsets[1] = { 0 };
+		Ref<Gfx_CmdBuffer>& cmd = renderPass->myCmd;
+		GFX_ASSERT(cmd)
+
+		VkDeviceSize offsets[1] = { mesh->GetVertexBuffer()->GetBuffer().GetOffset() };
 		VkBuffer vk_vb = mesh->GetVertexBuffer()->GetBuffer().GetRawBuffer();
 		VkBuffer vk_ib = mesh->GetIndexBuffer()->GetBuffer().GetRawBuffer();
-		VkCommandBuffer cmd = cmdBuffer->GetBuffer();
 
-		vkCmdBindVertexBuffers(cmd, 0, 1, &vk_vb, offsets);
-		vkCmdBindIndexBuffer(cmd, vk_ib, 0, VK_INDEX_TYPE_UINT32);
-		vkCmdDrawIndexed(cmd, mesh->GetIndexBuffer()->GetCount(), instances, 0, 0, 0);
+		vkCmdBindVertexBuffers(cmd->GetBuffer(), 0, 1, &vk_vb, offsets);
+		vkCmdBindIndexBuffer(cmd->GetBuffer(), vk_ib, mesh->GetIndexBuffer()->GetBuffer().GetOffset(), VK_INDEX_TYPE_UINT32);
+		vkCmdDrawIndexed(cmd->GetBuffer(), mesh->GetIndexBuffer()->GetCount(), instances, 0, 0, 0);
 	}
 
-	void Gfx_Pipeline::CmdDrawMesh(Gfx_CmdBuffer* cmdBuffer, Gfx_Mesh* mesh, uint32_t instances /*= 1*/)
+	void Gfx_RenderContext::CmdDrawMesh(const Ref<Gfx_RenderPass>& renderPass, const Ref<Gfx_Mesh>& mesh, uint32_t instances /*= 1*/)
 	{
-		VkDeviceSize offsets[1] = { 0 };
+		Ref<Gfx_CmdBuffer>& cmd = renderPass->myCmd;
+		GFX_ASSERT(cmd)
+
+		VkDeviceSize offsets[1] = { mesh->GetVertexBuffer()->GetBuffer().GetOffset() };
 		VkBuffer vk_vb = mesh->GetVertexBuffer()->GetBuffer().GetRawBuffer();
-		VkBuffer vk_ib = mesh->GetIndexBuffer()->GetBuffer().GetRawBuffer();
-		VkCommandBuffer cmd = cmdBuffer->GetBuffer();
 
-		vkCmdBindVertexBuffers(cmd, 0, 1, &vk_vb, offsets);
-		vkCmdBindIndexBuffer(cmd, vk_ib, 0, VK_INDEX_TYPE_UINT32);
-		vkCmdDraw(cmd, mesh->GetVertexBuffer()->GetVertexCount(), instances, 0, 0);
+		vkCmdBindVertexBuffers(cmd->GetBuffer(), 0, 1, &vk_vb, offsets);
+		vkCmdDraw(cmd->GetBuffer(), mesh->GetVertexBuffer()->GetVertexCount(), instances, 0, 0);
 	}
-}
\ No newline at end of file
+}
@@ -198,6 +198,8 @@ namespace SmolEngine
 
 	bool Gfx_MeshImporter::Import(const std::string& filePath, ImportedData* out_data)
 	{
+		GFX_PROFILE_SCOPE("Gfx_MeshImporter::Import")
+
 		tinygltf::Model    glTFInput;
 		tinygltf::TinyGLTF gltfContext;
 		std::string        error, warning;
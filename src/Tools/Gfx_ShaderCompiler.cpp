@@ -13,6 +13,8 @@ VKBP_DISABLE_WARNINGS()
 #include <spirv_cross/spirv_glsl.hpp>
 #include <spirv_cross/spirv_hlsl.hpp>
 
+#include <spirv-tools/optimizer.hpp>
+
 namespace SmolEngine
 {
 	class TPreamble {
@@ -100,135 +102,12 @@ namespace SmolEngine
 		return EShLangVertex;
 	}
 
-	// TODO: error handling
-	void Gfx_ShaderCompiler::CompileSPIRV(const ShaderCompileDesc& desc, std::vector<uint32_t>& out_binaries)
-	{
-		const bool isHLSL = desc.myFilePath.find("hlsl") != std::string::npos;
-		if (isHLSL)
-			HlslToSpirv(desc, out_binaries);
-		else
-			GlslToSpirv(desc, out_binaries);
-
-		std::string cachedPath = Gfx_Helpers::GetCachedPath(desc.myFilePath, CachedPathType::Shader);
-		std::ofstream out(cachedPath, std::ios::out | std::ios::binary);
-		if (out.is_open())
-		{
-			out.write((char*)out_binaries.data(), out_binaries.size() * sizeof(uint32_t));
-			out.flush();
-			out.close();
-		}
-	}
-
-	void Gfx_ShaderCompiler::LoadSPIRV(const std::string& path, std::vector<uint32_t>& out_binaries)
-	{
-		std::ifstream in(path, std::ios::in | std::ios::binary);
-		if (in.is_open())
-		{
-			in.seekg(0, std::ios::end);
-			auto size = in.tellg();
-			in.seekg(0, std::ios::beg);
-
-			out_binaries.resize(size / sizeof(uint32_t));
-			in.read((char*)out_binaries.data(), size);
-		}
-	}
-
-	void Gfx_ShaderCompiler::SpirvToGlsl(const ShaderCompileDesc& desc)
+	static const TBuiltInResource& locGetResources()
 	{
-		std::vector<uint32_t> binaries{};
-		LoadSPIRV(desc.myFilePath, binaries);
-
-		spirv_cross::CompilerGLSL compiler(binaries);
-
-		// Set some options.
-		spirv_cross::CompilerGLSL::Options options;
-		options.version = 460;
-		options.vulkan_semantics = true;
-
-		compiler.set_common_options(options);
-
-		std::string glsl = compiler.compile();
-
-		{
-			std::ofstream file;
-			file.open(desc.myFilePathOut);
-
-			if (file.is_open())
-			{
-				file << glsl;
-			}
-			file.close();
-		}
-	}
-
-	void Gfx_ShaderCompiler::SpirvToHlsl(const ShaderCompileDesc& desc)
-	{
-		std::vector<uint32_t> binaries{};
-		LoadSPIRV(desc.myFilePath, binaries);
-		spirv_cross::CompilerHLSL compiler(binaries);
-
-		spirv_cross::CompilerHLSL::Options options{};
-		options.shader_model = 66;
-
-		compiler.set_hlsl_options(options);
-
-		std::string hlsl = compiler.compile();
-		{
-			std::ofstream file;
-			file.open(desc.myFilePathOut);
-
-			if (file.is_open())
-			{
-				file << hlsl;
-			}
-			file.close();
-		}
-	}
-
-	void Gfx_ShaderCompiler::GlslToSpirv(const ShaderCompileDesc& desc, std::vector<uint32_t>& out_binaries)
-	{
-		std::ifstream file(desc.myFilePath);
-		std::stringstream buffer;
-
-		GFX_ASSERT_MSG(file, "Could not load file")
-
-		buffer << file.rdbuf();
-		std::string src = buffer.str();
-		file.close();
-
-		// Initialize glslang library.
-		glslang::InitializeProcess();
-
-		const char* file_name_list[1] = { "" };
-		const char* shader_source = reinterpret_cast<const char*>(src.data());
-
-		EShMessages messages = static_cast<EShMessages>(EShMsgDefault | EShMsgVulkanRules | EShMsgSpvRules);
-		EShLanguage language = locGetShaderType(desc.myStage);
-
-		glslang::TShader shader(language);
-
-		shader.setAutoMapLocations(true);
-		shader.setAutoMapBindings(true);
-
-		shader.setEnvTarget(glslang::EShTargetSpv, glslang::EShTargetSpv_1_5);
-		shader.setStringsWithLengthsAndNames(&shader_source, nullptr, file_name_list, 1);
-		shader.setEntryPoint("main");
-		shader.setEnvInput(glslang::EShSource::EShSourceGlsl, shader.getStage(), glslang::EShClientVulkan, 100);
-		shader.setEnvClient(glslang::EShClientVulkan, glslang::EShTargetVulkan_1_2);
-		shader.setSourceEntryPoint("main");
-
-		TPreamble prebale;
-		for (auto& [name, value] : desc.myDefines)
-		{
-			std::string res = value ? "0" : "1";
-			prebale.addDef(name + "=" + res);
-		}
-
-		shader.setPreamble(prebale.get());
-
-		Gfx_ShaderIncluder* includer = Gfx_ShaderIncluder::GetSingleton();
-
-		TBuiltInResource Resources{};
+		static TBuiltInResource Resources{};
+		static bool initialized = false;
+		if (initialized)
+			return Resources;
 
 		Resources.maxLights = 32;
 		Resources.maxClipPlanes = 6;
@@ -333,10 +212,73 @@ namespace SmolEngine
 		Resources.limits.generalVariableIndexing = 1;
 		Resources.limits.generalConstantMatrixVectorIndexing = 1;
 
+		initialized = true;
+		return Resources;
+	}
+
+	// GLSL and HLSL share the same front end, includer and SPIR-V back end
+	static bool locCompileGlslang(const ShaderCompileDesc& desc, glslang::EShSource source, std::vector<uint32_t>& out_binaries)
+	{
+		std::ifstream file(desc.myFilePath);
+		std::stringstream buffer;
 
-		if (!shader.parse(&Resources, 100, false, messages, *includer))
+		if (!file)
+		{
+			GFX_LOG("Could not load file " + desc.myFilePath, Gfx_Log::Level::Error)
+			return false;
+		}
+
+		buffer << file.rdbuf();
+		std::string src = buffer.str();
+		file.close();
+
+		// Initialize glslang library.
+		glslang::InitializeProcess();
+
+		const bool isHLSL = source == glslang::EShSource::EShSourceHlsl;
+		const char* file_name_list[1] = { desc.myFilePath.c_str() };
+		const char* shader_source = reinterpret_cast<const char*>(src.data());
+
+		EShMessages messages = static_cast<EShMessages>(EShMsgDefault | EShMsgVulkanRules | EShMsgSpvRules);
+		if (isHLSL)
+			messages = static_cast<EShMessages>(messages | EShMsgReadHlsl | EShMsgHlslOffsets);
+
+		EShLanguage language = locGetShaderType(desc.myStage);
+
+		glslang::TShader shader(language);
+
+		shader.setAutoMapLocations(true);
+		shader.setAutoMapBindings(true);
+
+		shader.setEnvTarget(glslang::EShTargetSpv, glslang::EShTargetSpv_1_5);
+		shader.setStringsWithLengthsAndNames(&shader_source, nullptr, file_name_list, 1);
+		shader.setEntryPoint("main");
+		shader.setEnvInput(source, shader.getStage(), glslang::EShClientVulkan, 100);
+		shader.setEnvClient(glslang::EShClientVulkan, glslang::EShTargetVulkan_1_2);
+		shader.setSourceEntryPoint("main");
+
+		if (isHLSL)
+		{
+			shader.setHlslIoMapping(true);
+			shader.setEnvTargetHlslFunctionality1();
+		}
+
+		TPreamble prebale;
+		for (auto& [name, value] : desc.myDefines)
+		{
+			std::string res = value ? "0" : "1";
+			prebale.addDef(name + "=" + res);
+		}
+
+		shader.setPreamble(prebale.get());
+
+		Gfx_ShaderIncluder* includer = Gfx_ShaderIncluder::GetSingleton();
+
+		if (!shader.parse(&locGetResources(), 100, false, messages, *includer))
 		{
 			GFX_LOG(std::string(shader.getInfoLog()) + "\n" + std::string(shader.getInfoDebugLog()), Gfx_Log::Level::Error)
+			glslang::FinalizeProcess();
+			return false;
 		}
 
 		// Add shader to new program object.
@@ -347,71 +289,424 @@ namespace SmolEngine
 		if (!program.link(messages))
 		{
 			GFX_LOG(std::string(program.getInfoLog()) + "\n" + std::string(program.getInfoDebugLog()), Gfx_Log::Level::Error)
+			glslang::FinalizeProcess();
+			return false;
 		}
 
 		glslang::TIntermediate* intermediate = program.getIntermediate(language);
+		if (intermediate == nullptr)
+		{
+			GFX_LOG("Failed to get shared intermediate code of " + desc.myFilePath, Gfx_Log::Level::Error)
+			glslang::FinalizeProcess();
+			return false;
+		}
 
-		GFX_ASSERT_MSG(intermediate, "Failed to get shared intermediate code");
-
+		// HLSL output is only valid after the legalization passes run inside GlslangToSpv, which disableOptimizer would skip.
+		// Performance passes are left to OptimizeSPIRV
 		spv::SpvBuildLogger logger;
 		glslang::SpvOptions options = {};
-		options.disableOptimizer = false;
+		options.disableOptimizer = !isHLSL;
+		options.generateDebugInfo = desc.myDebug;
 
+		out_binaries.clear();
 		glslang::GlslangToSpv(*intermediate, out_binaries, &logger, &options);
-		std::string error = logger.getAllMessages();
 
-		GFX_ASSERT_MSG(error.empty(), error)
+		std::string messagesLog = logger.getAllMessages();
+		if (!messagesLog.empty())
+		{
+			GFX_LOG(desc.myFilePath + ": " + messagesLog, out_binaries.empty() ? Gfx_Log::Level::Error : Gfx_Log::Level::Warning)
+		}
 
 		// Shutdown glslang library.
 		glslang::FinalizeProcess();
+		return !out_binaries.empty();
 	}
 
-	void Gfx_ShaderCompiler::HlslToSpirv(const ShaderCompileDesc& desc, std::vector<uint32_t>& out_binaries)
+	// Bump when the layout of the .reflection file changes
+	static const uint32_t s_ReflectionVersion = 1;
+
+	static void locWriteUInt(std::ofstream& out, uint32_t value)
 	{
-		Gfx_ShaderIncluder* includer = Gfx_ShaderIncluder::GetSingleton();
-		const auto sdk_path = std::getenv("VULKAN_SDK");
-		const std::string& base_path = Gfx_App::GetSingleton()->GetAssetsPath();
-		const std::string  compiler_path = std::string(sdk_path) + "/Bin/dxc.exe" + " ";
-		const std::string  include_path = "";
-		const std::string  shader_path = std::filesystem::absolute(desc.myFilePath).string();
-		const std::string  shader_path_temp = shader_path + ".temp";
-		const std::string  opt_str = desc.myOptimize ? "" : "-Od ";
-		const std::string  opt2_str = desc.myDebug ? "-Zi " : "";
-
-		std::string  defines = "";
-		if (desc.myDefines.size() > 0)
+		out.write((const char*)&value, sizeof(uint32_t));
+	}
+
+	static void locWriteString(std::ofstream& out, const std::string& value)
+	{
+		locWriteUInt(out, static_cast<uint32_t>(value.size()));
+		out.write(value.data(), value.size());
+	}
+
+	static uint32_t locReadUInt(std::ifstream& in)
+	{
+		uint32_t value = 0;
+		in.read((char*)&value, sizeof(uint32_t));
+		return value;
+	}
+
+	static std::string locReadString(std::ifstream& in)
+	{
+		std::string value;
+		value.resize(locReadUInt(in));
+		in.read(value.data(), value.size());
+		return value;
+	}
+
+	bool Gfx_ShaderCompiler::CompileSPIRV(const ShaderCompileDesc& desc, std::vector<uint32_t>& out_binaries, ShaderReflection& out_reflection,
+		ShaderCompileStats* out_stats)
+	{
+		const bool isHLSL = desc.myFilePath.find("hlsl") != std::string::npos;
+		const bool compiled = isHLSL ? HlslToSpirv(desc, out_binaries) : GlslToSpirv(desc, out_binaries);
+
+		// Nothing is cached, the next Create compiles again
+		if (!compiled)
+		{
+			out_binaries.clear();
+			return false;
+		}
+
+		ShaderCompileStats stats{};
+		stats.myWordsBefore = static_cast<uint32_t>(out_binaries.size());
+		stats.myInstructionsBefore = GetInstructionCount(out_binaries);
+
+		if (desc.myOptimize)
+			OptimizeSPIRV(desc.myOptimization, out_binaries);
+
+		// Reflect before stripping so binding names survive
+		ReflectSPIRV(out_binaries, desc.myStage, out_reflection);
+
+		if (desc.myStripDebugInfo)
+			StripSPIRV(out_binaries);
+
+		stats.myWordsAfter = static_cast<uint32_t>(out_binaries.size());
+		stats.myInstructionsAfter = GetInstructionCount(out_binaries);
+
+		if (desc.myOptimization != ShaderOptimization::None || desc.myStripDebugInfo)
 		{
-			defines = "-D";
+			GFX_LOG(std::format("{}: words {} -> {}, instructions {} -> {}", desc.myFilePath, stats.myWordsBefore, stats.myWordsAfter,
+				stats.myInstructionsBefore, stats.myInstructionsAfter), Gfx_Log::Level::Info)
+		}
+
+		if (out_stats)
+			*out_stats = stats;
+
+		std::string cachedPath = GetCachedPath(desc, CachedPathType::Shader);
+		std::ofstream out(cachedPath, std::ios::out | std::ios::binary);
+		if (out.is_open())
+		{
+			out.write((char*)out_binaries.data(), out_binaries.size() * sizeof(uint32_t));
+			out.flush();
+			out.close();
+		}
+
+		SaveReflection(GetCachedPath(desc, CachedPathType::Reflection), out_reflection);
+		return true;
+	}
+
+	std::string Gfx_ShaderCompiler::GetCachedPath(const ShaderCompileDesc& desc, CachedPathType type)
+	{
+		// Optimized and stripped variants get their own cache entries
+		std::string key = desc.myFilePath;
+		switch (desc.myOptimization)
+		{
+		case ShaderOptimization::Performance: key += ".perf"; break;
+		case ShaderOptimization::Size:        key += ".size"; break;
+		}
+
+		if (desc.myStripDebugInfo)
+			key += ".stripped";
 
-			for (auto& [name, value] : desc.myDefines)
+		return Gfx_Helpers::GetCachedPath(key, type);
+	}
+
+	void Gfx_ShaderCompiler::OptimizeSPIRV(ShaderOptimization optimization, std::vector<uint32_t>& binaries)
+	{
+		if (optimization == ShaderOptimization::None)
+			return;
+
+		spvtools::Optimizer optimizer(SPV_ENV_VULKAN_1_2);
+		optimizer.SetMessageConsumer([](spv_message_level_t level, const char*, const spv_position_t&, const char* message)
 			{
-				std::string res = value ? "0" : "1";
-				defines += " " + name + "=" + res;
-			}
+				if (level <= SPV_MSG_ERROR)
+				{
+					GFX_LOG(std::string(message), Gfx_Log::Level::Error)
+				}
+			});
+
+		if (optimization == ShaderOptimization::Performance)
+			optimizer.RegisterPerformancePasses();
+		else
+			optimizer.RegisterSizePasses();
+
+		std::vector<uint32_t> optimized;
+		if (optimizer.Run(binaries.data(), binaries.size(), &optimized))
+			binaries = std::move(optimized);
+	}
+
+	void Gfx_ShaderCompiler::StripSPIRV(std::vector<uint32_t>& binaries)
+	{
+		spvtools::Optimizer optimizer(SPV_ENV_VULKAN_1_2);
+		optimizer.RegisterPass(spvtools::CreateStripDebugInfoPass());
+		optimizer.RegisterPass(spvtools::CreateStripNonSemanticInfoPass());
+
+		std::vector<uint32_t> stripped;
+		if (optimizer.Run(binaries.data(), binaries.size(), &stripped))
+			binaries = std::move(stripped);
+	}
+
+	uint32_t Gfx_ShaderCompiler::GetInstructionCount(const std::vector<uint32_t>& binaries)
+	{
+		// 5 header words, then every instruction stores its word count in the upper 16 bits
+		const size_t headerSize = 5;
+		uint32_t count = 0;
+		size_t index = headerSize;
+		while (index < binaries.size())
+		{
+			const uint32_t wordCount = binaries[index] >> 16;
+			if (wordCount == 0)
+				break;
+
+			index += wordCount;
+			count++;
+		}
+
+		return count;
+	}
+
+	void Gfx_ShaderCompiler::ReflectSPIRV(const std::vector<uint32_t>& binaries, ShaderStage stage, ShaderReflection& out_reflection)
+	{
+		spirv_cross::Compiler compiler(binaries);
+		spirv_cross::ShaderResources resources = compiler.get_shader_resources();
+
+		out_reflection = {};
+
+		const auto addBinding = [&](DescriptorType descriptorType, const spirv_cross::Resource& res)
+		{
+			const auto& baseType = compiler.get_type(res.base_type_id);
+			const auto& type = compiler.get_type(res.type_id);
+
+			ShaderBindingReflection binding{};
+			binding.myName = res.name;
+			binding.mySet = compiler.get_decoration(res.id, spv::DecorationDescriptorSet);
+			binding.myBinding = compiler.get_decoration(res.id, spv::DecorationBinding);
+			binding.myCount = type.array.empty() ? 1 : type.array[0];
+			binding.myType = descriptorType;
+			binding.myStages = stage;
+
+			if (baseType.basetype == spirv_cross::SPIRType::Struct)
+				binding.mySize = static_cast<uint32_t>(compiler.get_declared_struct_size(baseType));
+
+			out_reflection.myBindings.push_back(binding);
+		};
+
+		for (const auto& res : resources.push_constant_buffers)
+		{
+			auto& type = compiler.get_type(res.base_type_id);
+
+			ShaderPushConstantReflection pushConstant{};
+			pushConstant.myOffset = 0;
+			pushConstant.mySize = static_cast<uint32_t>(compiler.get_declared_struct_size(type));
+			pushConstant.myStages = stage;
+
+			out_reflection.myPushConstant = pushConstant;
+		}
+
+		for (const auto& res : resources.uniform_buffers) { addBinding(DescriptorType::UNIFORM_BUFFER, res); }
+		for (const auto& res : resources.storage_buffers) { addBinding(DescriptorType::STORAGE_BUFFER, res); }
+		for (const auto& res : resources.acceleration_structures) { addBinding(DescriptorType::ACCEL_STRUCTURE, res); }
+		for (const auto& res : resources.sampled_images) { addBinding(DescriptorType::COMBINED_IMAGE_SAMPLER_2D, res); }
+		for (const auto& res : resources.storage_images) { addBinding(DescriptorType::IMAGE_2D, res); }
+		for (const auto& res : resources.separate_images) { addBinding(DescriptorType::TEXTURE_2D, res); }
+		for (const auto& res : resources.separate_samplers) { addBinding(DescriptorType::SEPARATE_SAMPLER, res); }
+
+		for (const auto& constant : compiler.get_specialization_constants())
+		{
+			const auto& value = compiler.get_constant(constant.id);
+			const auto& type = compiler.get_type(value.constant_type);
+
+			ShaderSpecConstantReflection specConstant{};
+			specConstant.myName = compiler.get_name(constant.id);
+			specConstant.myConstantID = constant.constant_id;
+			specConstant.mySize = type.width / 8;
+
+			out_reflection.mySpecConstants.push_back(specConstant);
+		}
+
+		if (stage == ShaderStage::Compute)
+		{
+			out_reflection.myWorkgroupSize.x = compiler.get_execution_mode_argument(spv::ExecutionModeLocalSize, 0);
+			out_reflection.myWorkgroupSize.y = compiler.get_execution_mode_argument(spv::ExecutionModeLocalSize, 1);
+			out_reflection.myWorkgroupSize.z = compiler.get_execution_mode_argument(spv::ExecutionModeLocalSize, 2);
+		}
+	}
+
+	bool Gfx_ShaderCompiler::LoadReflection(const std::string& path, ShaderReflection& out_reflection)
+	{
+		std::ifstream in(path, std::ios::in | std::ios::binary);
+		if (!in.is_open())
+			return false;
+
+		if (locReadUInt(in) != s_ReflectionVersion)
+			return false;
+
+		out_reflection = {};
+
+		const uint32_t bindingCount = locReadUInt(in);
+		out_reflection.myBindings.resize(bindingCount);
+		for (auto& binding : out_reflection.myBindings)
+		{
+			binding.myName = locReadString(in);
+			binding.mySet = locReadUInt(in);
+			binding.myBinding = locReadUInt(in);
+			binding.myCount = locReadUInt(in);
+			binding.mySize = locReadUInt(in);
+			binding.myType = (DescriptorType)locReadUInt(in);
+			binding.myStages = (ShaderStage)locReadUInt(in);
+		}
+
+		if (locReadUInt(in) == 1)
+		{
+			ShaderPushConstantReflection pushConstant{};
+			pushConstant.myOffset = locReadUInt(in);
+			pushConstant.mySize = locReadUInt(in);
+			pushConstant.myStages = (ShaderStage)locReadUInt(in);
+
+			out_reflection.myPushConstant = pushConstant;
+		}
+
+		const uint32_t specConstantCount = locReadUInt(in);
+		out_reflection.mySpecConstants.resize(specConstantCount);
+		for (auto& constant : out_reflection.mySpecConstants)
+		{
+			constant.myName = locReadString(in);
+			constant.myConstantID = locReadUInt(in);
+			constant.mySize = locReadUInt(in);
+		}
+
+		out_reflection.myWorkgroupSize.x = locReadUInt(in);
+		out_reflection.myWorkgroupSize.y = locReadUInt(in);
+		out_reflection.myWorkgroupSize.z = locReadUInt(in);
+
+		return in.good();
+	}
+
+	void Gfx_ShaderCompiler::SaveReflection(const std::string& path, const ShaderReflection& reflection)
+	{
+		std::ofstream out(path, std::ios::out | std::ios::binary);
+		if (!out.is_open())
+			return;
 
-			defines += " ";
+		locWriteUInt(out, s_ReflectionVersion);
+
+		locWriteUInt(out, static_cast<uint32_t>(reflection.myBindings.size()));
+		for (const auto& binding : reflection.myBindings)
+		{
+			locWriteString(out, binding.myName);
+			locWriteUInt(out, binding.mySet);
+			locWriteUInt(out, binding.myBinding);
+			locWriteUInt(out, binding.myCount);
+			locWriteUInt(out, binding.mySize);
+			locWriteUInt(out, (uint32_t)binding.myType);
+			locWriteUInt(out, (uint32_t)binding.myStages);
 		}
 
-		std::string profiler = "-T lib_6_6 ";
-		switch (desc.myStage)
+		locWriteUInt(out, reflection.myPushConstant.has_value() ? 1 : 0);
+		if (reflection.myPushConstant.has_value())
 		{
-		case ShaderStage::Compute:    profiler = "-T cs_6_6 "; break;
-		case ShaderStage::Fragment:   profiler = "-T ps_6_6 "; break;
-		case ShaderStage::Vertex:     profiler = "-T vs_6_6 "; break;
-		case ShaderStage::Geometry:   profiler = "-T gs_6_6 "; break;
+			locWriteUInt(out, reflection.myPushConstant->myOffset);
+			locWriteUInt(out, reflection.myPushConstant->mySize);
+			locWriteUInt(out, (uint32_t)reflection.myPushConstant->myStages);
 		}
 
+		locWriteUInt(out, static_cast<uint32_t>(reflection.mySpecConstants.size()));
+		for (const auto& constant : reflection.mySpecConstants)
 		{
-			std::stringstream command{};
+			locWriteString(out, constant.myName);
+			locWriteUInt(out, constant.myConstantID);
+			locWriteUInt(out, constant.mySize);
+		}
 
-			command << compiler_path << "-spirv " << "spirv-opt -O3 " << opt_str << defines << opt2_str << profiler << "-fspv-target-env=vulkan1.2 " << "-E main "
-				<< include_path << shader_path << " -Fo " + shader_path_temp;
+		locWriteUInt(out, reflection.myWorkgroupSize.x);
+		locWriteUInt(out, reflection.myWorkgroupSize.y);
+		locWriteUInt(out, reflection.myWorkgroupSize.z);
+
+		out.flush();
+		out.close();
+	}
+
+	void Gfx_ShaderCompiler::LoadSPIRV(const std::string& path, std::vector<uint32_t>& out_binaries)
+	{
+		std::ifstream in(path, std::ios::in | std::ios::binary);
+		if (in.is_open())
+		{
+			in.seekg(0, std::ios::end);
+			auto size = in.tellg();
+			in.seekg(0, std::ios::beg);
 
-			assert(system(command.str().c_str()) == 0);
+			out_binaries.resize(size / sizeof(uint32_t));
+			in.read((char*)out_binaries.data(), size);
 		}
+	}
+
+	void Gfx_ShaderCompiler::SpirvToGlsl(const ShaderCompileDesc& desc)
+	{
+		std::vector<uint32_t> binaries{};
+		LoadSPIRV(desc.myFilePath, binaries);
 
-		LoadSPIRV(shader_path_temp, out_binaries);
-		std::filesystem::remove(shader_path_temp);
+		spirv_cross::CompilerGLSL compiler(binaries);
+
+		// Set some options.
+		spirv_cross::CompilerGLSL::Options options;
+		options.version = 460;
+		options.vulkan_semantics = true;
+
+		compiler.set_common_options(options);
+
+		std::string glsl = compiler.compile();
+
+		{
+			std::ofstream file;
+			file.open(desc.myFilePathOut);
+
+			if (file.is_open())
+			{
+				file << glsl;
+			}
+			file.close();
+		}
+	}
+
+	void Gfx_ShaderCompiler::SpirvToHlsl(const ShaderCompileDesc& desc)
+	{
+		std::vector<uint32_t> binaries{};
+		LoadSPIRV(desc.myFilePath, binaries);
+		spirv_cross::CompilerHLSL compiler(binaries);
+
+		spirv_cross::CompilerHLSL::Options options{};
+		options.shader_model = 66;
+
+		compiler.set_hlsl_options(options);
+
+		std::string hlsl = compiler.compile();
+		{
+			std::ofstream file;
+			file.open(desc.myFilePathOut);
+
+			if (file.is_open())
+			{
+				file << hlsl;
+			}
+			file.close();
+		}
+	}
+
+	bool Gfx_ShaderCompiler::GlslToSpirv(const ShaderCompileDesc& desc, std::vector<uint32_t>& out_binaries)
+	{
+		return locCompileGlslang(desc, glslang::EShSource::EShSourceGlsl, out_binaries);
+	}
+
+	bool Gfx_ShaderCompiler::HlslToSpirv(const ShaderCompileDesc& desc, std::vector<uint32_t>& out_binaries)
+	{
+		return locCompileGlslang(desc, glslang::EShSource::EShSourceHlsl, out_binaries);
 	}
 
 }
\ No newline at end of file
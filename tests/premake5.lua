@@ -220,6 +220,142 @@ filter "configurations:Release"
 optimize "full"
 defines "SMOLENGINE_DEBUG"
 
+filter "configurations:Dist"
+optimize "full"
+defines "SMOLENGINE_DIST"
+filter {}
+----------------------------------------------------------------------------------------------------------
+
+project "Benchmark"
+language "C++"
+cppdialect "C++20"
+staticruntime "off"
+
+kind "ConsoleApp"
+
+targetdir ("bin/" .. outputdir .. "/%{prj.name}")
+objdir ("bin-int/" .. outputdir .. "/%{prj.name}")
+linkoptions { "/ignore:4099" }
+
+VULKAN_SDK = os.getenv("VULKAN_SDK")
+
+files
+{
+    "src/Benchmark.cpp",
+}
+
+includedirs
+{
+    "%{VULKAN_SDK}/Include",
+    
+    "../include",
+    "../vendor/",
+    "../vendor/implot/",
+    "../vendor/glm",
+    "../vendor/imgui",
+    "../vendor/imgizmo/src",
+    "../vendor/stb_image",
+
+    "../vendor/nvidia_aftermath/include",
+    "../vendor/ozz-animation/include",
+    "../vendor/cereal/include",
+    "../vendor/glfw/include",
+    "../vendor/tinygltf",
+    "../vendor/gli",
+}
+
+links
+{
+    "SmolEngine.Graphics"
+}
+
+filter "system:windows"
+systemversion "latest"
+
+defines
+{
+    "_CRT_SECURE_NO_WARNINGS",
+    "PLATFORM_WIN",
+
+    --"AFTERMATH"
+}
+
+filter "configurations:Debug"
+symbols "on"
+defines "SMOLENGINE_DEBUG"
+
+filter "configurations:Release"
+optimize "full"
+defines "SMOLENGINE_DEBUG"
+
+filter "configurations:Dist"
+optimize "full"
+defines "SMOLENGINE_DIST"
+filter {}
+----------------------------------------------------------------------------------------------------------
+
+project "Streamer Test"
+language "C++"
+cppdialect "C++20"
+staticruntime "off"
+
+kind "ConsoleApp"
+
+targetdir ("bin/" .. outputdir .. "/%{prj.name}")
+objdir ("bin-int/" .. outputdir .. "/%{prj.name}")
+linkoptions { "/ignore:4099" }
+
+VULKAN_SDK = os.getenv("VULKAN_SDK")
+
+files
+{
+    "src/Test_TextureStreamer.cpp",
+}
+
+includedirs
+{
+    "%{VULKAN_SDK}/Include",
+    
+    "../include",
+    "../vendor/",
+    "../vendor/implot/",
+    "../vendor/glm",
+    "../vendor/imgui",
+    "../vendor/imgizmo/src",
+    "../vendor/stb_image",
+
+    "../vendor/nvidia_aftermath/include",
+    "../vendor/ozz-animation/include",
+    "../vendor/cereal/include",
+    "../vendor/glfw/include",
+    "../vendor/tinygltf",
+    "../vendor/gli",
+}
+
+links
+{
+    "SmolEngine.Graphics"
+}
+
+filter "system:windows"
+systemversion "latest"
+
+defines
+{
+    "_CRT_SECURE_NO_WARNINGS",
+    "PLATFORM_WIN",
+
+    --"AFTERMATH"
+}
+
+filter "configurations:Debug"
+symbols "on"
+defines "SMOLENGINE_DEBUG"
+
+filter "configurations:Release"
+optimize "full"
+defines "SMOLENGINE_DEBUG"
+
 filter "configurations:Dist"
 optimize "full"
 defines "SMOLENGINE_DIST"
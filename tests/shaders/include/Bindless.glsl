@@ -0,0 +1,40 @@
+//-------------------------------------------------------------------------------------------------
+// Bindless heap, must match Gfx_BindlessHeap. Define BINDLESS_SET before including
+// to place the heap at the same set index as GraphicsPipelineCreateDesc::myBindlessSet
+
+#ifndef BINDLESS_GLSL
+#define BINDLESS_GLSL 1
+
+#extension GL_EXT_nonuniform_qualifier : require
+
+#ifndef BINDLESS_SET
+#define BINDLESS_SET 1
+#endif
+
+#define BINDLESS_INVALID_INDEX 0xFFFFFFFFu
+
+layout(set = BINDLESS_SET, binding = 0) uniform sampler2D bindlessTextures[];
+layout(set = BINDLESS_SET, binding = 1, rgba8) uniform image2D bindlessImages[];
+layout(set = BINDLESS_SET, binding = 2) buffer BindlessBuffer { uint data[]; } bindlessBuffers[];
+
+vec4 SampleBindless(uint index, vec2 uv)
+{
+	return texture(bindlessTextures[nonuniformEXT(index)], uv);
+}
+
+vec4 LoadBindlessImage(uint index, ivec2 coord)
+{
+	return imageLoad(bindlessImages[nonuniformEXT(index)], coord);
+}
+
+void StoreBindlessImage(uint index, ivec2 coord, vec4 value)
+{
+	imageStore(bindlessImages[nonuniformEXT(index)], coord, value);
+}
+
+uint LoadBindlessBuffer(uint index, uint offset)
+{
+	return bindlessBuffers[nonuniformEXT(index)].data[offset];
+}
+
+#endif
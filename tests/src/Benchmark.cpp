@@ -0,0 +1,518 @@
+#include "Gfx_App.h"
+#include "Gfx_RenderContext.h"
+#include "Common/Gfx_EditorCamera.h"
+#include "Common/Gfx_Log.h"
+#include "Common/Gfx_CpuProfiler.h"
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <numeric>
+#include <map>
+#include <memory>
+#include <format>
+#include <cmath>
+
+#include <glm/gtc/constants.hpp>
+
+using namespace SmolEngine;
+
+// Renders a scene along a scripted camera path and reports frame time percentiles as JSON
+//
+// Benchmark --scene torus.gltf --path orbit.path --frames 1000 --out result.json [--headless]
+// Benchmark --record orbit.path  (flies the editor camera by hand and writes the path on exit)
+// Benchmark --trace trace.json  (also writes a Chrome trace of the CPU scopes, startup included)
+// Benchmark --stats  (adds pipeline statistics of the last measured frame per pass)
+// Benchmark --vma vma.json  (also writes VMA's detailed statistics after the run)
+//
+// A path file holds one key per line, "x y z pitch yaw", keys are spread evenly over the measured frames
+
+struct PushConstant
+{
+	glm::mat4 view;
+	glm::mat4 proj;
+};
+
+struct BenchmarkDesc
+{
+	std::string myScene = "torus.gltf";
+	std::string myVertexShader = "shaders/pbr.vert";
+	std::string myFragmentShader = "shaders/pbr.frag";
+	std::string myCameraPath = "";
+	std::string myRecordPath = "";
+	std::string myOutput = "benchmark.json";
+	std::string myTracePath = "";
+	std::string myVmaStatsPath = "";
+	uint32_t myFrames = 1000;
+	uint32_t myWarmupFrames = 60;
+	glm::uvec2 mySize = { 1280, 720 };
+	bool myIsHeadless = false;
+	bool myIsStatisticsEnabled = false;
+};
+
+struct CameraKey
+{
+	glm::vec3 myPosition;
+	float myPitch;
+	float myYaw;
+};
+
+struct Percentiles
+{
+	double myMin = 0.0;
+	double myMax = 0.0;
+	double myMean = 0.0;
+	double myP50 = 0.0;
+	double myP90 = 0.0;
+	double myP95 = 0.0;
+	double myP99 = 0.0;
+};
+
+// Keys are recorded every few frames, playback interpolates between them
+static const uint32_t s_RecordInterval = 10;
+
+static bool locParseArgs(int argc, char** argv, BenchmarkDesc& desc)
+{
+	for (int i = 1; i < argc; ++i)
+	{
+		const std::string arg = argv[i];
+		if (arg == "--headless")
+		{
+			desc.myIsHeadless = true;
+			continue;
+		}
+
+		if (arg == "--stats")
+		{
+			desc.myIsStatisticsEnabled = true;
+			continue;
+		}
+
+		if (i + 1 >= argc)
+		{
+			std::cerr << "Benchmark: missing value for " << arg << "\n";
+			return false;
+		}
+
+		const std::string value = argv[++i];
+		if (arg == "--scene") desc.myScene = value;
+		else if (arg == "--vert") desc.myVertexShader = value;
+		else if (arg == "--frag") desc.myFragmentShader = value;
+		else if (arg == "--path") desc.myCameraPath = value;
+		else if (arg == "--record") desc.myRecordPath = value;
+		else if (arg == "--out") desc.myOutput = value;
+		else if (arg == "--trace") desc.myTracePath = value;
+		else if (arg == "--vma") desc.myVmaStatsPath = value;
+		else if (arg == "--frames") desc.myFrames = std::max(static_cast<uint32_t>(std::stoul(value)), 1u);
+		else if (arg == "--warmup") desc.myWarmupFrames = static_cast<uint32_t>(std::stoul(value));
+		else if (arg == "--width") desc.mySize.x = static_cast<uint32_t>(std::stoul(value));
+		else if (arg == "--height") desc.mySize.y = static_cast<uint32_t>(std::stoul(value));
+		else
+		{
+			std::cerr << "Benchmark: unknown argument " << arg << "\n";
+			return false;
+		}
+	}
+
+	if (desc.myIsHeadless && !desc.myRecordPath.empty())
+	{
+		std::cerr << "Benchmark: --record needs a window\n";
+		return false;
+	}
+
+	return true;
+}
+
+static bool locLoadCameraPath(const std::string& filePath, std::vector<CameraKey>& outKeys)
+{
+	std::ifstream file(filePath);
+	if (!file.is_open())
+		return false;
+
+	std::string line;
+	while (std::getline(file, line))
+	{
+		if (line.empty() || line[0] == '#')
+			continue;
+
+		CameraKey key{};
+		std::istringstream stream(line);
+		if (stream >> key.myPosition.x >> key.myPosition.y >> key.myPosition.z >> key.myPitch >> key.myYaw)
+			outKeys.push_back(key);
+	}
+
+	return !outKeys.empty();
+}
+
+static bool locSaveCameraPath(const std::string& filePath, const std::vector<CameraKey>& keys)
+{
+	std::ofstream file(filePath);
+	if (!file.is_open())
+		return false;
+
+	file << "# x y z pitch yaw\n";
+	for (const CameraKey& key : keys)
+		file << std::format("{} {} {} {} {}\n", key.myPosition.x, key.myPosition.y, key.myPosition.z, key.myPitch, key.myYaw);
+
+	return true;
+}
+
+// One turn around the bounds of the root mesh, looking at its center
+static std::vector<CameraKey> locOrbitPath(Gfx_Mesh* mesh)
+{
+	const uint32_t keyCount = 16;
+	const Gfx_BoundingBox& aabb = mesh->GetAABB();
+	const glm::vec3 center = (aabb.MinPoint() + aabb.MaxPoint()) * 0.5f;
+	const float radius = std::max(glm::length(aabb.MaxPoint() - aabb.MinPoint()), 1.0f) * 1.5f;
+	const float height = radius * 0.5f;
+
+	std::vector<CameraKey> keys(keyCount + 1);
+	for (uint32_t i = 0; i <= keyCount; ++i)
+	{
+		const float angle = glm::two_pi<float>() * i / keyCount;
+
+		CameraKey& key = keys[i];
+		key.myPosition = center + glm::vec3(radius * std::sin(angle), height, radius * std::cos(angle));
+		key.myPitch = std::atan2(height, radius);
+		key.myYaw = -angle;
+	}
+
+	return keys;
+}
+
+static CameraKey locSamplePath(const std::vector<CameraKey>& keys, float t)
+{
+	if (keys.size() == 1)
+		return keys[0];
+
+	const float position = std::clamp(t, 0.0f, 1.0f) * (keys.size() - 1);
+	const size_t index = std::min(static_cast<size_t>(position), keys.size() - 2);
+	const float alpha = position - index;
+
+	const CameraKey& a = keys[index];
+	const CameraKey& b = keys[index + 1];
+
+	CameraKey key{};
+	key.myPosition = glm::mix(a.myPosition, b.myPosition, alpha);
+	key.myPitch = glm::mix(a.myPitch, b.myPitch, alpha);
+	key.myYaw = glm::mix(a.myYaw, b.myYaw, alpha);
+	return key;
+}
+
+// Nearest rank
+static Percentiles locGetPercentiles(std::vector<double> samples)
+{
+	Percentiles result{};
+	if (samples.empty())
+		return result;
+
+	std::sort(samples.begin(), samples.end());
+
+	auto rank = [&samples](double percentile)
+	{
+		const size_t index = static_cast<size_t>(std::ceil(percentile / 100.0 * samples.size()));
+		return samples[std::clamp<size_t>(index, 1, samples.size()) - 1];
+	};
+
+	result.myMin = samples.front();
+	result.myMax = samples.back();
+	result.myMean = std::accumulate(samples.begin(), samples.end(), 0.0) / samples.size();
+	result.myP50 = rank(50.0);
+	result.myP90 = rank(90.0);
+	result.myP95 = rank(95.0);
+	result.myP99 = rank(99.0);
+	return result;
+}
+
+static std::string locToJson(const Percentiles& p)
+{
+	return std::format("{{ \"min\": {:.4f}, \"max\": {:.4f}, \"mean\": {:.4f}, \"p50\": {:.4f}, \"p90\": {:.4f}, \"p95\": {:.4f}, \"p99\": {:.4f} }}",
+		p.myMin, p.myMax, p.myMean, p.myP50, p.myP90, p.myP95, p.myP99);
+}
+
+static std::string locEscape(const std::string& str)
+{
+	std::string result;
+	for (const char c : str)
+	{
+		if (c == '\\' || c == '"')
+			result += '\\';
+
+		result += c;
+	}
+
+	return result;
+}
+
+int main(int argc, char** argv)
+{
+	BenchmarkDesc desc{};
+	if (!locParseArgs(argc, argv, desc))
+		return EXIT_FAILURE;
+
+	Gfx_Log::SetCallback([](const std::string& msg, Gfx_Log::Level level)
+	{
+		if (level != Gfx_Log::Level::Info)
+			std::cerr << msg << "\n";
+	});
+
+	if (!desc.myTracePath.empty())
+		Gfx_CpuProfiler::Start();
+
+	// Declared before every resource so that all of them are released before the device is torn down
+	std::unique_ptr<Gfx_App> context = std::make_unique<Gfx_App>();
+	{
+		WindowCreateDesc winDesc{};
+		winDesc.myTitle = "Benchmark";
+		winDesc.myWidth = desc.mySize.x;
+		winDesc.myHeight = desc.mySize.y;
+
+		GfxContextCreateDesc contextDesc{};
+		contextDesc.myWindowDesc = desc.myIsHeadless ? nullptr : &winDesc;
+		contextDesc.myFeaturesFlags = FeaturesFlags::RendererEnable;
+		contextDesc.myIsHeadless = desc.myIsHeadless;
+		contextDesc.myHeadlessSize = desc.mySize;
+
+		context->Create(&contextDesc);
+	}
+
+	Gfx_RenderContext* renderContext = Gfx_RenderContext::s_Instance;
+	Ref<Gfx_Mesh> scene = Gfx_RenderContext::CreateMesh(desc.myScene, TransformDesc{});
+	if (scene->GetScene().empty())
+	{
+		std::cerr << "Benchmark: failed to load " << desc.myScene << "\n";
+		return EXIT_FAILURE;
+	}
+
+	Ref<Gfx_RenderPass> forwardPass = std::make_shared<Gfx_RenderPass>();
+	{
+		ShaderCreateDesc shaderDesc{};
+		shaderDesc.myStages = { { ShaderStage::Vertex, desc.myVertexShader }, { ShaderStage::Fragment, desc.myFragmentShader } };
+		forwardPass->myShader = Gfx_RenderContext::CreateShader(shaderDesc);
+
+		GraphicsPipelineCreateDesc pipelineDesc{};
+		pipelineDesc.myShader = forwardPass->myShader;
+		pipelineDesc.myFramebuffer = context->GetFramebuffer();
+		pipelineDesc.myName = "forward";
+		pipelineDesc.myVertexInput =
+		{
+			{
+				Gfx_BufferElement(Format::R32G32B32_SFLOAT, "aPos"),
+				Gfx_BufferElement(Format::R32G32B32_SFLOAT, "aNormal"),
+				Gfx_BufferElement(Format::R32G32B32A32_SFLOAT, "aTangent"),
+				Gfx_BufferElement(Format::R32G32_SFLOAT, "aUV"),
+				Gfx_BufferElement(Format::R32G32B32A32_SINT, "aJointIndices"),
+				Gfx_BufferElement(Format::R32G32B32A32_SFLOAT, "aJointWeight")
+			}
+		};
+
+		forwardPass->myPipeline = Gfx_RenderContext::CreateGraphicsPipeline(pipelineDesc);
+		forwardPass->myRenderTarget = context->GetFramebuffer();
+		forwardPass->myName = "forward";
+	}
+
+	EditorCameraCreateDesc cameraDesc{};
+	cameraDesc.myWidth = desc.mySize.x;
+	cameraDesc.myHeight = desc.mySize.y;
+	cameraDesc.myPos = glm::vec3(0, 2, 4);
+	cameraDesc.myPitch = 0.5f;
+	Gfx_EditorCamera camera = Gfx_EditorCamera(&cameraDesc);
+
+	context->SetEventCallback([&camera](Gfx_Event& event)
+	{
+		camera.OnEvent(event);
+	});
+
+	const bool isRecording = !desc.myRecordPath.empty();
+	std::vector<CameraKey> path;
+	if (!isRecording)
+	{
+		if (desc.myCameraPath.empty())
+			path = locOrbitPath(scene.get());
+		else if (!locLoadCameraPath(desc.myCameraPath, path))
+		{
+			std::cerr << "Benchmark: failed to load camera path " << desc.myCameraPath << "\n";
+			return EXIT_FAILURE;
+		}
+	}
+
+	// Passes are timed by the GPU profiler, which resolves a frame once its frame index comes around again
+	Gfx_GpuProfiler& profiler = Gfx_RenderContext::GetGpuProfiler();
+	if (!profiler.IsGood())
+		std::cerr << "Benchmark: timestamps are not supported, GPU times are skipped\n";
+
+	Gfx_QueryManager& queries = Gfx_RenderContext::GetQueryManager();
+	queries.SetStatisticsEnabled(desc.myIsStatisticsEnabled);
+	if (desc.myIsStatisticsEnabled && !queries.IsStatisticsSupported())
+		std::cerr << "Benchmark: pipeline statistics are not supported, --stats is ignored\n";
+
+	std::map<std::string, std::vector<double>> gpuTimes;
+	uint64_t firstMeasuredFrame = UINT64_MAX;
+	uint64_t lastResolvedFrame = 0;
+
+	std::vector<double> frameTimes;
+	std::vector<double> cpuTimes;
+	std::vector<double> allocations;
+	VkDeviceSize peakDeviceUsage = 0;
+	VkDeviceSize deviceBudget = 0;
+	frameTimes.reserve(desc.myFrames);
+	cpuTimes.reserve(desc.myFrames);
+	allocations.reserve(desc.myFrames);
+
+	using Clock = std::chrono::steady_clock;
+	auto toMs = [](Clock::duration duration) { return std::chrono::duration<double, std::milli>(duration).count(); };
+
+	const uint32_t totalFrames = isRecording ? UINT32_MAX : desc.myWarmupFrames + desc.myFrames;
+	for (uint32_t frame = 0; frame < totalFrames && context->IsOpen(); ++frame)
+	{
+		context->ProcessEvents();
+
+		if (context->IsWindowMinimized())
+			continue;
+
+		const bool isMeasured = !isRecording && frame >= desc.myWarmupFrames;
+		float deltaTime = context->CalculateDeltaTime();
+
+		if (isRecording)
+		{
+			camera.OnUpdate(deltaTime);
+			if (frame % s_RecordInterval == 0)
+				path.push_back({ camera.GetPosition(), camera.GetPitch(), camera.GetYaw() });
+		}
+		else
+		{
+			const float t = isMeasured ? float(frame - desc.myWarmupFrames) / std::max(desc.myFrames - 1, 1u) : 0.0f;
+			const CameraKey key = locSamplePath(path, t);
+			camera.SetPose(key.myPosition, key.myPitch, key.myYaw);
+		}
+
+		const uint64_t allocationCount = Gfx_VulkanAllocator::GetAllocationCount();
+		const Clock::time_point frameStart = Clock::now();
+
+		context->BeginFrame(deltaTime);
+		{
+			if (isMeasured && firstMeasuredFrame == UINT64_MAX)
+				firstMeasuredFrame = profiler.GetFrameCount();
+
+			const GpuFrameResult& gpuFrame = profiler.GetLastFrame();
+			if (gpuFrame.myFrame >= firstMeasuredFrame && gpuFrame.myFrame != lastResolvedFrame)
+			{
+				for (const GpuScopeResult& scope : gpuFrame.myScopes)
+					gpuTimes[scope.myName].push_back(scope.myTime);
+
+				lastResolvedFrame = gpuFrame.myFrame;
+			}
+
+			// The app owns the frame command buffer
+			forwardPass->myCmd = Ref<Gfx_CmdBuffer>(Gfx_App::GetCommandBuffer(), [](Gfx_CmdBuffer*) {});
+
+			renderContext->CmdBeginRenderPass(forwardPass);
+			renderContext->CmdBindPipeline(forwardPass);
+
+			PushConstant pc{ camera.GetViewMatrix(), camera.GetProjection() };
+			renderContext->CmdPushConstants(forwardPass, ShaderStage::Vertex, sizeof(PushConstant), &pc);
+
+			for (const Ref<Gfx_Mesh>& mesh : scene->GetScene())
+				renderContext->CmdDrawMeshIndexed(forwardPass, mesh);
+
+			renderContext->CmdEndRenderPass(forwardPass);
+		}
+
+		const Clock::time_point submitStart = Clock::now();
+		context->SwapBuffers();
+		const Clock::time_point frameEnd = Clock::now();
+
+		if (isMeasured)
+		{
+			frameTimes.push_back(toMs(frameEnd - frameStart));
+			cpuTimes.push_back(toMs(submitStart - frameStart));
+			allocations.push_back(static_cast<double>(Gfx_VulkanAllocator::GetAllocationCount() - allocationCount));
+
+			VkDeviceSize deviceUsage = 0;
+			Gfx_VulkanAllocator::GetDeviceLocalBudget(deviceUsage, deviceBudget);
+			peakDeviceUsage = std::max(peakDeviceUsage, deviceUsage);
+		}
+	}
+
+	if (!desc.myTracePath.empty())
+	{
+		Gfx_CpuProfiler::Stop();
+		Gfx_CpuProfiler::Export(desc.myTracePath);
+	}
+
+	if (isRecording)
+	{
+		if (!locSaveCameraPath(desc.myRecordPath, path))
+		{
+			std::cerr << "Benchmark: failed to write " << desc.myRecordPath << "\n";
+			return EXIT_FAILURE;
+		}
+
+		std::cout << "Benchmark: recorded " << path.size() << " keys to " << desc.myRecordPath << "\n";
+		return EXIT_SUCCESS;
+	}
+
+	const Percentiles framePercentiles = locGetPercentiles(frameTimes);
+	const Percentiles cpuPercentiles = locGetPercentiles(cpuTimes);
+	const Percentiles allocationPercentiles = locGetPercentiles(allocations);
+
+	std::ofstream output(desc.myOutput);
+	if (!output.is_open())
+	{
+		std::cerr << "Benchmark: failed to write " << desc.myOutput << "\n";
+		return EXIT_FAILURE;
+	}
+
+	output << "{\n";
+	output << std::format("\t\"scene\": \"{}\",\n", locEscape(desc.myScene));
+	output << std::format("\t\"path\": \"{}\",\n", locEscape(desc.myCameraPath.empty() ? "orbit" : desc.myCameraPath));
+	output << std::format("\t\"device\": \"{}\",\n", locEscape(Gfx_App::GetDevice().GetDeviceProperties()->deviceName));
+	output << std::format("\t\"headless\": {},\n", desc.myIsHeadless);
+	output << std::format("\t\"resolution\": [{}, {}],\n", desc.mySize.x, desc.mySize.y);
+	output << std::format("\t\"frames\": {},\n", frameTimes.size());
+	output << std::format("\t\"warmup_frames\": {},\n", desc.myWarmupFrames);
+	output << std::format("\t\"frame_ms\": {},\n", locToJson(framePercentiles));
+	output << std::format("\t\"cpu_ms\": {},\n", locToJson(cpuPercentiles));
+	output << "\t\"gpu_ms\": {";
+	for (auto it = gpuTimes.begin(); it != gpuTimes.end(); ++it)
+		output << std::format("{}\n\t\t\"{}\": {}", it == gpuTimes.begin() ? "" : ",", locEscape(it->first), locToJson(locGetPercentiles(it->second)));
+	output << (gpuTimes.empty() ? "},\n" : "\n\t},\n");
+	output << std::format("\t\"allocations_per_frame\": {},\n", locToJson(allocationPercentiles));
+
+	const char* categoryNames[] = { "buffers", "images", "acceleration_structures", "staging" };
+	output << std::format("\t\"memory\": {{ \"device_local_peak_mb\": {:.2f}, \"device_local_budget_mb\": {:.2f}",
+		peakDeviceUsage / 1048576.0, deviceBudget / 1048576.0);
+	for (uint32_t i = 0; i < static_cast<uint32_t>(MemoryCategory::Count); ++i)
+	{
+		const MemoryCategoryStats stats = Gfx_VulkanAllocator::GetCategoryStats(static_cast<MemoryCategory>(i));
+		output << std::format(", \"{}\": {{ \"count\": {}, \"mb\": {:.2f} }}", categoryNames[i], stats.myCount, stats.myBytes / 1048576.0);
+	}
+	output << " }";
+
+	const std::map<std::string, PipelineStatistics> statistics(queries.GetAllStatistics().begin(), queries.GetAllStatistics().end());
+	if (!statistics.empty())
+	{
+		output << ",\n\t\"pipeline_statistics\": {";
+		for (auto it = statistics.begin(); it != statistics.end(); ++it)
+		{
+			const PipelineStatistics& stats = it->second;
+			output << std::format("{}\n\t\t\"{}\": {{ \"input_vertices\": {}, \"input_primitives\": {}, \"vertex_invocations\": {}, \"clipping_invocations\": {}, "
+				"\"clipping_primitives\": {}, \"fragment_invocations\": {}, \"compute_invocations\": {} }}", it == statistics.begin() ? "" : ",",
+				locEscape(it->first), stats.myInputVertices, stats.myInputPrimitives, stats.myVertexInvocations, stats.myClippingInvocations,
+				stats.myClippingPrimitives, stats.myFragmentInvocations, stats.myComputeInvocations);
+		}
+		output << "\n\t}";
+	}
+
+	output << "\n";
+	output << "}\n";
+
+	if (!desc.myVmaStatsPath.empty())
+		Gfx_VulkanAllocator::DumpStats(desc.myVmaStatsPath, true);
+
+	std::cout << std::format("Benchmark: {} frames, frame p50 {:.3f} ms, p99 {:.3f} ms, written to {}\n",
+		frameTimes.size(), framePercentiles.myP50, framePercentiles.myP99, desc.myOutput);
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,29 @@
+#include "Common/Gfx_TextureStreamer.h"
+
+#include <iostream>
+
+using namespace SmolEngine;
+
+// Checks how shader feedback maps to the levels the streamer keeps resident, runs without a device
+//
+// Streamer Test  (exits with EXIT_FAILURE if any check fails)
+
+static bool Check(bool condition, const char* what)
+{
+	std::cout << (condition ? "[PASS] " : "[FAIL] ") << what << "\n";
+	return condition;
+}
+
+int main()
+{
+	bool ok = true;
+
+	// Resident from mip 4 with the tail at mip 8, LODs are relative to the resident image
+	ok &= Check(Gfx_TextureStreamer::GetRequestedMip(4, s_StreamerLodBias - 2, 8) == 2, "negative LOD upgrades to a finer mip");
+	ok &= Check(Gfx_TextureStreamer::GetRequestedMip(4, s_StreamerLodBias, 8) == 4, "LOD 0 keeps the resident mip");
+	ok &= Check(Gfx_TextureStreamer::GetRequestedMip(4, s_StreamerLodBias + 1, 8) == 5, "positive LOD asks for a coarser mip");
+	ok &= Check(Gfx_TextureStreamer::GetRequestedMip(1, 0, 8) == 0, "magnification is clamped to the full resolution mip");
+	ok &= Check(Gfx_TextureStreamer::GetRequestedMip(4, s_StreamerLodBias + 10, 8) == 8, "minification is clamped to the tail");
+
+	return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}